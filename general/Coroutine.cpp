@@ -0,0 +1,52 @@
+#include "Coroutine.h"
+
+#include <new>
+
+namespace
+{
+    const std::size_t granularity = 64;
+    const std::size_t sizeClasses = 16; // pooled frames are up to granularity * sizeClasses bytes
+
+    struct FreeFrame
+    {
+        FreeFrame *next;
+    };
+
+    thread_local FreeFrame *freeFrames[sizeClasses] = {};
+
+    std::size_t sizeClass(std::size_t a_size)
+    {
+        return (a_size + granularity - 1) / granularity - 1;
+    }
+}
+
+void * CoroutinePool::allocate(std::size_t a_size)
+{
+    std::size_t index = sizeClass(a_size);
+
+    if ( index >= sizeClasses )
+        return ::operator new(a_size);
+
+    if ( FreeFrame *frame = freeFrames[index] )
+    {
+        freeFrames[index] = frame->next;
+        return frame;
+    }
+
+    return ::operator new((index + 1) * granularity);
+}
+
+void CoroutinePool::deallocate(void *a_frame, std::size_t a_size)
+{
+    std::size_t index = sizeClass(a_size);
+
+    if ( index >= sizeClasses )
+    {
+        ::operator delete(a_frame);
+        return;
+    }
+
+    FreeFrame *frame = (FreeFrame*)a_frame;
+    frame->next = freeFrames[index];
+    freeFrames[index] = frame;
+}
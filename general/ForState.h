@@ -19,6 +19,7 @@ class ForState
         {
             if ( m_value != m_end )
             {
+                TRACE_SCOPE("ForState::update");
                 m_update(m_value);
                 m_value++;
             }
@@ -28,7 +29,10 @@ class ForState
                 // Do we maybe want to move the callback into the cleanup method?
                 // If we do, and this object gets cleaned up prematurely, then the callback gets called...
                 // not sure if this is desirable.
-                m_callback();
+                {
+                    TRACE_SCOPE("ForState::callback");
+                    m_callback();
+                }
                 // cleanup sets the status to finished, which will cause the forstate to be cleaned up
                 // by the parent.
                 cleanup(); 
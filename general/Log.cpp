@@ -0,0 +1,273 @@
+#include "Log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace logging
+{
+    namespace
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        const std::size_t queueSize = 256;     // a power of two
+        const std::size_t messageLength = 240; // longer messages are cut short
+
+        const std::int64_t windowLength = 1000; // ms, for rate limits and repeats
+        const std::chrono::milliseconds idleWait(20);
+
+        const char *const levelNames[] = { "debug", "info", "warning", "error" };
+
+        // A bounded queue that many threads push to and one thread pops from, after Dmitry Vyukov's:
+        // each slot's sequence number says whether it is free for the push at that position, or
+        // holds the message for the pop at that position.
+        struct Slot
+        {
+            std::atomic<std::size_t> sequence;
+            Level level;
+            char text[messageLength];
+        };
+
+        class Logger final
+        {
+            public:
+                Logger()
+                    : m_pushPosition(0), m_popPosition(0), m_dropped(0), m_sites(nullptr),
+                      m_flushRequested(0), m_flushed(0), m_stopping(false), m_start(Clock::now()),
+                      m_lastLevel(Level::debug), m_repeats(0), m_lastRepeat(0)
+                {
+                    for ( std::size_t i = 0; i < queueSize; i++ )
+                        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+
+                    m_last[0] = '\0';
+                    m_thread = std::thread(&Logger::run, this);
+                }
+
+                ~Logger()
+                {
+                    m_stopping.store(true, std::memory_order_release);
+                    m_wake.notify_one();
+                    m_thread.join();
+                }
+
+                std::int64_t now() const
+                {
+                    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_start).count();
+                }
+
+                // Formats a message into the next free slot; false if there is none.
+                bool push(Level a_level, const char *a_format, std::va_list a_arguments)
+                {
+                    std::size_t position = m_pushPosition.load(std::memory_order_relaxed);
+                    Slot *slot;
+
+                    for ( ;; )
+                    {
+                        slot = &m_slots[position & (queueSize - 1)];
+                        std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+
+                        if ( sequence == position )
+                        {
+                            if ( m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) )
+                                break;
+                        }
+                        else if ( sequence < position ) // still holds the message from a lap ago
+                        {
+                            m_dropped.fetch_add(1, std::memory_order_relaxed);
+                            return false;
+                        }
+                        else
+                            position = m_pushPosition.load(std::memory_order_relaxed);
+                    }
+
+                    slot->level = a_level;
+                    std::vsnprintf(slot->text, messageLength, a_format, a_arguments);
+                    slot->sequence.store(position + 1, std::memory_order_release);
+
+                    m_wake.notify_one(); // without the lock, so a wakeup may be missed; the writer also polls
+                    return true;
+                }
+
+                // Puts a_site on the list of sites whose suppressed messages the writer counts.
+                void list(Site & a_site, Level a_level, const char *a_format)
+                {
+                    if ( a_site.listed.exchange(true, std::memory_order_relaxed) )
+                        return;
+
+                    a_site.level = a_level;
+                    a_site.format = a_format;
+                    a_site.next = m_sites.load(std::memory_order_relaxed);
+                    while ( ! m_sites.compare_exchange_weak(a_site.next, &a_site, std::memory_order_release) )
+                        ;
+                }
+
+                void flush()
+                {
+                    std::uint64_t ticket = m_flushRequested.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+                    while ( m_flushed.load(std::memory_order_acquire) < ticket )
+                    {
+                        m_wake.notify_one();
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                }
+
+            private:
+                void run()
+                {
+                    for ( ;; )
+                    {
+                        // Read before draining, so that everything queued before either was asked
+                        // for is written.
+                        bool stopping = m_stopping.load(std::memory_order_acquire);
+                        std::uint64_t flushRequested = m_flushRequested.load(std::memory_order_acquire);
+                        bool everything = stopping || flushRequested > m_flushed.load(std::memory_order_relaxed);
+
+                        while ( pop() )
+                            ;
+
+                        std::int64_t time = now();
+
+                        if ( everything || time - m_lastRepeat >= windowLength )
+                            reportRepeats();
+                        reportSuppressed(time, everything);
+                        reportDropped();
+                        std::fflush(stderr);
+
+                        m_flushed.store(flushRequested, std::memory_order_release);
+
+                        if ( stopping )
+                            return;
+
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_wake.wait_for(lock, idleWait);
+                    }
+                }
+
+                bool pop()
+                {
+                    Slot & slot = m_slots[m_popPosition & (queueSize - 1)];
+
+                    if ( slot.sequence.load(std::memory_order_acquire) != m_popPosition + 1 )
+                        return false;
+
+                    if ( slot.level == m_lastLevel && std::strcmp(slot.text, m_last) == 0 )
+                    {
+                        if ( m_repeats++ == 0 )
+                            m_lastRepeat = now();
+                    }
+                    else
+                    {
+                        reportRepeats();
+
+                        std::fprintf(stderr, "[%s] %s\n", levelNames[(int)slot.level], slot.text);
+
+                        std::memcpy(m_last, slot.text, messageLength);
+                        m_lastLevel = slot.level;
+                    }
+
+                    slot.sequence.store(m_popPosition + queueSize, std::memory_order_release);
+                    m_popPosition++;
+                    return true;
+                }
+
+                void reportRepeats()
+                {
+                    if ( m_repeats > 0 )
+                        std::fprintf(stderr, "[%s] (the last message was repeated %u more times)\n",
+                                levelNames[(int)m_lastLevel], m_repeats);
+                    m_repeats = 0;
+                }
+
+                // Says how many messages each site has held back, at most once a second per site
+                // unless a_everything.
+                void reportSuppressed(std::int64_t a_time, bool a_everything)
+                {
+                    for ( Site *site = m_sites.load(std::memory_order_acquire); site != nullptr; site = site->next )
+                    {
+                        if ( ! a_everything && a_time - site->reported < windowLength )
+                            continue;
+
+                        unsigned int suppressed = site->suppressed.exchange(0, std::memory_order_relaxed);
+                        if ( suppressed == 0 )
+                            continue;
+
+                        site->reported = a_time;
+
+                        reportRepeats(); // they came before
+                        std::fprintf(stderr, "[%s] (%u more messages like \"%s\" were not logged)\n",
+                                levelNames[(int)site->level], suppressed, site->format);
+                        m_last[0] = '\0';
+                    }
+                }
+
+                void reportDropped()
+                {
+                    unsigned long dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+                    if ( dropped > 0 )
+                        std::fprintf(stderr, "[warning] %lu log messages were dropped, the log queue was full\n", dropped);
+                }
+
+                Slot m_slots[queueSize];
+                std::atomic<std::size_t> m_pushPosition;
+                std::size_t m_popPosition; // the writer's
+                std::atomic<unsigned long> m_dropped;
+                std::atomic<Site *> m_sites;
+
+                std::atomic<std::uint64_t> m_flushRequested, m_flushed;
+                std::atomic<bool> m_stopping;
+                std::mutex m_mutex; // only for m_wake
+                std::condition_variable m_wake;
+
+                Clock::time_point m_start;
+
+                // The writer's, to tell repeated messages.
+                char m_last[messageLength];
+                Level m_lastLevel;
+                unsigned int m_repeats;
+                std::int64_t m_lastRepeat; // when the first repeat came
+
+                std::thread m_thread; // last, so that it starts once everything else is constructed
+        };
+
+        // Started by the first message, stopped when the program exits.
+        Logger & logger()
+        {
+            static Logger instance;
+            return instance;
+        }
+    }
+
+    void write(Site & a_site, Level a_level, const char *a_format, ...)
+    {
+        Logger & log = logger();
+
+        // The first message in a new second starts a new window. Threads racing here may both
+        // reset it, which only lets a few more messages through.
+        std::int64_t now = log.now();
+        std::int64_t start = a_site.windowStart.load(std::memory_order_relaxed);
+        if ( now - start >= windowLength && a_site.windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed) )
+            a_site.inWindow.store(0, std::memory_order_relaxed);
+
+        if ( a_site.inWindow.fetch_add(1, std::memory_order_relaxed) >= burstLimit )
+        {
+            log.list(a_site, a_level, a_format);
+            a_site.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        std::va_list arguments;
+        va_start(arguments, a_format);
+        log.push(a_level, a_format, arguments);
+        va_end(arguments);
+    }
+
+    void flush()
+    {
+        logger().flush();
+    }
+}
@@ -1,6 +1,7 @@
 #ifndef MULTISTATE_H
 #define MULTISTATE_H
 
+#include <algorithm>
 #include <vector>
 
 #include "State.h"
@@ -15,57 +16,71 @@ class MultiState
         {
         }
 
+        ~MultiState()
+        {
+            liveChildren() -= m_children.size();
+        }
+
         void add(State_ptr a_child)
         {
             a_child->activate();
             m_children.push_back(a_child);
+            liveChildren()++;
         }
 
-        virtual void update() override
+        // The number of children held by all MultiStates together, for diagnostics.
+        static std::size_t getTotalChildren()
         {
-            bool nulls = false;
-
-            do
-            {
-                auto p = std::find(m_children.begin(), m_children.end(), nullptr);
-                nulls = p != m_children.end();
-                if (nulls) m_children.erase(p);
-            } while (nulls);
-
-            if ( m_children.size() == 0 )
-                return;
+            return liveChildren();
+        }
 
-            for ( unsigned int i = 0; i < m_children.size(); i++ )
+        virtual void update() override
+        {
+            // By index, and holding a copy, since a child's update may add children.
+            for ( std::size_t i = 0; i < m_children.size(); i++ )
             {
-                auto s = m_children[i];
-
-                if ( s == nullptr ) continue;
+                State_ptr s = m_children[i];
 
                 if ( s->getStatus() == AppState::running )
                     s->update();
                 else if ( s->getStatus() == AppState::finished )
                 {
+                    // As in State::update, a successor still loading in the background is
+                    // swapped in on a later frame, once it is ready.
+                    if ( s->getNextState() != nullptr && s->getNextState()->getStatus() == AppState::loading )
+                        continue;
+
                     s->cleanup();
                     s = s->getNextState();
 
                     if ( s != nullptr )
                         s->activate();
+
+                    m_children[i] = s;
                 }
             }
+
+            // Finished children without a successor are retired in one pass.
+            std::size_t before = m_children.size();
+            m_children.erase(std::remove(m_children.begin(), m_children.end(), nullptr), m_children.end());
+            liveChildren() -= before - m_children.size();
         }
 
-        virtual void draw(Surface_ptr a_parent) override
+        virtual void draw(Surface_ptr const& a_parent) override
         {
-            for ( auto i = m_children.begin(); i != m_children.end(); i++ )
-            {
-                m_child = *i;
-                State::draw(a_parent);
-            }
-            m_child = nullptr;
+            for ( auto &child : m_children )
+                if ( child->getStatus() == AppState::running )
+                    child->draw(a_parent);
         }
 
     private:
+        static std::size_t & liveChildren()
+        {
+            static std::size_t count = 0;
+            return count;
+        }
+
         std::vector<State_ptr> m_children;
 };
 
-#endif 
+#endif
@@ -0,0 +1,221 @@
+#include "Scheduler.h"
+
+Scheduler::Scheduler()
+    : m_free(none), m_nodes(0), m_now(0), m_pending(0)
+{
+    for ( unsigned int i = 0; i <= dueList; i++ )
+        m_heads[i] = m_tails[i] = none;
+}
+
+Scheduler::~Scheduler()
+{
+    clear();
+}
+
+void Scheduler::reserve(std::size_t a_count)
+{
+    while ( m_chunks.size() * chunkSize < a_count )
+        m_chunks.emplace_back(new Node[chunkSize]);
+}
+
+bool Scheduler::cancel(TimerHandle a_handle)
+{
+    if ( ! isPending(a_handle) )
+        return false;
+
+    unlink(a_handle.index);
+    release(a_handle.index);
+    return true;
+}
+
+bool Scheduler::isPending(TimerHandle a_handle) const
+{
+    if ( a_handle.generation == 0 || a_handle.index >= m_nodes )
+        return false;
+
+    Node const& n = node(a_handle.index);
+    return n.generation == a_handle.generation && n.list != none;
+}
+
+std::uint64_t Scheduler::getRemaining(TimerHandle a_handle) const
+{
+    if ( ! isPending(a_handle) )
+        return 0;
+
+    // Timers on the list being run are due now; they run in this call to tick, not the next.
+    Node const& n = node(a_handle.index);
+    return n.list == dueList ? 0 : n.expiry - m_now + 1;
+}
+
+void Scheduler::tick()
+{
+    unsigned int slot = m_now & (slotsPerLevel - 1);
+
+    // Whenever a level wraps around, the next slot of the level above is spread over it.
+    if ( slot == 0 )
+        for ( unsigned int level = 1; level < levels && cascade(level) == 0; level++ )
+            ;
+
+    // The slot is moved to a list of its own before anything runs, so that callbacks can schedule
+    // and cancel freely, including timers that are due now.
+    m_heads[dueList] = m_heads[slot];
+    m_tails[dueList] = m_tails[slot];
+    m_heads[slot] = m_tails[slot] = none;
+    for ( std::uint32_t i = m_heads[dueList]; i != none; i = node(i).next )
+        node(i).list = dueList;
+
+    m_now++;
+
+    while ( m_heads[dueList] != none )
+    {
+        std::uint32_t index = m_heads[dueList];
+        Node &n = node(index); // stays valid while the callback schedules more, see m_chunks
+
+        unlink(index);
+        n.invoke(&n.callback);
+        release(index);
+    }
+}
+
+void Scheduler::clear()
+{
+    for ( unsigned int list = 0; list <= dueList; list++ )
+    {
+        while ( m_heads[list] != none )
+        {
+            std::uint32_t index = m_heads[list];
+            unlink(index);
+            release(index);
+        }
+    }
+}
+
+std::size_t Scheduler::getPendingCount() const
+{
+    return m_pending;
+}
+
+std::size_t Scheduler::getTotalPending()
+{
+    return totalPending();
+}
+
+Scheduler::Node & Scheduler::node(std::uint32_t a_index)
+{
+    return m_chunks[a_index / chunkSize][a_index % chunkSize];
+}
+
+Scheduler::Node const& Scheduler::node(std::uint32_t a_index) const
+{
+    return m_chunks[a_index / chunkSize][a_index % chunkSize];
+}
+
+std::uint32_t Scheduler::allocate()
+{
+    std::uint32_t index;
+
+    if ( m_free != none )
+    {
+        index = m_free;
+        m_free = node(index).next;
+    }
+    else
+    {
+        if ( m_nodes == m_chunks.size() * chunkSize )
+            m_chunks.emplace_back(new Node[chunkSize]);
+
+        index = m_nodes++;
+        node(index).generation = 1;
+    }
+
+    node(index).list = none;
+    return index;
+}
+
+void Scheduler::release(std::uint32_t a_index)
+{
+    Node &n = node(a_index);
+
+    n.destroy(&n.callback);
+
+    // Bumping the generation is what invalidates the handles to this node.
+    if ( ++n.generation == 0 )
+        n.generation = 1;
+
+    n.list = none;
+    n.next = m_free;
+    m_free = a_index;
+
+    m_pending--;
+    totalPending()--;
+}
+
+void Scheduler::insert(std::uint32_t a_index)
+{
+    std::uint64_t delay = node(a_index).expiry - m_now;
+    unsigned int level = 0;
+
+    while ( level + 1 < levels && delay >= (std::uint64_t(1) << (levelBits * (level + 1))) )
+        level++;
+
+    unsigned int slot = (node(a_index).expiry >> (levelBits * level)) & (slotsPerLevel - 1);
+    pushBack(level * slotsPerLevel + slot, a_index);
+}
+
+void Scheduler::pushBack(std::uint32_t a_list, std::uint32_t a_index)
+{
+    Node &n = node(a_index);
+
+    n.list = a_list;
+    n.prev = m_tails[a_list];
+    n.next = none;
+
+    if ( m_tails[a_list] == none )
+        m_heads[a_list] = a_index;
+    else
+        node(m_tails[a_list]).next = a_index;
+
+    m_tails[a_list] = a_index;
+}
+
+void Scheduler::unlink(std::uint32_t a_index)
+{
+    Node &n = node(a_index);
+
+    if ( n.prev == none )
+        m_heads[n.list] = n.next;
+    else
+        node(n.prev).next = n.next;
+
+    if ( n.next == none )
+        m_tails[n.list] = n.prev;
+    else
+        node(n.next).prev = n.prev;
+
+    n.list = none;
+}
+
+unsigned int Scheduler::cascade(unsigned int a_level)
+{
+    unsigned int slot = (m_now >> (levelBits * a_level)) & (slotsPerLevel - 1);
+    std::uint32_t list = a_level * slotsPerLevel + slot;
+
+    // Taken off the slot first, since a timer may land in the same slot again.
+    std::uint32_t index = m_heads[list];
+    m_heads[list] = m_tails[list] = none;
+
+    while ( index != none )
+    {
+        std::uint32_t next = node(index).next;
+        insert(index);
+        index = next;
+    }
+
+    return slot;
+}
+
+std::size_t & Scheduler::totalPending()
+{
+    thread_local std::size_t count = 0;
+    return count;
+}
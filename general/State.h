@@ -1,9 +1,11 @@
 #ifndef STATE_H
 #define STATE_H
 
+#include <atomic>
 #include <memory>
 
 #include "util_SDL.h"
+#include "Trace.h"
 
 /** Defines the basic interface of all application states.
  */
@@ -20,19 +22,24 @@ enum class AppState
     paused,   // paused state's update method is generally just skipped
     finished, // state should be cleaned up
     notReady,
+    loading,  // being loaded on another thread by a StateLoader; becomes ready when done
     ready
 };
 
 class State
 {
+    friend class StateLoader;
+
     public:
         State (const State *a_parent);
 
         virtual void update ();
-        virtual void draw (Surface_ptr a_parent);
+        virtual void draw (Surface_ptr const& a_parent);
         virtual void load ();
         virtual void cleanup ();
-        virtual void handleEvent (SDL_Event const& event);
+        // a_time is the SDL_GetTicks() value at which the event was polled, so that states can
+        // order and time input more finely than once per frame.
+        virtual void handleEvent (SDL_Event const& event, Uint32 a_time);
 
         virtual void activate ();
 
@@ -48,7 +55,9 @@ class State
         State_ptr m_child, m_next; // before becoming finished, this state must provide a value for next
         // as the parent state must replace its child with its child's next state.
         
-        AppState m_status;
+        // Atomic, because a StateLoader may load a state on another thread: the loading thread's
+        // final store of `ready` is what publishes everything the load did.
+        std::atomic<AppState> m_status;
 };
 
 #endif
@@ -0,0 +1,48 @@
+#ifndef STATELOADER_H
+#define STATELOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "State.h"
+
+/** Loads states on a background thread, so that a state can prepare its likely successor while it
+ * runs instead of loading it synchronously during the transition.
+ *
+ * A prewarmed state is `loading` until the worker is done with it and `ready` afterwards; State's
+ * update waits for that before swapping it in. Loads must therefore be safe to run off the main
+ * thread: they may only create CPU-side (SDL_SWSURFACE) surfaces, and must get fonts and text from
+ * the (locked) ResourceCache rather than call SDL_ttf directly.
+ */
+class StateLoader final
+{
+    public:
+        StateLoader();
+        ~StateLoader();
+
+        StateLoader(StateLoader const&) = delete;
+        StateLoader & operator=(StateLoader const&) = delete;
+
+        /** Queues a_state, which must be notReady, to be loaded in the background.
+         */
+        void prewarm(State_ptr a_state);
+
+        /** Finishes the load in progress, if any, drops the queued ones and stops the worker.
+         * Queued states go back to notReady, so they still load if they are activated later.
+         */
+        void stop();
+
+    private:
+        void work();
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::deque<State_ptr> m_queue;
+        bool m_stopping;
+
+        std::thread m_thread; // last, so that it starts once everything else is constructed
+};
+
+#endif
@@ -0,0 +1,169 @@
+#include "Trace.h"
+#include "Log.h"
+
+#ifdef ENABLE_TRACING
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace
+{
+    namespace
+    {
+        struct Event
+        {
+            const char *name, *argName;
+            long long arg;
+            Nanos start, end;
+        };
+
+        // Events are kept in fixed-size chunks, so that recording never moves what is already
+        // there and only allocates once per chunk.
+        struct ThreadBuffer
+        {
+            static const std::size_t chunkSize = 4096;
+
+            typedef std::array<Event, chunkSize> Chunk;
+
+            ThreadBuffer(unsigned int a_id)
+                : id(a_id), count(0)
+            {
+            }
+
+            void push(Event const& a_event)
+            {
+                std::size_t n = count.load(std::memory_order_relaxed);
+
+                if ( n / chunkSize == chunks.size() )
+                {
+                    std::lock_guard<std::mutex> lock(chunksMutex);
+                    chunks.emplace_back(new Chunk());
+                }
+
+                (*chunks[n / chunkSize])[n % chunkSize] = a_event;
+                count.store(n + 1, std::memory_order_release);
+            }
+
+            unsigned int id;
+            std::atomic<std::size_t> count;
+            std::mutex chunksMutex; // taken only when a chunk is added, or by flush
+            std::vector<std::unique_ptr<Chunk>> chunks;
+        };
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+            std::string outputPath = "trace.json";
+        };
+
+        Registry & registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        ThreadBuffer & threadBuffer()
+        {
+            thread_local ThreadBuffer *buffer = nullptr;
+
+            if ( buffer == nullptr )
+            {
+                Registry &r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+
+                r.buffers.emplace_back(new ThreadBuffer(r.buffers.size() + 1));
+                buffer = r.buffers.back().get();
+            }
+
+            return *buffer;
+        }
+
+        void writeString(std::ostream & a_out, const char *a_s)
+        {
+            a_out << '"';
+            for ( ; *a_s != '\0'; a_s++ )
+            {
+                if ( *a_s == '"' || *a_s == '\\' )
+                    a_out << '\\';
+                a_out << *a_s;
+            }
+            a_out << '"';
+        }
+    }
+
+    Nanos now()
+    {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void record(const char *a_name, Nanos a_start, Nanos a_end, const char *a_argName, long long a_arg)
+    {
+        threadBuffer().push(Event { a_name, a_argName, a_arg, a_start, a_end });
+    }
+
+    void setOutputPath(std::string const& a_path)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.outputPath = a_path;
+    }
+
+    bool flush()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        std::ofstream out(r.outputPath);
+
+        if ( ! out )
+        {
+            LOG_ERROR("Failed to open %s for the trace", r.outputPath.c_str());
+            return false;
+        }
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        bool first = true;
+        out.setf(std::ios::fixed);
+        out.precision(3);
+
+        for ( auto &buffer : r.buffers )
+        {
+            std::lock_guard<std::mutex> chunksLock(buffer->chunksMutex);
+            std::size_t count = buffer->count.load(std::memory_order_acquire);
+
+            for ( std::size_t i = 0; i < count; i++ )
+            {
+                Event const& e = (*buffer->chunks[i / ThreadBuffer::chunkSize])[i % ThreadBuffer::chunkSize];
+
+                out << (first ? "\n" : ",\n") << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                    << ",\"ts\":" << e.start / 1000.0 << ",\"dur\":" << (e.end - e.start) / 1000.0
+                    << ",\"name\":";
+                writeString(out, e.name);
+
+                if ( e.argName != nullptr )
+                {
+                    out << ",\"args\":{";
+                    writeString(out, e.argName);
+                    out << ":" << e.arg << "}";
+                }
+
+                out << "}";
+                first = false;
+            }
+        }
+
+        out << "\n]}\n";
+
+        return (bool)out;
+    }
+}
+
+#endif
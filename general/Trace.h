@@ -0,0 +1,94 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/** Scoped trace points that produce a Chrome trace ("Trace Event Format") JSON file, which can be
+ * opened in chrome://tracing or ui.perfetto.dev.
+ *
+ * Tracing is compiled in only when ENABLE_TRACING is defined (`make TRACE=1`). Otherwise the macros
+ * below expand to nothing and the trace functions are empty inlines, so there is no overhead at all.
+ *
+ *     void Game::handleRows()
+ *     {
+ *         TRACE_SCOPE("Game::handleRows");
+ *         ...
+ *     }
+ *
+ * Every thread records into its own buffer; only registering a new thread takes a lock. The buffers
+ * are written out by trace::flush, which Application::run calls on exit.
+ */
+
+#include <string>
+
+#ifdef ENABLE_TRACING
+
+#include <cstdint>
+
+#define TRACE_CONCAT_(a, b) a ## b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// Traces the rest of the enclosing scope under `name`, which must be a string literal.
+#define TRACE_SCOPE(name) ::trace::Scope TRACE_CONCAT(traceScope, __LINE__) (name)
+
+// Same, attaching an integer argument shown in the trace viewer (e.g. the frame number).
+#define TRACE_SCOPE_ARG(name, argName, argValue) \
+    ::trace::Scope TRACE_CONCAT(traceScope, __LINE__) (name, argName, (long long)(argValue))
+
+namespace trace
+{
+    typedef std::uint64_t Nanos;
+
+    Nanos now();
+
+    // Appends a complete event to the calling thread's buffer.
+    void record(const char *a_name, Nanos a_start, Nanos a_end, const char *a_argName, long long a_arg);
+
+    class Scope final
+    {
+        public:
+            Scope(const char *a_name, const char *a_argName = nullptr, long long a_arg = 0)
+                : m_name(a_name), m_argName(a_argName), m_arg(a_arg), m_start(now())
+            {
+            }
+
+            ~Scope()
+            {
+                record(m_name, m_start, now(), m_argName, m_arg);
+            }
+
+            Scope(Scope const&) = delete;
+            Scope & operator=(Scope const&) = delete;
+
+        private:
+            const char *m_name, *m_argName;
+            long long m_arg;
+            Nanos m_start;
+    };
+
+    // Where flush writes the trace. Defaults to "trace.json".
+    void setOutputPath(std::string const& a_path);
+
+    // Writes every thread's events recorded so far. Returns false if the file could not be written.
+    bool flush();
+}
+
+#else
+
+#define TRACE_SCOPE(name)
+// The argument is not evaluated, but still counts as a use of whatever it names.
+#define TRACE_SCOPE_ARG(name, argName, argValue) (void)sizeof(argValue)
+
+namespace trace
+{
+    inline void setOutputPath(std::string const&)
+    {
+    }
+
+    inline bool flush()
+    {
+        return true;
+    }
+}
+
+#endif
+
+#endif
@@ -49,4 +49,12 @@ Font_ptr makeSafeFontPtr(TTF_Font *font);
 Rect_ptr makeSafeRectPtr(short x, short y, unsigned short w, unsigned short h);
 
 SDL_Rect makeRect(short x, short y, unsigned short w, unsigned short h);
+
+/** SDL_BlitSurface, counted so that the number of blits per frame can be reported.
+ */
+int blitSurface(SDL_Surface *src, SDL_Rect *srcRect, SDL_Surface *dst, SDL_Rect *dstRect);
+
+/** The number of blits done through blitSurface since the program started.
+ */
+unsigned long getBlitCount();
 #endif
@@ -0,0 +1,81 @@
+#ifndef ALLOCACCOUNTING_H
+#define ALLOCACCOUNTING_H
+
+/** Allocation accounting by subsystem: every allocation made through operator new is charged to
+ * the tag of the innermost ALLOC_TAG scope on the calling thread, and the application prints the
+ * allocations per frame and the live and peak bytes of every tag on exit.
+ *
+ *     void Well::removeRows(...)
+ *     {
+ *         ALLOC_TAG(well);
+ *         ...
+ *     }
+ *
+ * Accounting is compiled in only when ENABLE_ALLOC_ACCOUNTING is defined (`make ALLOC_ACCOUNTING=1`),
+ * since it puts a small header in front of every allocation. Otherwise the macro expands to nothing
+ * and the functions are empty inlines.
+ *
+ * Only operator new is seen: SDL and SDL_ttf allocate with malloc, so the ttf tag covers what is
+ * allocated around them (fonts' and surfaces' handles, cache entries, atlases), not their own memory.
+ */
+
+#include <ostream>
+
+enum class AllocTag : unsigned char
+{
+    untagged,
+    well,
+    effects,   // the game's scheduled effects and coroutines
+    rendering, // everything done while drawing a frame
+    ttf,       // opening fonts and rendering text
+    count
+};
+
+#ifdef ENABLE_ALLOC_ACCOUNTING
+
+#define ALLOC_TAG_CONCAT_(a, b) a ## b
+#define ALLOC_TAG_CONCAT(a, b) ALLOC_TAG_CONCAT_(a, b)
+
+// Charges the allocations in the rest of the enclosing scope to AllocTag::tag.
+#define ALLOC_TAG(tag) ::allocAccounting::Scope ALLOC_TAG_CONCAT(allocTagScope, __LINE__) (::AllocTag::tag)
+
+namespace allocAccounting
+{
+    class Scope final
+    {
+        public:
+            explicit Scope(AllocTag a_tag);
+            ~Scope();
+
+            Scope(Scope const&) = delete;
+            Scope & operator=(Scope const&) = delete;
+
+        private:
+            AllocTag m_previous;
+    };
+
+    // A frame has ended; allocations per frame are measured between calls.
+    void frameEnded();
+
+    // Prints the totals of every tag.
+    void report(std::ostream & a_out);
+}
+
+#else
+
+#define ALLOC_TAG(tag)
+
+namespace allocAccounting
+{
+    inline void frameEnded()
+    {
+    }
+
+    inline void report(std::ostream &)
+    {
+    }
+}
+
+#endif
+
+#endif
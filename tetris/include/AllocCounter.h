@@ -0,0 +1,19 @@
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+#include <cstdint>
+
+// The global operator new and delete are replaced (in AllocCounter.cpp) by versions that count
+// calls, so that allocations per frame can be watched without a profiler. Counting is a relaxed
+// atomic increment; the allocation itself still goes to malloc.
+
+// The number of allocations made through operator new since the program started.
+std::uint64_t getAllocationCount();
+
+// The number of allocations made by the calling thread since it started.
+std::uint64_t getThreadAllocationCount();
+
+// The number of deallocations made through operator delete since the program started.
+std::uint64_t getDeallocationCount();
+
+#endif
@@ -9,9 +9,22 @@
 
 #include "util_SDL.h"
 
+#include "Instrumentation.h"
+#include "AllocCounter.h"
+#include "AllocAccounting.h"
+#include "FrameArena.h"
+#include "StartupProfile.h"
+#include "ResourceArchive.h"
+#include "ResourceCache.h"
+#include "StateLoader.h"
+#include "Telemetry.h"
+#include "HighScores.h"
+#include "PerfOverlay.h"
 #include "State.h"
 #include "MenuState.h"
 #include "Game.h"
+#include "VersusState.h"
+#include "SpectatorState.h"
 
 
 class Application final
@@ -26,6 +39,69 @@ class Application final
 
         std::weak_ptr<SDL_Surface> getScreen() const;
 
+        /** Reads resources from the archive file at a_path instead of the one built into the
+         * executable. Takes effect when the application loads.
+         */
+        void setResourceArchive(std::string const& a_path);
+
+        /** Where games are recorded to (see Replay), "replays" unless set. An empty path turns
+         * recording off.
+         */
+        void setReplayDirectory(std::string const& a_path);
+        std::string const& getReplayDirectory() const;
+
+        /** How often recorded games carry a checksum of the game's state, in ticks; 0 for never.
+         * Replay::defaultChecksumInterval unless set.
+         */
+        void setChecksumInterval(unsigned int a_ticks);
+        unsigned int getChecksumInterval() const;
+
+        /** How many boards a versus match from the menu has, the player's included; see
+         * VersusState.
+         */
+        void setVersusBoards(unsigned int a_boards);
+        unsigned int getVersusBoards() const;
+
+        /** Writes the events of every game played to the file at a_path (see Telemetry). Returns
+         * false if the file cannot be opened.
+         */
+        bool setTelemetryPath(std::string const& a_path);
+
+        /** Where games report their events, or nullptr if telemetry is off.
+         */
+        Telemetry * getTelemetry() const;
+
+        /** Every game finished, with their ranks; kept in "highscores.dat" unless set otherwise
+         * with getHighScores().setPath.
+         */
+        HighScores & getHighScores() const;
+
+        /** Starts with the replay in the file at a_path, played at a_speed times real time,
+         * instead of the menu. Returns false if the replay cannot be read.
+         */
+        bool playReplay(std::string const& a_path, double a_speed, std::uint64_t a_startTick = 0);
+
+        /** Starts with bots playing each other on a_boards boards to watch (see SpectatorState),
+         * instead of the menu.
+         */
+        void spectate(unsigned int a_boards);
+
+        /** Time to first frame, reported when enabled.
+         */
+        StartupProfile & getStartupProfile();
+
+        /** Input latency and frame time measurements, shared with the states.
+         */
+        Instrumentation & getInstrumentation() const;
+
+        /** Fonts and pre-rendered surfaces shared by all states.
+         */
+        ResourceCache & getResources() const;
+
+        /** Loads states in the background; see StateLoader.
+         */
+        StateLoader & getLoader() const;
+
         static const unsigned int screenHeight = 700;
         static const unsigned int screenWidth  = 950;
         static const unsigned int screenDepth  = 32;
@@ -33,7 +109,38 @@ class Application final
         static const unsigned int FRAMERATE = 60; // How many frames in one second?
         static const unsigned int FRAMETIME = 1000 / FRAMERATE; // How long is one frame? (in ms)
 
+        static const SDLKey overlayKey = SDLK_F3; // toggles the performance overlay
+
     private:
+        /** An event together with the SDL_GetTicks() value at which it was polled.
+         */
+        struct TimedEvent
+        {
+            SDL_Event event;
+            Uint32 time;
+            Instrumentation::Micros polled; // the same moment, with a finer clock
+        };
+
+        /** Moves the events waiting in SDL's queue into m_pendingEvents, stamping them with the
+         * current time. This is called repeatedly while idling at the end of a frame, so that the
+         * stamps stay close to when the input actually happened.
+         */
+        void pumpEvents ();
+
+        /** Waits until a_until (in SDL_GetTicks() time), pumping events in the meantime.
+         */
+        void idle (Uint32 a_until);
+
+#ifndef NDEBUG
+        /** Debug builds check that the frames in which nothing changes state do not allocate, once
+         * a state has been running for warmupFrames frames; allocations belong in load and activate,
+         * and per-frame scratch in the frame arena.
+         */
+        void checkSteadyFrame (unsigned long a_frame, std::uint64_t a_allocations);
+
+        static const unsigned int warmupFrames = 5;
+#endif
+
         /** Update the game state. Returns false when the game should exit.
          */
         void update () override;
@@ -49,13 +156,38 @@ class Application final
 
         /** Draws the current game state to the screen.
          */
-        void draw (Surface_ptr a_parent) override;
+        void draw (Surface_ptr const& a_parent) override;
 
         /** Represents the current state of the application.
          */
 //        AppState m_state;
 
+        StartupProfile m_startup; // first, so that it starts timing before everything else
+
         Screen_ptr m_screen;
+
+        std::unique_ptr<Instrumentation> m_instrumentation;
+        ResourceArchive m_archive; // before m_resources, whose fonts read from it
+        std::string m_archivePath;
+        std::string m_replayDirectory;
+        unsigned int m_checksumInterval;
+        unsigned int m_versusBoards;
+        std::unique_ptr<Telemetry> m_telemetry;
+        std::unique_ptr<HighScores> m_highScores;
+        std::unique_ptr<ResourceCache> m_resources;
+        std::unique_ptr<StateLoader> m_loader; // after m_resources, so that it stops before the cache goes
+
+        std::shared_ptr<PerfOverlay> m_overlay;
+        bool m_showOverlay;
+
+        /** Events polled since the last update, in the order they happened.
+         */
+        std::vector<TimedEvent> m_pendingEvents;
+
+#ifndef NDEBUG
+        unsigned int m_steadyFrames;      // frames since the last change of state
+        unsigned int m_allocationReports;
+#endif
 };
 
 #endif
@@ -0,0 +1,52 @@
+#ifndef AUTOSHIFT_H
+#define AUTOSHIFT_H
+
+#include <limits>
+
+// Tracks the horizontal direction keys and works out when a held key should start repeating
+// ("delayed auto shift", DAS) and how often it repeats afterwards ("auto repeat rate", ARR).
+// All times are in milliseconds, as given by SDL_GetTicks.
+class AutoShift final
+{
+    public:
+        // Reported by `poll` when the repeat rate is zero, meaning "shift as far as possible".
+        static const unsigned int instant = std::numeric_limits<unsigned int>::max();
+
+        AutoShift(unsigned int a_delay, unsigned int a_repeatRate);
+
+        // // // MUTATORS // // //
+
+        // A direction key (-1 for left, 1 for right) went down at a_time. The most recently pressed
+        // direction wins. The initial one-block shift is up to the caller.
+        void press(int a_direction, unsigned int a_time);
+
+        // A direction key went up at a_time. If the other direction is still held, it takes over and
+        // its delay starts again from a_time.
+        void release(int a_direction, unsigned int a_time);
+
+        // The number of repeated shifts that became due up to a_time and were not reported yet.
+        unsigned int poll(unsigned int a_time);
+
+        // Forgets about all held keys.
+        void reset();
+
+        // // // OBSERVERS // // //
+
+        // The direction currently being repeated, or 0 if none.
+        int getDirection() const;
+
+        unsigned int getDelay() const;
+        unsigned int getRepeatRate() const;
+
+    private:
+        bool & held(int a_direction);
+
+        unsigned int m_delay, m_repeatRate;
+
+        bool m_leftHeld, m_rightHeld;
+        int m_direction;
+        unsigned int m_pressTime; // when m_direction started being held
+        unsigned int m_repeats;   // how many repeats were already reported since m_pressTime
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "Simulation.h"
+
+// A computer player. When a piece appears it tries every rotation and column on a copy of the
+// well, scores the well each placement would leave, and then plays towards the best one, one
+// action per move: rotations first, then shifts, then a drop. Without SDL, so that matches
+// between bots can be played headlessly.
+class Bot final
+{
+    public:
+        // How much each feature of a well counts; the best placement has the highest sum.
+        struct Weights
+        {
+            double height;    // the sum of the columns' heights
+            double lines;     // the rows the placement completes
+            double holes;     // empty cells with a block above them
+            double bumpiness; // the sum of the height differences between neighbouring columns
+        };
+
+        // Weights that play a long, clean game.
+        static const Weights defaultWeights;
+
+        // a_moveTicks is how many ticks the bot waits between actions; 0 acts on every tick.
+        explicit Bot(Weights const& a_weights = defaultWeights, unsigned int a_moveTicks = 0);
+
+        // Makes the bot's next move in a_simulation, if it is time for one. Called once per tick,
+        // before the simulation ticks.
+        void play(Simulation & a_simulation);
+
+        // Forgets the plan for the piece falling, for a new game on the same simulation.
+        void reset();
+
+    private:
+        // Chooses where the falling piece goes.
+        void plan(StandardWell const& a_well);
+
+        // The score of the fallen blocks in a_well, once its full rows are removed.
+        double evaluate(StandardWell const& a_well) const;
+
+        // The leftmost column of a piece's blocks.
+        static unsigned int leftColumn(StandardWell::Piece const& a_piece);
+
+        Weights m_weights;
+        unsigned int m_moveTicks, m_wait;
+
+        bool m_planned;             // for the piece falling now
+        bool m_softDrop;            // turned on to make room to rotate
+        unsigned int m_rotations;   // clockwise rotations still to make
+        unsigned int m_targetColumn;
+};
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "Scheduler.h"
+
+/** Coroutine support for states, so that a sequence of timed steps can be written as one function:
+ *
+ *     Task Game::lockPiece()
+ *     {
+ *         co_await frames(15);
+ *         ...
+ *     }
+ *
+ *     m_lockScript = lockPiece();
+ *     m_lockScript.start(m_effects);
+ *
+ * A task is resumed by its scheduler's tick, so it advances with the state that ticks the
+ * scheduler. Coroutine frames come from a pool (see CoroutinePool), so starting a task does not
+ * allocate once the pool has warmed up.
+ *
+ * Destroying a task that is still waiting cancels its timer, so a state can drop its tasks at any
+ * time, except from inside the task itself. The scheduler must outlive the tasks started on it.
+ */
+
+/** Suspends a task for a number of scheduler ticks. frames(0) does not suspend.
+ */
+struct frames
+{
+    explicit frames(std::uint64_t a_count)
+        : count(a_count)
+    {
+    }
+
+    std::uint64_t count;
+};
+
+/** Recycles coroutine frames, by size class. The pools are per thread and never shrink.
+ */
+namespace CoroutinePool
+{
+    void * allocate(std::size_t a_size);
+    void deallocate(void *a_frame, std::size_t a_size);
+}
+
+class Task final
+{
+    public:
+        struct promise_type
+        {
+            Scheduler *scheduler = nullptr;
+            TimerHandle timer; // the tick the task is waiting for, if any
+
+            ~promise_type()
+            {
+                if ( scheduler != nullptr )
+                    scheduler->cancel(timer);
+            }
+
+            static void * operator new(std::size_t a_size)
+            {
+                return CoroutinePool::allocate(a_size);
+            }
+
+            static void operator delete(void *a_frame, std::size_t a_size)
+            {
+                CoroutinePool::deallocate(a_frame, a_size);
+            }
+
+            Task get_return_object()
+            {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            // Tasks only run once started on a scheduler, and stay around when done until the
+            // Task is destroyed, so that isDone can be asked.
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+
+            void return_void() {}
+            void unhandled_exception() { throw; }
+
+            struct FrameAwaiter
+            {
+                promise_type &promise;
+                std::uint64_t count;
+
+                bool await_ready() const noexcept
+                {
+                    return count == 0;
+                }
+
+                void await_suspend(std::coroutine_handle<promise_type> a_handle)
+                {
+                    promise.timer = promise.scheduler->schedule(count, [a_handle] () { a_handle.resume(); });
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            FrameAwaiter await_transform(frames a_frames)
+            {
+                return FrameAwaiter { *this, a_frames.count };
+            }
+        };
+
+        Task()
+        {
+        }
+
+        Task(Task && a_other)
+            : m_handle(std::exchange(a_other.m_handle, nullptr))
+        {
+        }
+
+        Task & operator=(Task && a_other)
+        {
+            if ( this != &a_other )
+            {
+                reset();
+                m_handle = std::exchange(a_other.m_handle, nullptr);
+            }
+            return *this;
+        }
+
+        ~Task()
+        {
+            reset();
+        }
+
+        /** Runs the task up to its first co_await, on a_scheduler's ticks from then on.
+         */
+        void start(Scheduler & a_scheduler)
+        {
+            if ( m_handle && m_handle.promise().scheduler == nullptr )
+            {
+                m_handle.promise().scheduler = &a_scheduler;
+                m_handle.resume();
+            }
+        }
+
+        bool isDone() const
+        {
+            return ! m_handle || m_handle.done();
+        }
+
+        /** The scheduler ticks left until the task resumes, as frames() counts them, or 0 if it is
+         * not waiting. Lets a state save a task's progress and start an equivalent task later.
+         */
+        std::uint64_t getPendingTicks() const
+        {
+            if ( ! m_handle || m_handle.promise().scheduler == nullptr )
+                return 0;
+
+            return m_handle.promise().scheduler->getRemaining(m_handle.promise().timer);
+        }
+
+        /** Destroys the task, wherever it is.
+         */
+        void reset()
+        {
+            if ( m_handle )
+                std::exchange(m_handle, nullptr).destroy();
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> a_handle)
+            : m_handle(a_handle)
+        {
+        }
+
+        std::coroutine_handle<promise_type> m_handle;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef FIXEDVECTOR_H
+#define FIXEDVECTOR_H
+
+#include <cassert>
+#include <cstddef>
+
+/** A vector with a fixed capacity, stored inline, for small temporaries that would otherwise be
+ * heap allocated on every copy, such as a piece's blocks. T must be default constructible.
+ */
+template<typename T, std::size_t Capacity>
+class FixedVector
+{
+    public:
+        typedef T value_type;
+        typedef T * iterator;
+        typedef T const* const_iterator;
+
+        FixedVector()
+            : m_size(0)
+        {
+        }
+
+        void push_back(T const& a_value)
+        {
+            assert(m_size < Capacity);
+            m_items[m_size++] = a_value;
+        }
+
+        void clear()
+        {
+            m_size = 0;
+        }
+
+        std::size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        bool full() const { return m_size == Capacity; }
+        static constexpr std::size_t capacity() { return Capacity; }
+
+        T & operator[](std::size_t a_index) { return m_items[a_index]; }
+        T const& operator[](std::size_t a_index) const { return m_items[a_index]; }
+
+        iterator begin() { return m_items; }
+        iterator end() { return m_items + m_size; }
+        const_iterator begin() const { return m_items; }
+        const_iterator end() const { return m_items + m_size; }
+
+        bool operator==(FixedVector const& a_other) const
+        {
+            if ( m_size != a_other.m_size )
+                return false;
+
+            for ( std::size_t i = 0; i < m_size; i++ )
+                if ( ! (m_items[i] == a_other.m_items[i]) )
+                    return false;
+
+            return true;
+        }
+
+        bool operator!=(FixedVector const& a_other) const
+        {
+            return ! (*this == a_other);
+        }
+
+    private:
+        T m_items[Capacity];
+        std::size_t m_size;
+};
+
+#endif
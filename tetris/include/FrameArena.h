@@ -0,0 +1,100 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/** A bump allocator for memory that only lives for one frame. Allocating is a pointer increment,
+ * freeing is a no-op, and everything is released at once by reset.
+ *
+ * Allocations that do not fit fall back to the heap until the next reset, which then grows the
+ * arena to the most that was used, so that later frames fit again.
+ */
+class FrameArena final
+{
+    public:
+        static const std::size_t defaultCapacity = 64 * 1024;
+
+        explicit FrameArena(std::size_t a_capacity = defaultCapacity);
+
+        FrameArena(FrameArena const&) = delete;
+        FrameArena & operator=(FrameArena const&) = delete;
+
+        void * allocate(std::size_t a_size, std::size_t a_alignment = alignof(std::max_align_t));
+
+        // Invalidates everything allocated since the last reset.
+        void reset();
+
+        std::size_t getUsed() const;
+        std::size_t getCapacity() const;
+        std::size_t getHighWater() const; // the most used in one frame so far
+
+    private:
+        std::unique_ptr<unsigned char[]> m_block;
+        std::size_t m_capacity, m_used, m_highWater;
+
+        std::size_t m_overflowBytes;
+        std::vector<std::unique_ptr<unsigned char[]>> m_overflow; // what did not fit, until reset
+};
+
+/** The calling thread's frame arena. The application resets the main thread's at the end of every
+ * update, so memory from it may be used until then: within an update, or from a draw through the
+ * following update. Other threads that run simulations reset their own.
+ */
+FrameArena & frameArena();
+
+/** A standard allocator that takes its memory from a FrameArena, for containers used as per-frame
+ * scratch, e.g. ArenaVector<int> rows(ArenaAllocator<int>(frameArena())).
+ */
+template<typename T>
+class ArenaAllocator
+{
+    public:
+        typedef T value_type;
+
+        explicit ArenaAllocator(FrameArena & a_arena)
+            : m_arena(&a_arena)
+        {
+        }
+
+        template<typename U>
+        ArenaAllocator(ArenaAllocator<U> const& a_other)
+            : m_arena(a_other.getArena())
+        {
+        }
+
+        T * allocate(std::size_t a_count)
+        {
+            return (T*)m_arena->allocate(a_count * sizeof(T), alignof(T));
+        }
+
+        void deallocate(T *, std::size_t)
+        {
+        }
+
+        FrameArena * getArena() const
+        {
+            return m_arena;
+        }
+
+        template<typename U>
+        bool operator==(ArenaAllocator<U> const& a_other) const
+        {
+            return m_arena == a_other.getArena();
+        }
+
+        template<typename U>
+        bool operator!=(ArenaAllocator<U> const& a_other) const
+        {
+            return m_arena != a_other.getArena();
+        }
+
+    private:
+        FrameArena *m_arena;
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -13,8 +13,14 @@
 #include "util_SDL.h"
 #include "GameOverState.h"
 #include "Well.h"
-#include "ForState.h"
-#include "MultiState.h"
+#include "Simulation.h"
+#include "Replay.h"
+#include "SimulationHistory.h"
+#include "Scheduler.h"
+#include "AutoShift.h"
+#include "GlyphAtlas.h"
+#include "FrameArena.h"
+#include "AllocAccounting.h"
 
 extern const char PIECES[7][4][5][5]; // Defined in TetrisData.cpp
 
@@ -30,22 +36,36 @@ class Game final
     : public State
 {
     public:
-        Game(const Application* a_owner, unsigned int a_initialSpeed);
+        // The auto shift delay and repeat rate are in milliseconds; see AutoShift.
+        Game(const Application* a_owner, unsigned int a_initialSpeed,
+             unsigned int a_autoShiftDelay = defaultAutoShiftDelay,
+             unsigned int a_autoRepeatRate = defaultAutoRepeatRate);
+
+        // Plays a recorded game instead of taking input, at a_speed times real time (for example
+        // 0.5 or 8). The left and right keys skip back and forward by seekStep ticks.
+        Game(const Application* a_owner, std::shared_ptr<Replay const> a_replay, double a_speed);
 
         virtual void load() override;
+        virtual void activate() override;
         virtual void cleanup() override;
+
+        // May be called while the game is being loaded in the background, but not once it runs.
+        void setInitialSpeed(unsigned int a_speed);
+
+        // Jumps to a_tick of the replay being played.
+        void seek(std::uint64_t a_tick);
         virtual void update() override;
-        virtual void handleEvent(SDL_Event const& event) override;
-        virtual void draw(Surface_ptr a_parent) override;
+        virtual void handleEvent(SDL_Event const& event, Uint32 a_time) override;
+        virtual void draw(Surface_ptr const& a_parent) override;
 
         unsigned int getScore()
         {
-            return m_score;
+            return m_simulation.getScore();
         }
 
         unsigned int getLevel()
         {
-            return m_speed;
+            return m_simulation.getLevel();
         }
 
         static const unsigned short wellWidth    = 10;
@@ -53,50 +73,79 @@ class Game final
         static const unsigned short blockSide    = 32;
         static const unsigned short pieceStartX  = 5;
         static const unsigned short pieceStartY  = 0;
-        static const unsigned int   baseRowScore = 100;
-        static const unsigned int   speedStep    = 10;
-        static const unsigned int   speedLimit   = 100;
+
+        static_assert(StandardWell::StorageType::width == wellWidth && StandardWell::StorageType::height == wellHeight,
+                "the game plays on the standard well");
 
         static const unsigned int   statusChangeEffectTime = 45;
 
+        static const unsigned int   defaultAutoShiftDelay = 167; // ms before a held direction repeats
+        static const unsigned int   defaultAutoRepeatRate = 33;  // ms between repeats, 0 is instant
+
+        static const unsigned int   seekStep = Replay::keyframeInterval; // ticks a key skips in a replay
+        static const unsigned int   undoTicks = 20 * 60; // how far back practice mode can undo
+
     private:
-        // Will call getFullRows, and if there are full rows, increase the score accordingly, increase the count of cleared rows, remove the fallen rows, and call handleSpeed.
-        void handleRows();
+        // Applies the auto-repeat shifts of a held direction key that became due up to a_time.
+        void handleAutoShift(Uint32 a_time);
+
+        // Applies a player's action to the simulation, recording it if it changed anything.
+        // Returns whether it did.
+        bool submit(Simulation::Action a_action);
+
+        // Runs one tick of the simulation, feeding it the replay's actions when playing one back.
+        void step();
 
-        // Will effectively increase m_speed for every speedStep lines cleared.
-        void handleSpeed();
+        // Takes back the last piece that landed, in practice (easy) mode: the game goes back to
+        // when that piece appeared, if that is still in the history. Returns whether it did.
+        bool undo();
 
-        // Generate a new piece, and check for game over
-        void handleNewPiece();
+        // Shows the simulation's score, level and lines, with an effect on those that changed.
+        void updateStatus();
 
-        void handleGenNewPiece();
+        // Once the simulation is over: finishes the game, moving on to the game over screen.
+        void handleGameOver();
+
+        // Writes the recording to the application's replay directory, if there is one.
+        void saveReplay();
 
         // Draws the preview box, where the next piece is shown.
-        void drawPreviewBox(Surface_ptr a_parent);
+        void drawPreviewBox(Surface_ptr const& a_parent);
+
+        // One line of the status display, such as "Score: 1200". It is drawn glyph by glyph from
+        // an atlas, so changing its value or color does not render anything.
+        struct StatusLine
+        {
+            const char *label;
+            GlyphAtlas const* atlas; // decides the color the line is drawn in
+            char text[32];
+            TimerHandle effect;      // switches the color back after a change
+        };
 
-        void renderStatus(Surface_ptr * dest, std::string const& text, unsigned int value, SDL_Color fg);
-        void renderStatusWithEffect(Surface_ptr * dest, std::string const& text, unsigned int value, SDL_Color fg1, SDL_Color fg2, unsigned int delayTime);
-        void renderStatusWithDefaultEffect(Surface_ptr * dest, std::string const& text, unsigned int value);
+        void setStatus(StatusLine * line, unsigned int value, GlyphAtlas const* atlas);
+        void setStatusWithEffect(StatusLine * line, unsigned int value, GlyphAtlas const* atlas1, GlyphAtlas const* atlas2, unsigned int delayTime);
+        void setStatusWithDefaultEffect(StatusLine * line, unsigned int value);
 
         const Application *getOwner()
         {
             return (const Application*)m_parent;
         }
 
-        MultiState * getChild()
-        {
-            return (MultiState*)m_child.get();
-        }
+        // Set when playing a replay back, before m_simulation, which it sets up.
+        std::unique_ptr<ReplayPlayer> m_player;
+        double m_playbackSpeed, m_playbackTicks; // ticks per update, and those owed so far
+
+        Simulation m_simulation;
+        ReplayRecorder m_recorder;
+        SimulationHistory m_history; // of a game being played, for undo
 
-        Well m_well;
+        Scheduler m_effects; // delayed changes to the display, such as the status effects; ticked once per update
 
-        bool m_fallFaster, m_falling, m_easyMode;
+        bool m_easyMode;
 
-        unsigned int m_time; // how long has the current piece been in the screen
+        AutoShift m_autoShift;
 
-        unsigned int m_score; // the player's score 
-        unsigned int m_clearedLines; // number of lines cleared by the player
-        unsigned int m_speed;    // the inverse speed of the falling blocks
+        unsigned int m_shownScore, m_shownLevel, m_shownLines; // what the status lines show
 
         SDL_Rect m_wellPosition; // pos. of top-left corner of the well (such that it is centered onscreen)
         SDL_Rect m_piecePreviewPosition; // pos. of top-left corner of the "next piece" boxr.
@@ -107,9 +156,9 @@ class Game final
                     m_fallenPreviewSurface;
 
         Font_ptr m_statusFont;   // the font used to draw the level number and the score.
-        Surface_ptr m_scoreSurface, // the text is rendered into these surfaces only when it changes.
-                    m_levelSurface, // this avoids unnecessary rerendering of the same text.
-                    m_linesSurface;
+        GlyphAtlas_ptr m_statusAtlasNormal, // the status font's glyphs, rendered once per color.
+                       m_statusAtlasEffect;
+        StatusLine m_scoreLine, m_levelLine, m_linesLine;
         SDL_Rect m_statusLocation;  // where the game status is rendered;
         // Only one SDL_Rect is necessary, because the level is drawn just a bit lower than the score.
 
@@ -117,8 +166,9 @@ class Game final
         SDL_Color m_statusColorFgEffect;    // used when the value changes.
         SDL_Color m_statusColorBg;
 
+        std::shared_ptr<GameOverState> m_nextGameOver; // prewarmed while the game runs
+
         Surface_ptr m_clearedSurface;
-        std::vector<SDL_Rect> m_clearingSurfaces;
 };
 
 #endif
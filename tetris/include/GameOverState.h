@@ -6,6 +6,7 @@
 
 #include "util_SDL.h"
 #include "State.h"
+#include "GlyphAtlas.h"
 
 class Application;
 
@@ -13,13 +14,20 @@ class GameOverState
     : public State
 {
     public:
+        GameOverState (const Application *a_parent);
         GameOverState (const Application *a_parent, unsigned int a_score, unsigned int a_speed, unsigned int a_lines);
 
+        // Sets the results to show, and whether to add them to the high scores (see HighScores)
+        // or only show where they would rank. Loading does not depend on them, so the state can
+        // be prewarmed before the game is over and given its results at the end.
+        void setResults (unsigned int a_score, unsigned int a_speed, unsigned int a_lines, bool a_ranked = true);
+
         virtual void load() override;
+        virtual void activate() override;
         // We don't need to override `cleanup`.
         // We don't need to override `update`.
-        virtual void handleEvent(SDL_Event const& event) override;
-        virtual void draw(Surface_ptr a_parent) override;
+        virtual void handleEvent(SDL_Event const& event, Uint32 a_time) override;
+        virtual void draw(Surface_ptr const& a_parent) override;
 
     private:
         const Application * getOwner()
@@ -27,11 +35,16 @@ class GameOverState
             return (const Application*)m_parent;
         }
 
-        Surface_ptr m_scoreSurface, m_levelSurface, m_skillSurface, m_linesSurface, m_gameOverSurface;
+        Surface_ptr m_gameOverSurface;
         unsigned int m_skill;
         unsigned int m_score, m_level, m_lines;
+        bool m_ranked;
+        char m_resultLines[5][32]; // drawn from m_atlas, formatted when the state is activated
         Font_ptr m_font;
+        GlyphAtlas_ptr m_atlas;
         SDL_Color m_textColorFg, m_textColorBg;
+
+        State_ptr m_nextMenu; // prewarmed while this state runs
 };
 
 #endif
@@ -0,0 +1,50 @@
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <array>
+
+#include "util_SDL.h"
+
+/** The printable ASCII characters of a font, rendered once in one color pair into a single surface.
+ * Text is then drawn by blitting rectangles out of that surface, with no further TTF calls or
+ * surface allocations.
+ */
+class GlyphAtlas final
+{
+    public:
+        static const char firstGlyph = ' ';
+        static const char lastGlyph  = '~';
+
+        /** a_glyphs, if given, limits the atlas to those characters (for example digits and the
+         * letters of a few labels), which makes building it proportionally cheaper.
+         */
+        GlyphAtlas(TTF_Font *a_font, SDL_Color a_fg, SDL_Color a_bg, const char *a_glyphs = nullptr);
+
+        /** Converts the atlas to the screen's format, so that drawing from it needs no conversion.
+         * Atlases are built as plain software surfaces, since states may be loaded on the loader
+         * thread, and SDL's video calls are only made from the main thread: states call this on
+         * their atlases when they are activated. Only the first call converts.
+         */
+        void optimize();
+
+        /** Draws a_text with its top-left corner at (a_x, a_y) and returns the width it took.
+         * Characters the atlas does not have are skipped.
+         */
+        unsigned int draw(const char *a_text, SDL_Surface *a_dest, short a_x, short a_y) const;
+
+        unsigned int measure(const char *a_text) const;
+
+        unsigned int getHeight() const;
+
+    private:
+        SDL_Rect const* glyph(char a_c) const;
+
+        Surface_ptr m_surface;
+        bool m_optimized;
+        std::array<SDL_Rect, lastGlyph - firstGlyph + 1> m_glyphs;
+        unsigned int m_height;
+};
+
+typedef std::shared_ptr<GlyphAtlas> GlyphAtlas_ptr;
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef HIGHSCORES_H
+#define HIGHSCORES_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** Every game ever finished, kept in a file that only ever grows, with an index that answers
+ * "what rank is this score" and "what are the best k scores" in O(log n) however many there are.
+ *
+ * Layout of a high score file:
+ *
+ *     "THSC"  u32 version  u32 recordSize  u32 0
+ *     records, each recordSize bytes:
+ *         u32 score  u32 lines  u32 level  u32 check  u64 time (seconds since the epoch)
+ *
+ * Fixed-size numbers are little-endian. The check is a hash of the rest of the record, so a
+ * record that was only partly written when the program or the machine went down is told apart
+ * from a real one. Records are only ever appended, each in a single write that is synced to disk,
+ * so a crash can at worst lose the records not yet written: on loading, a torn record at the end
+ * is ignored, and the next add writes over it.
+ *
+ * The file is mapped to load it. The index is a treap (a binary search tree kept balanced by
+ * random priorities) in one array, ordered by score, best first, then by age, with the size of
+ * each subtree in its nodes; loading sorts the scores in O(n log n) and then builds the treap
+ * from them in linear time.
+ *
+ * A HighScores is used from one thread at a time: loaded as the game over screen is prewarmed,
+ * and added to once it is shown. The records added are written by a background thread of its own,
+ * so that syncing the file does not hold up the screen; the index, and so the rank, is updated
+ * at once.
+ */
+class HighScores final
+{
+    public:
+        static const std::uint32_t version = 1;
+        static const std::size_t headerSize = 16;
+        static const std::size_t recordSize = 24;
+
+        struct Entry
+        {
+            unsigned int score, lines, level;
+            std::int64_t time;
+        };
+
+        HighScores();
+
+        /** Writes the records still waiting to be written.
+         */
+        ~HighScores();
+
+        HighScores(HighScores const&) = delete;
+        HighScores & operator=(HighScores const&) = delete;
+
+        /** Where the scores are kept; an empty path keeps them in memory only. Takes effect on the
+         * next load. Records added before still go to the previous file.
+         */
+        void setPath(std::string const& a_path);
+        std::string const& getPath() const;
+
+        /** Reads the file, if it has not been read since the path was set. A missing file is an
+         * empty table; a file that is not a high score file is left alone, and returns false.
+         */
+        bool load();
+
+        bool isLoaded() const;
+
+        /** Adds a_entry to the index and returns its rank, and queues it to be appended to the
+         * file. The entry is kept in memory even if it cannot be written.
+         */
+        std::size_t add(Entry const& a_entry);
+
+        /** Waits until every record added has been written, or has failed to be.
+         */
+        void flush();
+
+        /** Writes a_entry as a record of the file into a_out, which has room for recordSize bytes.
+         * For tools that write tables in bulk.
+         */
+        static void encode(Entry const& a_entry, unsigned char *a_out);
+
+        // // // QUERIES // // //
+
+        std::size_t getCount() const;
+
+        /** 1 plus the number of entries with a higher score: the rank a_score has, or would have.
+         * Equal scores share a rank.
+         */
+        std::size_t getRank(unsigned int a_score) const;
+
+        /** The best a_count entries, best first; ties in the order they were added.
+         */
+        void getTop(std::size_t a_count, std::vector<Entry> & a_out) const;
+
+        /** The entry at 0-based position a_position in that order.
+         */
+        Entry const& getNth(std::size_t a_position) const;
+
+    private:
+        static const std::uint32_t none = 0xffffffff;
+
+        // A node of the index; its entry is the one at the same position in m_entries.
+        struct Node
+        {
+            std::uint32_t left, right;
+            std::uint32_t size; // of the subtree
+            std::uint32_t priority;
+        };
+
+        // Whether entry a_a comes before entry a_b in the index.
+        bool before(std::uint32_t a_a, std::uint32_t a_b) const;
+
+        std::uint32_t sizeOf(std::uint32_t a_node) const;
+        void update(std::uint32_t a_node);
+
+        void build();
+        std::uint32_t insert(std::uint32_t a_root, std::uint32_t a_node);
+        void split(std::uint32_t a_root, std::uint32_t a_key, std::uint32_t & a_left, std::uint32_t & a_right);
+
+        std::uint32_t nextPriority();
+
+        bool append(Entry const& a_entry);
+
+        // The writer thread: appends the queued records until stopped.
+        void write();
+
+        std::string m_path;
+        bool m_loaded;
+        bool m_writable; // false for a file that is not a high score file
+        std::size_t m_fileRecords; // whole records in the file, valid or not: where the next one goes
+
+        std::vector<Entry> m_entries; // in the order they were added
+        std::vector<Node> m_nodes;
+        std::uint32_t m_root;
+        std::uint32_t m_random;
+
+        std::mutex m_writeMutex;
+        std::condition_variable m_writeWake, m_writeDone;
+        std::deque<Entry> m_writes; // added, not yet written
+        bool m_writing;             // the writer has taken a record off m_writes and not written it yet
+        bool m_stopping;
+        std::thread m_writer;       // started by the first add that has a file to write to
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "RingBuffer.h"
+
+/** Collects a distribution of durations, in microseconds, into fixed log-linear buckets. Recording
+ * is constant time and never allocates; quantiles are accurate to about 3%.
+ */
+class LatencyHistogram final
+{
+    public:
+        LatencyHistogram();
+
+        void record(std::uint32_t a_micros);
+        void clear();
+
+        std::uint64_t getCount() const;
+        std::uint32_t getMax() const;
+
+        // a_quantile in [0, 1]. Returns 0 when empty.
+        std::uint32_t getQuantile(double a_quantile) const;
+
+    private:
+        static const unsigned int linearBuckets = 64; // values below this get a bucket each
+        static const unsigned int subBuckets    = 32; // buckets per power of two above that
+        static const unsigned int bucketCount   = linearBuckets + (32 - 6) * subBuckets;
+
+        static unsigned int bucketOf(std::uint32_t a_micros);
+        static std::uint32_t bucketValue(unsigned int a_bucket);
+
+        std::array<std::uint64_t, bucketCount> m_buckets;
+        std::uint64_t m_count;
+        std::uint32_t m_max;
+};
+
+/** Measures how long input takes to reach the screen and how long frames take.
+ *
+ * Input events are followed from the moment they are polled, to the moment a state applies them
+ * (`eventApplied`), to the first SDL_Flip after that (`framePresented`). Frame phases are recorded
+ * by Application::run. Samples go through lock-free ring buffers and are folded into histograms by
+ * `collect`, so the recording side never blocks or allocates.
+ */
+class Instrumentation final
+{
+    public:
+        typedef std::uint64_t Micros;
+
+        enum class Metric : unsigned int
+        {
+            pollToApply,  // event polled -> applied by a state
+            pollToFlip,   // event polled -> first SDL_Flip showing its effect
+            frameUpdate,  // Application::update
+            frameDraw,    // Application::draw, including the flip
+            frameTotal,   // start of one frame to the start of the next
+            count
+        };
+
+        Instrumentation();
+
+        /** Microseconds on a monotonic clock with an arbitrary origin.
+         */
+        static Micros now();
+
+        // // // RECORDING (game thread) // // //
+
+        /** The event about to be dispatched was polled at a_polled.
+         */
+        void beginEvent(Micros a_polled);
+        void endEvent();
+
+        /** The event being dispatched changed the game. Called by the state that handled it.
+         */
+        void eventApplied();
+
+        /** SDL_Flip just returned; everything applied so far is now on screen.
+         */
+        void framePresented();
+
+        void record(Metric a_metric, Micros a_duration);
+
+        // // // REPORTING // // //
+
+        /** Moves the samples waiting in the ring buffers into the histograms.
+         */
+        void collect();
+
+        LatencyHistogram const& getHistogram(Metric a_metric) const;
+
+        /** The most recent sample of a_metric, in microseconds.
+         */
+        std::uint32_t getLast(Metric a_metric) const;
+
+        /** Where `report` should go when the application exits: "" disables the report, "-" means
+         * standard error, anything else is a file path.
+         */
+        void setReportPath(std::string const& a_path);
+        std::string const& getReportPath() const;
+
+        void report(std::ostream & a_out);
+
+        /** Writes the report to the configured destination, if any.
+         */
+        void reportOnExit();
+
+    private:
+        struct Sample
+        {
+            Metric metric;
+            std::uint32_t micros;
+        };
+
+        static const unsigned int maxPendingEvents = 64;
+
+        RingBuffer<Sample, 1024> m_samples;
+        std::uint64_t m_dropped; // samples lost because the ring was full
+
+        std::array<LatencyHistogram, (unsigned int)Metric::count> m_histograms;
+        std::array<std::uint32_t, (unsigned int)Metric::count> m_last;
+
+        Micros m_currentEvent;      // poll time of the event being dispatched, or 0
+        bool m_currentApplied;      // whether the current event was already applied
+        std::array<Micros, maxPendingEvents> m_pendingEvents; // applied, waiting for a flip
+        unsigned int m_pendingCount;
+
+        std::string m_reportPath;
+};
+
+#endif
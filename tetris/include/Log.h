@@ -0,0 +1,100 @@
+#ifndef LOG_H
+#define LOG_H
+
+/** Leveled logging that never blocks the calling thread, for messages from anywhere in the game,
+ * including the middle of a frame:
+ *
+ *     if ( blitSurface(...) != 0 )
+ *         LOG_ERROR("Failed to draw the well surface: %s", SDL_GetError());
+ *
+ * A message is formatted printf-style into a slot of a fixed-size queue, which any number of
+ * threads push to without locking or allocating; a writer thread takes them off and writes them
+ * to stderr. If the queue is full, the message is dropped and counted.
+ *
+ * Each place that logs is rate limited on its own: past burstLimit messages in a second, further
+ * ones are only counted, and the writer says how many there were once the second is over. A
+ * message that is the same as the one written before it is not written again either; the writer
+ * says how many times it was repeated when another message comes, or after a second.
+ *
+ * Messages below LOG_LEVEL are compiled out, arguments and all: `make LOG_LEVEL=3` leaves only
+ * errors. The default keeps everything but debug messages.
+ */
+
+#include <atomic>
+#include <cstdint>
+
+#define LOG_LEVEL_DEBUG   0
+#define LOG_LEVEL_INFO    1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR   3
+#define LOG_LEVEL_NONE    4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Lets GCC and Clang check the arguments of the messages against their formats.
+#ifdef __GNUC__
+#define LOG_PRINTF_FORMAT(a_format, a_args) __attribute__((format(printf, a_format, a_args)))
+#else
+#define LOG_PRINTF_FORMAT(a_format, a_args)
+#endif
+
+// Logs a printf-style message at a_level (one of the logging::Level values) if it is not below
+// LOG_LEVEL. The format must be a string literal.
+#define LOG_AT(a_level, ...) \
+    do \
+    { \
+        if constexpr ( (int)(a_level) >= LOG_LEVEL ) \
+        { \
+            static ::logging::Site logSite; \
+            ::logging::write(logSite, a_level, __VA_ARGS__); \
+        } \
+    } while ( false )
+
+#define LOG_DEBUG(...)   LOG_AT(::logging::Level::debug, __VA_ARGS__)
+#define LOG_INFO(...)    LOG_AT(::logging::Level::info, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(::logging::Level::warning, __VA_ARGS__)
+#define LOG_ERROR(...)   LOG_AT(::logging::Level::error, __VA_ARGS__)
+
+namespace logging
+{
+    enum class Level
+    {
+        debug   = LOG_LEVEL_DEBUG,
+        info    = LOG_LEVEL_INFO,
+        warning = LOG_LEVEL_WARNING,
+        error   = LOG_LEVEL_ERROR,
+    };
+
+    static const unsigned int burstLimit = 10; // messages per place per second
+
+    /** The rate limit of one place that logs. Only the macros above make these, one per use; they
+     * are never destroyed, so that the writer can still read them as the program exits.
+     */
+    struct Site
+    {
+        std::atomic<std::int64_t> windowStart { 0 }; // in milliseconds since the logger started
+        std::atomic<unsigned int> inWindow { 0 };
+        std::atomic<unsigned int> suppressed { 0 };
+
+        // Set when the site first goes over its limit, which puts it on the writer's list.
+        std::atomic<bool> listed { false };
+        Level level = Level::debug;
+        const char *format = nullptr;
+        Site *next = nullptr;
+        std::int64_t reported = 0; // the writer's: when it last said how many were suppressed
+    };
+
+    /** Queues a message, or counts it against a_site's rate limit. Use the macros instead.
+     */
+    void write(Site & a_site, Level a_level, const char *a_format, ...) LOG_PRINTF_FORMAT(3, 4);
+
+    /** Waits until every message queued so far has been written, along with the counts of
+     * repeated and rate-limited messages so far. The writer itself runs until the program exits,
+     * and writes whatever is still queued then.
+     */
+    void flush();
+}
+
+#endif
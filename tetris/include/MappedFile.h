@@ -0,0 +1,35 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/** A read-only view of a whole file, memory-mapped where the platform allows it. On platforms
+ * without mmap the file is read into memory instead, which behaves the same apart from the cost.
+ */
+class MappedFile final
+{
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile & operator=(MappedFile const&) = delete;
+
+        // Maps a_path, replacing whatever was mapped before. Returns false if it could not be opened.
+        bool open(std::string const& a_path);
+        void close();
+
+        bool isOpen() const;
+        const unsigned char * data() const;
+        std::size_t size() const;
+
+    private:
+        const unsigned char *m_data;
+        std::size_t m_size;
+        bool m_mapped;                      // whether m_data comes from mmap
+        std::vector<unsigned char> m_buffer; // the contents, where mmap is not available
+};
+
+#endif
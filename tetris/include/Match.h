@@ -0,0 +1,76 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Simulation.h"
+
+// A versus game between two or more boards, each a Simulation, all getting the same pieces.
+// Clearing rows sends garbage: first to cancel the garbage on its way to the board that cleared
+// them, then to the next opponent still playing, in turn, so that with many boards it goes round.
+// The last board left playing wins. Without SDL, like Simulation, so that bots can play whole
+// tournaments headlessly; VersusState puts one on screen.
+class Match final
+{
+    public:
+        static constexpr unsigned int maxBoards = 64;
+
+        // The garbage rows sent for clearing 0, 1, 2, 3 and 4 rows at once.
+        static const unsigned int garbageTable[5];
+
+        // Every board starts at a_initialSpeed. A match that runs for a_maxTicks ticks ends with
+        // the highest score winning, or a draw; 0 lets it run until one board is left.
+        Match(unsigned int a_boards, std::uint32_t a_seed, unsigned int a_initialSpeed, std::uint64_t a_maxTicks = 0);
+
+        // Starts a new match on the same boards with a_seed, as a new match would, without
+        // allocating.
+        void restart(std::uint32_t a_seed);
+
+        // Applies a player's action to board a_board.
+        bool apply(unsigned int a_board, Simulation::Action a_action);
+
+        // Advances every board still playing by one tick, and hands out the garbage their
+        // cleared rows send.
+        void tick();
+
+        // // // OBSERVERS // // //
+
+        unsigned int getBoardCount() const;
+
+        Simulation & getBoard(unsigned int a_board);
+        Simulation const& getBoard(unsigned int a_board) const;
+
+        // The garbage rows board a_board has sent in all.
+        unsigned int getSent(unsigned int a_board) const;
+
+        bool isOver() const;
+
+        // The board that won, or -1 while the match runs and for a draw.
+        int getWinner() const;
+
+        std::uint64_t getTicks() const;
+
+    private:
+        // Sends the garbage for a_lines rows cleared on board a_from.
+        void sendGarbage(unsigned int a_from, unsigned int a_lines);
+
+        // Decides the match once one board or none is left, or time is up.
+        void checkOver();
+
+        // Simulations hold their lock sequence's coroutine, which points back at them, so they
+        // cannot move; they are kept behind pointers.
+        std::vector<std::unique_ptr<Simulation>> m_boards;
+        std::vector<unsigned int> m_lines; // each board's cleared rows, as of the last tick
+        std::vector<unsigned int> m_sent;
+
+        unsigned int m_nextTarget; // where the next garbage goes, if that board still plays
+        std::uint32_t m_randomState; // std::minstd_rand's, for the garbage holes
+
+        std::uint64_t m_ticks, m_maxTicks;
+        bool m_over;
+        int m_winner;
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include "util_SDL.h"
 
 class Application;
+class Game;
 
 class MenuState final
     : public State
@@ -17,10 +18,11 @@ class MenuState final
         MenuState(const Application *a_parent);
 
         virtual void load() override;
+        virtual void activate() override;
         //virtual void cleanup() override;
-        //virtual void update() override;
-        virtual void draw(Surface_ptr a_parent) override;
-        virtual void handleEvent(SDL_Event const& event) override;
+        virtual void update() override;
+        virtual void draw(Surface_ptr const& a_parent) override;
+        virtual void handleEvent(SDL_Event const& event, Uint32 a_time) override;
 
         static const int maxSpeed = 20;
         static const short buttonSpacing = 5;
@@ -31,6 +33,9 @@ class MenuState final
             return (const Application*)(m_parent);
         }
 
+        // Renders the help text, which is not needed for the first frame.
+        void loadHelp();
+
         Font_ptr m_titleFont,
                  m_menuFont;
 
@@ -49,6 +54,9 @@ class MenuState final
         std::vector<Surface_ptr> m_initialSpeedTexts;
 
         int m_selectedSpeed;
+        bool m_drawn; // whether the menu has been on screen yet
+
+        std::shared_ptr<Game> m_nextGame; // prewarmed while the menu is shown
 };
 
 #endif
@@ -0,0 +1,59 @@
+#ifndef PERFOVERLAY_H
+#define PERFOVERLAY_H
+
+#include <array>
+#include <cstdint>
+
+#include "State.h"
+#include "GlyphAtlas.h"
+#include "util_SDL.h"
+
+class Application;
+
+/** A heads-up display of frame rate, frame times, blits and allocations per frame, and the number
+ * of pending effect timers, drawn over the game. Text goes through a GlyphAtlas, so showing the overlay
+ * costs a few dozen blits and no allocations.
+ */
+class PerfOverlay final
+    : public State
+{
+    public:
+        PerfOverlay(const Application *a_owner);
+
+        virtual void load() override;
+
+        /** Samples this frame's counters. Called once per frame whether or not the overlay is shown,
+         * so that the history is already there when it is turned on.
+         */
+        virtual void update() override;
+
+        virtual void draw(Surface_ptr const& a_parent) override;
+
+        static const unsigned int historyLength = 120; // frames in the frame time graph
+        static const unsigned int barWidth      = 2;
+        static const unsigned int graphHeight   = 80;
+        static const unsigned int graphScale    = 2;   // pixels per millisecond
+        static const short        margin        = 6;
+
+    private:
+        const Application * getOwner()
+        {
+            return (const Application*)m_parent;
+        }
+
+        void drawGraph(SDL_Surface *a_dest, short a_x, short a_y);
+
+        Font_ptr m_font;
+        GlyphAtlas_ptr m_atlas;
+
+        std::array<std::uint32_t, historyLength> m_frameTimes; // microseconds, circular
+        unsigned int m_historyHead, m_historySize;
+
+        unsigned long m_lastBlits, m_ownBlits, m_blitsPerFrame;
+        std::uint64_t m_lastAllocations, m_allocationsPerFrame;
+        std::size_t m_arenaPeak; // the most frame arena memory used in one frame
+
+        Uint32 m_panelColor, m_barColor, m_slowBarColor, m_budgetColor;
+};
+
+#endif
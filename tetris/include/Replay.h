@@ -0,0 +1,234 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Simulation.h"
+
+/** A recorded game: the seed and initial speed it started with, and every action that changed it,
+ * with the tick it was applied before. Playing the actions into a Simulation made from the same
+ * seed and speed plays the same game again.
+ *
+ * Layout of a replay file:
+ *
+ *     "TRPL"  varint version  varint seed  varint initialSpeed
+ *     records, each a varint (ticks since the previous record << kindBits | kind), where kind is
+ *     a Simulation::Action, or endKind for the last record, which marks how many ticks the game ran,
+ *     or checksumKind, followed by the simulation's checksum at that tick as a u32,
+ *     or resultsKind, just before the end record, followed by how the game ended:
+ *     varint score  varint clearedLines  varint level  u32 checksum
+ *     keyframes, each a Simulation::Snapshot taken every keyframeInterval ticks, keyframeSize bytes
+ *     index, an entry per keyframe in order of ticks:
+ *         u64 tick  u64 recordTick  u32 recordOffset  u32 keyframeOffset
+ *     u64 length  u32 recordsEnd  u32 indexOffset  u32 keyframeCount  "TKEY"
+ *
+ * Varints are little-endian base 128: seven bits per byte, the high bit set on all bytes but the
+ * last. Actions are mostly a few ticks apart, so most records take a single byte. Fixed-size
+ * numbers are little-endian. An index entry gives the first record after its keyframe, and the
+ * tick of the record before it, which that record's delta counts from.
+ *
+ * A replay maps its file and reads records as they are played, so seeking to a tick restores the
+ * keyframe before it, found by a binary search over the index, and only simulates the ticks after.
+ * Checksums are recorded every few ticks, which is enough to tell that a replay no longer plays
+ * the same, and within how many ticks it started; recording them every tick finds the very tick.
+ */
+class Replay final
+{
+    public:
+        static const std::uint32_t version = 1;
+
+        static const unsigned int kindBits = 4;
+        static const unsigned int endKind = (1 << kindBits) - 1;
+        static const unsigned int checksumKind = endKind - 1;
+        static const unsigned int resultsKind = endKind - 2;
+
+        static const unsigned int keyframeInterval = 600; // ten seconds of play
+        static const std::size_t keyframeSize = 92;
+
+        static const unsigned int defaultChecksumInterval = 60; // ticks
+
+        struct Entry
+        {
+            std::uint64_t tick;
+            bool isChecksum;
+            Simulation::Action action; // unless isChecksum
+            std::uint32_t checksum;    // if isChecksum
+        };
+
+        // How the recorded game ended, as far as it was played.
+        struct Results
+        {
+            unsigned int score, clearedLines, level;
+            std::uint32_t checksum;
+        };
+
+        // A position in the records.
+        struct Cursor
+        {
+            std::size_t offset;
+            std::uint64_t tick; // of the record before
+        };
+
+        Replay();
+
+        Replay(Replay const&) = delete;
+        Replay & operator=(Replay const&) = delete;
+
+        // Maps a replay file. Returns false, leaving the replay empty, if it cannot be read or is
+        // malformed.
+        bool load(std::string const& a_path);
+        // As load, from a copy of a_data.
+        bool parse(const unsigned char *a_data, std::size_t a_size);
+
+        // // // OBSERVERS // // //
+
+        std::uint32_t getSeed() const;
+        unsigned int getInitialSpeed() const;
+        std::uint64_t getLength() const; // in ticks
+        std::size_t getKeyframeCount() const;
+
+        // Whether the replay says how the game ended, which replays before version 4 do not.
+        bool hasResults() const;
+        Results const& getResults() const;
+
+        // The first record.
+        Cursor begin() const;
+
+        // Reads the record at a_cursor into a_entry and moves past it. Returns false at the end.
+        bool next(Cursor & a_cursor, Entry & a_entry) const;
+
+        // Finds the last keyframe at or before a_tick, and where the records continue from it.
+        // Returns false if there is none.
+        bool findKeyframe(std::uint64_t a_tick, Simulation::Snapshot & a_snapshot, Cursor & a_cursor) const;
+
+    private:
+        // Checks the replay in m_data and reads its header. Returns false if it is malformed.
+        bool open();
+        void close();
+
+        MappedFile m_file;
+        std::vector<unsigned char> m_copy; // the replay, when it was not loaded from a file
+        const unsigned char *m_data;
+        std::size_t m_size;
+
+        std::uint32_t m_seed;
+        unsigned int m_initialSpeed;
+        std::uint64_t m_length;
+        bool m_hasResults;
+        Results m_results;
+
+        std::size_t m_recordsBegin, m_recordsEnd; // the end record is the last before m_recordsEnd
+        std::size_t m_indexOffset, m_keyframeCount;
+};
+
+/** Records a game as it is played, in the format described at Replay.
+ */
+class ReplayRecorder final
+{
+    public:
+        ReplayRecorder();
+
+        // Starts a recording, dropping any previous one, with the simulation's checksum every
+        // a_checksumInterval ticks, or none if it is 0. Reserves room for a long game, so that
+        // recording does not allocate while the game runs.
+        void begin(std::uint32_t a_seed, unsigned int a_initialSpeed,
+                   unsigned int a_checksumInterval = Replay::defaultChecksumInterval);
+
+        // a_action was applied before tick a_tick. Ticks must not decrease.
+        void record(std::uint64_t a_tick, Simulation::Action a_action);
+
+        // Called after every tick of the recorded simulation: keeps a keyframe of it every
+        // keyframeInterval ticks, and records its checksum.
+        void afterTick(Simulation const& a_simulation);
+
+        // Ends the recording where a_simulation is at, with how the game ended so far, and appends
+        // the keyframes and their index.
+        void finish(Simulation const& a_simulation);
+
+        // Drops the recording, for a game that can no longer be replayed.
+        void cancel();
+
+        bool isRecording() const;
+        bool isFinished() const;
+
+        // Writes a finished recording to a_path. Returns false if the file could not be written.
+        bool save(std::string const& a_path) const;
+
+        std::vector<unsigned char> const& getBytes() const;
+
+    private:
+        struct IndexEntry
+        {
+            std::uint64_t tick, recordTick;
+            std::uint32_t recordOffset, keyframeOffset; // into m_bytes and m_keyframes
+        };
+
+        void put(std::uint64_t a_tick, unsigned int a_kind);
+
+        std::vector<unsigned char> m_bytes;
+        std::vector<unsigned char> m_keyframes; // until finish appends them to m_bytes
+        std::vector<IndexEntry> m_index;
+        unsigned int m_checksumInterval;
+        std::uint64_t m_lastTick;  // of the last record
+        std::uint64_t m_afterTick; // the last tick afterTick was called for
+        bool m_recording, m_finished;
+};
+
+/** Plays a replay into a simulation, one tick at a time, or jumps to a tick. The checksums in the
+ * replay are checked along the way, against the simulation's.
+ */
+class ReplayPlayer final
+{
+    public:
+        explicit ReplayPlayer(std::shared_ptr<Replay const> a_replay);
+
+        // A simulation set up the way the recorded game started.
+        Simulation makeSimulation() const;
+
+        // Applies the actions recorded for a_simulation's current tick, then ticks it. Returns
+        // false, without doing anything, once the replay is over.
+        bool step(Simulation & a_simulation);
+
+        // Brings a_simulation to a_tick, or to the end of the replay if it is shorter: from the
+        // keyframe before a_tick, or straight on if a_simulation is already between the two.
+        void seek(Simulation & a_simulation, std::uint64_t a_tick);
+
+        bool isDone(Simulation const& a_simulation) const;
+
+        Replay const& getReplay() const;
+
+        // Whether a checksum did not match, which means that the simulation no longer plays the
+        // recorded game. The first divergent tick is after getLastVerifiedTick, and at or before
+        // getDivergedTick.
+        bool hasDiverged() const;
+        std::uint64_t getDivergedTick() const;
+        std::uint64_t getLastVerifiedTick() const;
+        unsigned long getVerifiedCount() const;
+
+        // Whether a_simulation, played to the end, ended the way the recorded game did. True for
+        // replays that do not say.
+        bool matchesResults(Simulation const& a_simulation) const;
+
+    private:
+        // Reads the next entry to apply.
+        void fetch();
+
+        // Checks the checksum entry m_next against a_simulation.
+        void verify(Simulation const& a_simulation);
+
+        std::shared_ptr<Replay const> m_replay;
+        Replay::Cursor m_cursor;
+        Replay::Entry m_next;
+        bool m_hasNext;
+
+        bool m_diverged;
+        std::uint64_t m_divergedTick, m_lastVerifiedTick;
+        unsigned long m_verifiedCount;
+};
+
+#endif
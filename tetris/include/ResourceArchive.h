@@ -0,0 +1,54 @@
+#ifndef RESOURCEARCHIVE_H
+#define RESOURCEARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "MappedFile.h"
+
+// The archive the build embeds into the executable (generated from resources/ by tools/pack.cpp).
+extern const unsigned char embeddedArchive[];
+extern const std::size_t embeddedArchiveSize;
+
+/** A read-only pack of resource files, addressed by the paths they were packed under (for example
+ * "resources/statusfont.ttf"). Resources are used in place, without copying.
+ *
+ * Layout, all integers little-endian:
+ *
+ *     "TPAK"  u32 version  u32 count
+ *     count times:  u16 nameLength  name  u32 offset  u32 size
+ *     the resources' bytes, at the offsets given (from the start of the archive)
+ */
+class ResourceArchive final
+{
+    public:
+        static const std::uint32_t version = 1;
+
+        struct Entry
+        {
+            const unsigned char *data;
+            std::size_t size;
+        };
+
+        ResourceArchive();
+
+        // Reads the table of an archive in memory, which must outlive this object. Returns false,
+        // leaving the archive empty, if it is malformed.
+        bool open(const unsigned char *a_data, std::size_t a_size);
+
+        // Memory-maps an archive file and reads its table.
+        bool openFile(std::string const& a_path);
+
+        // Whether there is a resource called a_name, and if so where it is.
+        bool find(std::string const& a_name, Entry & a_entry) const;
+
+        std::size_t getCount() const;
+
+    private:
+        MappedFile m_file;
+        std::map<std::string, Entry> m_entries;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef RESOURCECACHE_H
+#define RESOURCECACHE_H
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "util_SDL.h"
+#include "GlyphAtlas.h"
+#include "ResourceArchive.h"
+
+/** Application-wide cache of fonts and pre-rendered surfaces, so that states do not reopen fonts
+ * and re-rasterize the same text every time they are loaded.
+ *
+ * The cache may be used from a StateLoader's thread. Every call holds a lock, which also serializes
+ * the SDL_ttf calls made through it, since SDL_ttf is not thread safe.
+ *
+ * Everything is handed out as a shared pointer. An entry stays cached until it is evicted; evicting
+ * only drops the cache's reference, so states still holding a handle keep a valid resource.
+ */
+class ResourceCache final
+{
+    public:
+        enum class TextStyle
+        {
+            shaded,  // TTF_RenderText_Shaded: fg on an opaque bg
+            blended  // TTF_RenderText_Blended: antialiased fg with alpha, bg is ignored
+        };
+
+        ResourceCache();
+
+        /** Where resource files are looked up first; files not in the archive are read from disk.
+         * The archive must outlive the cache's contents.
+         */
+        void setArchive(ResourceArchive const* a_archive);
+
+        // // // LOOKUP // // //
+
+        /** The font at a_path in point size a_size, opened on first use.
+         */
+        Font_ptr getFont(std::string const& a_path, int a_size);
+
+        /** a_text rendered in a_font, rendered on first use.
+         */
+        Surface_ptr getText(Font_ptr a_font, std::string const& a_text, SDL_Color a_fg, SDL_Color a_bg,
+                            TextStyle a_style = TextStyle::shaded);
+
+        /** A glyph atlas of a_font (see GlyphAtlas), built on first use.
+         */
+        GlyphAtlas_ptr getAtlas(Font_ptr a_font, SDL_Color a_fg, SDL_Color a_bg, const char *a_glyphs = nullptr);
+
+        /** Any other surface that is expensive to make, under a name chosen by the caller. a_make is
+         * only called if nothing is cached under a_name yet.
+         */
+        Surface_ptr getSurface(std::string const& a_name, std::function<Surface_ptr()> a_make);
+
+        /** The surface cached under a_name, or null if there is none. Does not count as a lookup.
+         */
+        Surface_ptr findSurface(std::string const& a_name) const;
+
+        // // // PRELOADING AND EVICTION // // //
+
+        void preloadFont(std::string const& a_path, int a_size);
+
+        /** Drops every entry that nobody outside the cache holds a handle to. Returns how many entries
+         * were dropped.
+         */
+        unsigned int evictUnused();
+
+        void evictFont(std::string const& a_path, int a_size);
+        void evictSurface(std::string const& a_name);
+
+        /** Drops every entry.
+         */
+        void clear();
+
+        // // // STATISTICS // // //
+
+        unsigned int getHits() const;
+        unsigned int getMisses() const;
+
+    private:
+        typedef std::tuple<std::string, int> FontKey;
+        typedef std::tuple<TTF_Font*, std::string, Uint32, Uint32, int> TextKey;
+        typedef std::tuple<TTF_Font*, Uint32, Uint32, std::string> AtlasKey;
+
+        // Holds on to the font as well, so that it outlives the cached rendering.
+        template<typename T>
+        struct Rendered
+        {
+            Font_ptr font;
+            std::shared_ptr<T> resource;
+        };
+
+        static Uint32 packColor(SDL_Color a_color);
+
+        std::map<FontKey, Font_ptr> m_fonts;
+        std::map<TextKey, Rendered<SDL_Surface>> m_texts;
+        std::map<AtlasKey, Rendered<GlyphAtlas>> m_atlases;
+        std::map<std::string, Surface_ptr> m_surfaces;
+
+        ResourceArchive const* m_archive;
+
+        unsigned int m_hits, m_misses;
+
+        // Recursive, because getSurface's callback commonly asks for text.
+        mutable std::recursive_mutex m_mutex;
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/** A fixed-capacity, lock-free queue for exactly one producer thread and one consumer thread.
+ * Neither side ever blocks or allocates: `push` fails when the buffer is full and `pop` fails when
+ * it is empty. Capacity must be a power of two.
+ */
+template<typename T, std::size_t Capacity>
+class RingBuffer final
+{
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0,
+                  "RingBuffer capacity must be a power of two.");
+
+    public:
+        RingBuffer()
+            : m_head(0), m_tail(0)
+        {
+        }
+
+        RingBuffer(RingBuffer const&) = delete;
+        RingBuffer & operator=(RingBuffer const&) = delete;
+
+        /** Producer side. Returns false, dropping the item, if the buffer is full.
+         */
+        bool push(T const& a_item)
+        {
+            std::size_t tail = m_tail.load(std::memory_order_relaxed);
+
+            if ( tail - m_head.load(std::memory_order_acquire) == Capacity )
+                return false;
+
+            m_items[tail & (Capacity - 1)] = a_item;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Consumer side. Returns false if there was nothing to take.
+         */
+        bool pop(T & a_item)
+        {
+            std::size_t head = m_head.load(std::memory_order_relaxed);
+
+            if ( head == m_tail.load(std::memory_order_acquire) )
+                return false;
+
+            a_item = m_items[head & (Capacity - 1)];
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Only a snapshot; the other side may change it at any time.
+         */
+        std::size_t size() const
+        {
+            return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+        }
+
+        static constexpr std::size_t capacity()
+        {
+            return Capacity;
+        }
+
+    private:
+        std::array<T, Capacity> m_items;
+
+        // Padded onto separate cache lines so the producer and consumer do not contend. (Padding
+        // rather than alignas, which would need C++17 aligned new for heap-allocated owners.)
+        char m_padding0[64];
+        std::atomic<std::size_t> m_head; // next slot to read, owned by the consumer
+        char m_padding1[64 - sizeof(std::atomic<std::size_t>)];
+        std::atomic<std::size_t> m_tail; // next slot to write, owned by the producer
+        char m_padding2[64 - sizeof(std::atomic<std::size_t>)];
+};
+
+#endif
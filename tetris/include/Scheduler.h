@@ -0,0 +1,183 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/** Identifies a scheduled callback, so that it can be cancelled. A handle stays safe to use after
+ * its callback has run or been cancelled; it then simply refers to nothing.
+ */
+struct TimerHandle
+{
+    std::uint32_t index;
+    std::uint32_t generation; // 0 never refers to a timer
+
+    TimerHandle()
+        : index(0), generation(0)
+    {
+    }
+};
+
+/** Runs callbacks a given number of ticks (normally frames) from now. This replaces a ForState per
+ * delay: scheduling and cancelling are O(1), and nothing is visited on the ticks in between.
+ *
+ * Timers are kept in a hierarchical timing wheel: levels of slotsPerLevel slots, each level
+ * covering slotsPerLevel times the span of the one below. A timer goes into the lowest level whose
+ * span reaches its expiry, and moves down a level whenever the level below wraps around, so it
+ * is touched at most once per level.
+ *
+ * Timer nodes, including their callbacks, are kept in pooled chunks and reused, so steady-state
+ * scheduling does not allocate. Callbacks are stored inline and must fit in callbackCapacity.
+ *
+ * Callbacks may schedule and cancel timers, including their own handle, which is a no-op. A
+ * scheduler is not thread safe; it is ticked by the state that owns it.
+ */
+class Scheduler final
+{
+    public:
+        static const unsigned int levelBits = 6;
+        static const unsigned int slotsPerLevel = 1 << levelBits;
+        static const unsigned int levels = 4;
+        static const std::uint64_t maxDelay = (std::uint64_t(1) << (levelBits * levels)) - 1; // longer delays are clamped
+
+        static const std::size_t callbackCapacity = 48;
+
+        Scheduler();
+        ~Scheduler();
+
+        Scheduler(Scheduler const&) = delete;
+        Scheduler & operator=(Scheduler const&) = delete;
+
+        /** Runs a_callback on the a_ticks'th call to tick from now; 0 counts as 1.
+         */
+        template<typename Callback>
+        TimerHandle schedule(std::uint64_t a_ticks, Callback && a_callback);
+
+        /** Makes room for a_count pending timers, so that scheduling up to that many does not
+         * allocate.
+         */
+        void reserve(std::size_t a_count);
+
+        /** Drops the timer if it has not run yet. Returns whether it was pending.
+         */
+        bool cancel(TimerHandle a_handle);
+
+        bool isPending(TimerHandle a_handle) const;
+
+        /** The number of calls to tick until the timer runs, counted the way schedule counts them,
+         * or 0 if it is not pending. Outside of tick, rescheduling with this delay, even on another
+         * scheduler, runs the callback on the same tick.
+         */
+        std::uint64_t getRemaining(TimerHandle a_handle) const;
+
+        /** Advances time by one tick, running the callbacks that fall due, in the order they were
+         * scheduled in.
+         */
+        void tick();
+
+        /** Cancels every pending timer.
+         */
+        void clear();
+
+        std::size_t getPendingCount() const;
+
+        // The number of timers pending in all of the calling thread's schedulers together, for
+        // diagnostics. Counted per thread, so that threads running their own schedulers do not
+        // share the count.
+        static std::size_t getTotalPending();
+
+    private:
+        static const std::uint32_t none = 0xffffffff;
+        static const unsigned int chunkSize = 64;
+        static const unsigned int dueList = levels * slotsPerLevel; // the list being run by tick
+
+        struct Node
+        {
+            typename std::aligned_storage<callbackCapacity>::type callback;
+            void (*invoke)(void*);
+            void (*destroy)(void*);
+
+            std::uint64_t expiry;
+            std::uint32_t prev, next;
+            std::uint32_t list; // which list the node is on, or none when free or running
+            std::uint32_t generation;
+        };
+
+        template<typename Callback>
+        static void invokeCallback(void *a_callback)
+        {
+            (*(Callback*)a_callback)();
+        }
+
+        template<typename Callback>
+        static void destroyCallback(void *a_callback)
+        {
+            ((Callback*)a_callback)->~Callback();
+        }
+
+        Node & node(std::uint32_t a_index);
+        Node const& node(std::uint32_t a_index) const;
+
+        std::uint32_t allocate();
+        void release(std::uint32_t a_index);
+
+        // Puts the node on the list of the wheel slot its expiry falls in.
+        void insert(std::uint32_t a_index);
+        void pushBack(std::uint32_t a_list, std::uint32_t a_index);
+        void unlink(std::uint32_t a_index);
+
+        // Moves the timers of level a_level's current slot down. Returns the slot's index, which is
+        // 0 when the level has wrapped around as well.
+        unsigned int cascade(unsigned int a_level);
+
+        static std::size_t & totalPending();
+
+        std::vector<std::unique_ptr<Node[]>> m_chunks; // chunks never move, so nodes are stable
+        std::uint32_t m_free;    // first free node, linked through next
+        std::uint32_t m_nodes;   // nodes handed out so far; the rest of the chunks are unused
+
+        std::uint32_t m_heads[dueList + 1], m_tails[dueList + 1];
+
+        std::uint64_t m_now;     // the next tick to run
+        std::size_t m_pending;
+};
+
+template<typename Callback>
+TimerHandle Scheduler::schedule(std::uint64_t a_ticks, Callback && a_callback)
+{
+    typedef typename std::decay<Callback>::type Stored;
+
+    static_assert(sizeof(Stored) <= callbackCapacity, "callback is too large to be stored inline");
+    static_assert(alignof(Stored) <= alignof(std::max_align_t), "callback is over-aligned");
+
+    std::uint32_t index = allocate();
+    Node &n = node(index);
+
+    new (&n.callback) Stored(std::forward<Callback>(a_callback));
+    n.invoke  = &invokeCallback<Stored>;
+    n.destroy = &destroyCallback<Stored>;
+
+    if ( a_ticks == 0 )
+        a_ticks = 1;
+    if ( a_ticks > maxDelay )
+        a_ticks = maxDelay;
+
+    // m_now is the tick about to run, so a delay of one tick expires at m_now.
+    n.expiry = m_now + a_ticks - 1;
+    insert(index);
+
+    m_pending++;
+    totalPending()++;
+
+    TimerHandle handle;
+    handle.index = index;
+    handle.generation = n.generation;
+    return handle;
+}
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Well.h"
+#include "Scheduler.h"
+#include "Coroutine.h"
+#include "Telemetry.h"
+
+// The rules of a game, without any SDL: the well, gravity, locking and clearing rows, scoring and
+// speeding up. A simulation advances only through `apply` and `tick`, and given the same seed,
+// initial speed and calls it always plays out the same way. That is what lets a Replay re-run a
+// recorded game, on screen through Game or headlessly at full speed.
+//
+// In a versus Match, opponents also send garbage rows into the well. Garbage is queued, and only
+// pushed in while a piece is falling, so that it never moves rows that are being cleared. It is
+// not part of a Snapshot: versus games are neither recorded nor restored.
+class Simulation final
+{
+    public:
+        // Everything a player can do. The values are stored in replays, so they must not change.
+        enum class Action : std::uint8_t
+        {
+            moveLeft    = 0,
+            moveRight   = 1,
+            rotateCCW   = 2,
+            rotateCW    = 3,
+            drop        = 4,
+            softDropOn  = 5,
+            softDropOff = 6,
+        };
+
+        static const unsigned int actionCount = 7;
+
+        static const unsigned int baseRowScore = 100;
+        static const unsigned int speedStep    = 10;
+        static constexpr unsigned int speedLimit = 100;
+
+        static const unsigned int lockDelay  = 15; // ticks between a piece landing and the rows being checked
+        static const unsigned int clearDelay = 30; // ticks the clearing effect is shown for
+
+        static const unsigned int wellHeight = StandardWell::StorageType::height;
+
+        // The whole state of a simulation between two ticks, packed into plain numbers, so that
+        // it is cheap to take and can be written out as it is. Restoring it into a simulation made
+        // with any seed continues the saved game exactly.
+        struct Snapshot
+        {
+            StandardWell::StorageType::Row rows[wellHeight];
+
+            std::uint8_t blocks[StandardWell::maxPieceBlocks][2]; // x, y of the falling piece's blocks
+            std::uint8_t blockCount;
+            std::uint8_t pivots;        // a bit per block, set for the piece's pivot
+            std::uint8_t pieceID, nextPieceID, rotationID;
+
+            std::uint8_t flags;         // see the flag values below
+            std::uint8_t lockPhase;     // a LockPhase
+            std::uint8_t lockTicks;     // the ticks left in the lock phase
+
+            std::uint32_t clearingRows; // a bit per row being cleared
+            std::uint32_t randomState;
+            std::uint32_t time, score, clearedLines, speed;
+            std::uint64_t ticks;
+
+            std::uint32_t checksum;     // see getChecksum
+
+            static const std::uint8_t fallFaster = 1, falling = 2, over = 4;
+        };
+
+        // // // CONSTRUCTORS // // //
+
+        Simulation(std::uint32_t a_seed, unsigned int a_initialSpeed);
+
+        // The lock sequence's coroutine holds pointers to its simulation and the simulation's
+        // scheduler, so a simulation stays where it was made.
+        Simulation(Simulation&&) = delete;
+        Simulation& operator=(Simulation&&) = delete;
+
+        // May only be called before the first tick.
+        void setInitialSpeed(unsigned int a_speed);
+
+        // Makes the coroutine frame for the lock sequence ahead of time, so that the first piece to
+        // land does not allocate. Each simulation keeps its own until then, for the boards of a
+        // Match whose pieces land on the same tick.
+        void warmUp();
+
+        // Continues from a_snapshot, as if it had been taken of this simulation.
+        void restore(Snapshot const& a_snapshot);
+
+        // Whether a_snapshot can be restored: its pieces and rotation exist, its blocks are in the
+        // well with one pivot, a falling piece has blocks, its speed is in range, its lock phase
+        // is known and its random state is not the one xorshift never leaves. Snapshots read from a file
+        // must be checked first, as restore trusts them.
+        static bool isValid(Snapshot const& a_snapshot);
+
+        // Starts a new game with a_seed at the initial speed, as a new simulation would, without
+        // allocating. Telemetry, if set, carries on with the new game.
+        void reset(std::uint32_t a_seed);
+
+        // Reports what happens in the game to a_telemetry from now on, starting with the game
+        // itself; nullptr stops it. a_telemetry must outlive the simulation, or be unset first.
+        void setTelemetry(Telemetry *a_telemetry);
+
+        // // // MUTATORS // // //
+
+        // Applies a player's action. Returns whether it changed anything: moving into a wall, or
+        // any piece action while no piece is falling, does nothing.
+        bool apply(Action a_action);
+
+        // Advances the game by one tick (one frame at normal speed).
+        void tick();
+
+        // Queues a_rows rows of garbage, with their hole in column a_hole, to be pushed into the
+        // well from below. Garbage that would fill more than the whole well is dropped.
+        void addGarbage(unsigned int a_rows, unsigned int a_hole);
+
+        // Takes up to a_rows rows off the garbage queue, oldest first, and returns how many of
+        // a_rows are left over.
+        unsigned int cancelGarbage(unsigned int a_rows);
+
+        // // // OBSERVERS // // //
+
+        Snapshot snapshot() const;
+
+        StandardWell & getWell();
+        StandardWell const& getWell() const;
+
+        // The rows being cleared while the clearing effect runs; otherwise empty.
+        std::vector<unsigned int> const& getClearingRows() const;
+
+        bool isFalling() const;
+        bool isOver() const;
+
+        // The rows of garbage queued and not yet pushed in.
+        unsigned int getPendingGarbage() const;
+
+        std::uint32_t getSeed() const;
+        unsigned int getInitialSpeed() const;
+        std::uint64_t getTicks() const;
+
+        // A checksum of every state the simulation has been in after a tick, updated as it ticks:
+        // two runs that ever differ, in any part of the state, have different checksums from then
+        // on (barring collisions). Replays carry it, to catch a change to the rules or a platform
+        // that plays a game differently.
+        std::uint32_t getChecksum() const;
+
+        unsigned int getScore() const;
+        unsigned int getLevel() const;
+        unsigned int getClearedLines() const;
+
+    private:
+        // Where the piece that landed last is at in its lock sequence.
+        enum class LockPhase : std::uint8_t
+        {
+            none,     // a piece is falling
+            settling, // the piece has landed, the rows are checked after lockDelay ticks
+            clearing, // full rows are shown being cleared for clearDelay ticks
+        };
+
+        // Will increase the score according to the full rows in a_rows, increase the count of cleared rows, remove the rows, and call handleSpeed.
+        void handleRows(std::vector<unsigned int> const& a_rows);
+
+        // Will effectively increase m_speed for every speedStep lines cleared, up to speedLimit.
+        void handleSpeed();
+
+        // Starts the lock sequence for the piece that just landed.
+        void handleNewPiece();
+
+        // Generates a new piece, and checks for game over.
+        void handleGenNewPiece();
+
+        // What happens after a piece lands: a pause, then the clearing effect if rows are full,
+        // then the next piece. Starts a_ticks before the end of a_phase, so that a restored
+        // simulation can continue a sequence where it was saved.
+        Task lockPiece(LockPhase a_phase = LockPhase::settling, unsigned int a_ticks = lockDelay);
+
+        // Pushes the queued garbage into the well; the game is over if that pushes blocks out.
+        void handleGarbage();
+
+        // Records an event in m_telemetry, if there is one.
+        void report(TelemetryEvent::Type a_type, std::uint32_t a_a = 0, std::uint32_t a_b = 0);
+
+        StandardWell m_well;
+
+        Scheduler m_scheduler; // ticked once per tick
+        Task m_lockScript;     // after m_scheduler, which it waits on
+        LockPhase m_lockPhase;
+
+        std::vector<unsigned int> m_clearingRows;
+
+        struct Garbage
+        {
+            unsigned int rows, hole;
+        };
+
+        std::vector<Garbage> m_garbage; // oldest first
+        unsigned int m_pendingGarbage;  // the rows in m_garbage
+
+        bool m_fallFaster, m_falling, m_over;
+
+        std::uint32_t m_seed;
+        unsigned int m_initialSpeed;
+        std::uint64_t m_ticks;
+        std::uint32_t m_checksum;
+
+        unsigned int m_time;  // how long has the current piece been in the well
+        unsigned int m_score; // the player's score
+        unsigned int m_clearedLines;
+        unsigned int m_speed; // the inverse speed of the falling blocks
+
+        Telemetry *m_telemetry; // not owned
+};
+
+#endif
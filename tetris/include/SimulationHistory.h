@@ -0,0 +1,54 @@
+#ifndef SIMULATIONHISTORY_H
+#define SIMULATIONHISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Simulation.h"
+
+// The last ticks of a simulation, in a ring that is allocated once: for each tick, the snapshot
+// taken before it. It is fed after every tick, like a ReplayRecorder's `afterTick`.
+//
+// With it a simulation can be rewound to any tick still in the ring, for practice mode's undo.
+class SimulationHistory final
+{
+    public:
+        // Keeps the last a_capacity ticks.
+        explicit SimulationHistory(std::size_t a_capacity);
+
+        // // // MUTATORS // // //
+
+        // Forgets everything, and starts again from a_simulation as it is now.
+        void reset(Simulation const& a_simulation);
+
+        // Called after every tick of a_simulation. A simulation that did not advance by exactly
+        // one tick since the last call (it was restored elsewhere, say) starts the history again.
+        void afterTick(Simulation const& a_simulation);
+
+        // Restores a_simulation to how it was before a_tick, forgetting the ticks after. Returns
+        // false, without doing anything, if a_tick is not kept.
+        bool rewind(Simulation & a_simulation, std::uint64_t a_tick);
+
+        // // // OBSERVERS // // //
+
+        bool isEmpty() const;
+        std::uint64_t getOldestTick() const;
+        std::uint64_t getNewestTick() const;
+
+        // The snapshot taken before a_tick, or nullptr if a_tick is not kept.
+        Simulation::Snapshot const* find(std::uint64_t a_tick) const;
+
+    private:
+        // The snapshot for a_tick, which must be kept.
+        Simulation::Snapshot & at(std::uint64_t a_tick);
+        Simulation::Snapshot const& at(std::uint64_t a_tick) const;
+
+        bool contains(std::uint64_t a_tick) const;
+
+        std::vector<Simulation::Snapshot> m_snapshots;
+        std::size_t m_oldest; // index of the oldest snapshot
+        std::size_t m_size;
+};
+
+#endif
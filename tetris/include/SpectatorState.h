@@ -0,0 +1,62 @@
+#ifndef SPECTATORSTATE_H
+#define SPECTATORSTATE_H
+
+#include <memory>
+#include <vector>
+
+#include "State.h"
+#include "util_SDL.h"
+#include "Match.h"
+#include "Bot.h"
+#include "GlyphAtlas.h"
+#include "WellGrid.h"
+
+class Application;
+
+// Bots playing each other, many games at once, to watch: two-board matches side by side in a
+// scaled-down grid (see WellGrid). The first bot of each match plays with Bot::defaultWeights, the
+// second with those weights changed at random, as in the tournament tool. A finished match stays
+// on screen for a moment, then starts again with a new seed. <Escape> goes back to the menu.
+class SpectatorState final
+    : public State
+{
+    public:
+        SpectatorState(const Application* a_owner, unsigned int a_boards);
+
+        virtual void load() override;
+        virtual void activate() override;
+        virtual void update() override;
+        virtual void handleEvent(SDL_Event const& event, Uint32 a_time) override;
+        virtual void draw(Surface_ptr const& a_parent) override;
+
+        static constexpr unsigned int defaultBoards = 16;
+        static constexpr unsigned int maxBoards = 64;
+        static constexpr unsigned int botMoveTicks = 4; // ticks between the bots' actions, to be watchable
+        static const unsigned int restartTicks = 120; // how long a finished match stays on screen
+        static constexpr unsigned int maxBlockSide = 16;
+        static const unsigned int boardSpacing = 8;   // pixels between boards, and around the grid
+
+    private:
+        const Application *getOwner()
+        {
+            return (const Application*)m_parent;
+        }
+
+        unsigned int m_boards;
+
+        std::vector<std::unique_ptr<Match>> m_matches; // made when activated
+        std::vector<Bot> m_bots;                       // two per match
+        std::vector<unsigned int> m_finishedTicks;     // since each match ended
+
+        std::uint32_t m_nextSeed;
+        unsigned int m_matchesPlayed;
+
+        WellGrid m_grid;
+        SDL_Rect m_gridPosition;
+
+        GlyphAtlas_ptr m_statusAtlas;
+        char m_statusText[48];
+        unsigned int m_shownMatches; // in m_statusText
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+#include <string>
+#include <vector>
+
+#include "Instrumentation.h"
+
+/** Times the phases of startup, up to the first frame on screen. Every mark records how long it
+ * has been since the profile was created, which the application does first thing in main.
+ */
+class StartupProfile final
+{
+    public:
+        StartupProfile();
+
+        void setEnabled(bool a_enabled);
+        bool isEnabled() const;
+
+        /** a_phase has just finished.
+         */
+        void mark(const char *a_phase);
+
+        /** Prints each phase with its own duration and the time since start to stderr.
+         */
+        void report() const;
+
+    private:
+        struct Mark
+        {
+            const char *phase;
+            Instrumentation::Micros at;
+        };
+
+        bool m_enabled;
+        Instrumentation::Micros m_start;
+        std::vector<Mark> m_marks;
+};
+
+#endif
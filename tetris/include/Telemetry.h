@@ -0,0 +1,96 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RingBuffer.h"
+
+/** Something that happened in a game, for play analytics. What a and b hold depends on the type.
+ */
+struct TelemetryEvent
+{
+    enum class Type : std::uint8_t
+    {
+        gameStarted,  // a: seed, b: initial speed
+        pieceSpawned, // a: piece, b: next piece
+        pieceMoved,   // a: 0 left, 1 right
+        pieceRotated, // a: 0 counterclockwise, 1 clockwise
+        pieceLocked,  // a: piece, b: 1 if it was dropped, 0 if it fell
+        rowsCleared,  // a: rows, b: score after
+        levelUp,      // a: level
+        gameOver,     // a: score, b: lines
+        count
+    };
+
+    Type type;
+    std::uint64_t tick; // of the simulation, when it happened
+    std::uint32_t a, b;
+};
+
+/** A stream of game events, written to a file by a background thread so that recording them costs
+ * the game thread no more than a push onto a lock-free ring buffer; the game thread never blocks,
+ * allocates or touches the file. Events are recorded from one thread only, the game thread.
+ *
+ * The writer takes events off the ring in batches and writes each batch as a block of columns,
+ * which compress well and can be read a column at a time:
+ *
+ *     "TTEL"  u8 version
+ *     blocks, each:
+ *         u32 count  u32 size (of the rest of the block)
+ *         count types, a byte each
+ *         count zigzag varint ticks, the first absolute, the others since the previous event
+ *         count varint a
+ *         count varint b
+ *
+ * Fixed-size numbers are little-endian; varints as in Replay. If the ring fills up faster than
+ * the writer drains it, events are dropped and counted rather than waited for.
+ */
+class Telemetry final
+{
+    public:
+        static const std::uint8_t version = 1;
+
+        /** Opens a_path for writing, and starts the writer if it could be opened.
+         */
+        explicit Telemetry(std::string const& a_path);
+
+        /** Writes out every event recorded so far, then stops the writer.
+         */
+        ~Telemetry();
+
+        Telemetry(Telemetry const&) = delete;
+        Telemetry & operator=(Telemetry const&) = delete;
+
+        bool isOpen() const;
+
+        // // // RECORDING (game thread) // // //
+
+        void record(TelemetryEvent::Type a_type, std::uint64_t a_tick, std::uint32_t a_a = 0, std::uint32_t a_b = 0);
+
+        /** Events lost because the ring was full.
+         */
+        std::uint64_t getDropped() const;
+
+    private:
+        static const std::size_t ringSize = 8192;
+        static const std::size_t batchSize = 1024;
+
+        void run();
+        void writeBlock(std::vector<TelemetryEvent> const& a_events);
+
+        std::FILE *m_file;
+        RingBuffer<TelemetryEvent, ringSize> m_ring;
+        std::uint64_t m_dropped;
+
+        std::vector<unsigned char> m_block; // the writer's, reused for every block
+        std::atomic<bool> m_stopping;
+
+        std::thread m_thread; // last, so that it starts once everything else is constructed
+};
+
+#endif
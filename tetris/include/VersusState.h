@@ -0,0 +1,71 @@
+#ifndef VERSUSSTATE_H
+#define VERSUSSTATE_H
+
+#include <memory>
+#include <vector>
+
+#include "State.h"
+#include "util_SDL.h"
+#include "GameOverState.h"
+#include "Match.h"
+#include "Bot.h"
+#include "AutoShift.h"
+#include "GlyphAtlas.h"
+#include "WellRenderer.h"
+
+class Application;
+
+// A versus match on screen: the player on the first board, with the same keys as Game, against
+// bots on the others. Rows the player clears send garbage to the bots, and theirs to the player.
+// The boards are scaled down to fit the screen side by side. Versus games are not recorded or
+// ranked.
+class VersusState final
+    : public State
+{
+    public:
+        VersusState(const Application* a_owner, unsigned int a_boards, unsigned int a_initialSpeed);
+
+        virtual void load() override;
+        virtual void activate() override;
+        virtual void update() override;
+        virtual void handleEvent(SDL_Event const& event, Uint32 a_time) override;
+        virtual void draw(Surface_ptr const& a_parent) override;
+
+        // May be called while the state is being loaded in the background, but not once it runs.
+        void setInitialSpeed(unsigned int a_speed);
+
+        static const unsigned int defaultBoards = 4;
+        static const unsigned int botMoveTicks = 8; // ticks between the bots' actions, so they can be beaten
+        static constexpr unsigned int maxBlockSide = 32;
+        static const unsigned int boardSpacing = 16; // pixels between boards, and around them
+
+    private:
+        // Applies the auto-repeat shifts of a held direction key that became due up to a_time.
+        void handleAutoShift(Uint32 a_time);
+
+        // Once the player is out or the match is decided: moves on to the game over screen.
+        void handleGameOver();
+
+        const Application *getOwner()
+        {
+            return (const Application*)m_parent;
+        }
+
+        unsigned int m_boards, m_initialSpeed;
+
+        std::unique_ptr<Match> m_match; // made when activated, once the speed is settled
+        std::vector<Bot> m_bots;        // for the boards after the first
+
+        AutoShift m_autoShift;
+
+        WellRenderer m_renderer;
+        std::vector<SDL_Rect> m_boardPositions;
+
+        GlyphAtlas_ptr m_scoreAtlas;
+        char m_scoreText[Match::maxBoards][16]; // each board's score, as last drawn
+        std::vector<unsigned int> m_shownScores;
+
+        std::shared_ptr<GameOverState> m_nextGameOver; // prewarmed while the match runs
+};
+
+#endif
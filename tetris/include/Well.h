@@ -2,7 +2,17 @@
 #define WELL_H
 
 #include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "FixedVector.h"
+#include "AllocAccounting.h"
 
 extern const char PIECES[7][4][5][5];
 
@@ -25,6 +35,11 @@ struct Block
     Point location;
     BlockState type;
 
+    Block()
+        : location(0, 0), type(BlockState::falling)
+    {
+    }
+
     Block(Point p, BlockState t)
         : location(p), type(t)
     {
@@ -36,11 +51,307 @@ struct Block
     }
 };
 
-class Well final
+// // // STORAGE // // //
+
+// A well's fallen blocks are kept by a storage policy, which BasicWell is specialized on:
+//
+//     bool get(x, y) const, void set(x, y, bool)
+//     unsigned int getWidth() const, getHeight() const
+//     bool isRowFull(y) const
+//     unsigned int nextOccupiedRow(y) const  a row r >= y such that the rows in [y, r) are empty: the
+//                                            first occupied one, or just y where finding it is slow
+//     void forEachFullRow(f) const           calls f(y) for every full row, top to bottom
+//     void forEachOccupiedRow(first, last, f) const
+//                                            calls f(y) for every row in [first, last) with blocks
+//     void removeRows(rows)                  removes the sorted rows, shifting down the rows above
+//     bool insertRows(count, hole)           shifts every row up by count, and fills the count rows
+//                                            freed at the bottom but for column hole; returns false
+//                                            if blocks were pushed out at the top
+//     void clear()
+//
+// The well checks coordinates against the dimensions before it calls get or set.
+
+/** Any size, chosen at run time, for custom boards.
+ */
+class DynamicRows final
 {
     public:
-        typedef std::vector<std::vector<bool>> WellMatrix;
-        typedef std::vector<Block> Piece;
+        typedef std::vector<std::vector<bool>> WellMatrix; // indexed [x][y]
+
+        DynamicRows(unsigned int a_width, unsigned int a_height);
+        explicit DynamicRows(WellMatrix a_initialWell);
+
+        unsigned int getWidth() const { return m_width; }
+        unsigned int getHeight() const { return m_height; }
+
+        bool get(unsigned int x, unsigned int y) const { return m_cells[x][y]; }
+        void set(unsigned int x, unsigned int y, bool b) { m_cells[x][y] = b; }
+
+        bool isRowFull(unsigned int y) const;
+        bool isRowEmpty(unsigned int y) const;
+
+        // Scanning would cost more than letting a piece fall row by row.
+        unsigned int nextOccupiedRow(unsigned int y) const
+        {
+            return y;
+        }
+
+        template<typename F>
+        void forEachFullRow(F && f) const
+        {
+            for ( unsigned int y = 0; y < m_height; y++ )
+                if ( isRowFull(y) )
+                    f(y);
+        }
+
+        template<typename F>
+        void forEachOccupiedRow(unsigned int a_first, unsigned int a_last, F && f) const
+        {
+            for ( unsigned int y = a_first; y < a_last && y < m_height; y++ )
+                if ( ! isRowEmpty(y) )
+                    f(y);
+        }
+
+        void removeRows(std::vector<unsigned int> const& a_rows);
+        bool insertRows(unsigned int a_count, unsigned int a_hole);
+        void clear();
+
+    private:
+        WellMatrix m_cells;
+        unsigned int m_width, m_height;
+};
+
+/** The narrowest unsigned type with at least Bits bits.
+ */
+template<unsigned int Bits>
+struct RowWord
+{
+    static_assert(Bits > 0 && Bits <= 64, "rows are at most 64 blocks wide");
+
+    typedef typename std::conditional<Bits <= 8, std::uint8_t,
+            typename std::conditional<Bits <= 16, std::uint16_t,
+            typename std::conditional<Bits <= 32, std::uint32_t, std::uint64_t>::type>::type>::type type;
+};
+
+/** A size fixed at compile time, for the standard board. Each row is a bit mask in the narrowest
+ * word that holds it, so testing or clearing a row is a single comparison or store, and the loops
+ * over the rows are unrolled.
+ */
+template<unsigned int Width, unsigned int Height>
+class FixedRows final
+{
+    public:
+        typedef typename RowWord<Width>::type Row;
+
+        static constexpr unsigned int width = Width;
+        static constexpr unsigned int height = Height;
+        static constexpr Row fullRow = Row(Row(~Row(0)) >> (sizeof(Row) * 8 - Width));
+
+        static_assert(Height > 0, "a well has at least one row");
+
+        FixedRows()
+            : m_rows()
+        {
+        }
+
+        static constexpr unsigned int getWidth() { return Width; }
+        static constexpr unsigned int getHeight() { return Height; }
+
+        bool get(unsigned int x, unsigned int y) const
+        {
+            return (m_rows[y] >> x) & 1;
+        }
+
+        void set(unsigned int x, unsigned int y, bool b)
+        {
+            if ( b )
+                m_rows[y] |= Row(Row(1) << x);
+            else
+                m_rows[y] &= Row(~(Row(1) << x));
+        }
+
+        bool isRowFull(unsigned int y) const
+        {
+            return m_rows[y] == fullRow;
+        }
+
+        // A row's blocks as a mask, bit x for column x, for saving and restoring a well.
+        Row getRow(unsigned int y) const
+        {
+            return m_rows[y];
+        }
+
+        void setRow(unsigned int y, Row a_row)
+        {
+            m_rows[y] = a_row & fullRow;
+        }
+
+        unsigned int nextOccupiedRow(unsigned int y) const
+        {
+            while ( y < Height && m_rows[y] == 0 )
+                y++;
+            return y;
+        }
+
+        template<typename F>
+        void forEachFullRow(F && f) const
+        {
+            forEachFullRow(f, std::make_integer_sequence<unsigned int, Height>());
+        }
+
+        template<typename F>
+        void forEachOccupiedRow(unsigned int a_first, unsigned int a_last, F && f) const
+        {
+            for ( unsigned int y = a_first; y < a_last && y < Height; y++ )
+                if ( m_rows[y] != 0 )
+                    f(y);
+        }
+
+        void removeRows(std::vector<unsigned int> const& a_rows)
+        {
+            for ( auto y : a_rows )
+            {
+                std::copy_backward(m_rows, m_rows + y, m_rows + y + 1);
+                m_rows[0] = 0;
+            }
+        }
+
+        bool insertRows(unsigned int a_count, unsigned int a_hole)
+        {
+            a_count = std::min(a_count, Height);
+
+            bool kept = std::all_of(m_rows, m_rows + a_count, [] (Row a_row) { return a_row == 0; });
+
+            std::copy(m_rows + a_count, m_rows + Height, m_rows);
+            std::fill(m_rows + Height - a_count, m_rows + Height, Row(fullRow & ~(Row(1) << a_hole)));
+
+            return kept;
+        }
+
+        void clear()
+        {
+            std::fill(m_rows, m_rows + Height, Row(0));
+        }
+
+    private:
+        template<typename F, unsigned int... Y>
+        void forEachFullRow(F & f, std::integer_sequence<unsigned int, Y...>) const
+        {
+            ((m_rows[Y] == fullRow ? f(Y) : void()), ...);
+        }
+
+        Row m_rows[Height];
+};
+
+/** Any size, for stress testing with wells far taller than the screen, such as 256 x 1000000.
+ *
+ * Rows are grouped in chunks of chunkRows, and only chunks that hold blocks are stored, so memory
+ * and the cost of iterating, clearing and removing rows follow the rows that are occupied rather
+ * than the height. Each chunk keeps a mask of its occupied and of its full rows, so finding them
+ * does not look at the blocks.
+ */
+class ChunkedRows final
+{
+    public:
+        static const unsigned int chunkRows = 64;
+
+        ChunkedRows(unsigned int a_width, unsigned int a_height);
+
+        unsigned int getWidth() const { return m_width; }
+        unsigned int getHeight() const { return m_height; }
+
+        bool get(unsigned int x, unsigned int y) const;
+        void set(unsigned int x, unsigned int y, bool b);
+
+        bool isRowFull(unsigned int y) const;
+        unsigned int nextOccupiedRow(unsigned int y) const;
+
+        template<typename F>
+        void forEachFullRow(F && f) const
+        {
+            for ( auto const& c : m_chunks )
+                forEachBit(c.second.full, c.first, f);
+        }
+
+        template<typename F>
+        void forEachOccupiedRow(unsigned int a_first, unsigned int a_last, F && f) const
+        {
+            for ( auto c = m_chunks.lower_bound(a_first / chunkRows); c != m_chunks.end(); c++ )
+            {
+                std::uint64_t rows = c->second.occupied;
+                unsigned int base = c->first * chunkRows;
+
+                if ( base >= a_last )
+                    break;
+                if ( a_first > base )
+                    rows &= ~std::uint64_t(0) << (a_first - base);
+                if ( a_last - base < chunkRows )
+                    rows &= ~(~std::uint64_t(0) << (a_last - base));
+
+                forEachBit(rows, c->first, f);
+            }
+        }
+
+        void removeRows(std::vector<unsigned int> const& a_rows);
+        bool insertRows(unsigned int a_count, unsigned int a_hole);
+        void clear();
+
+        // The number of chunks stored, for diagnostics.
+        std::size_t getChunkCount() const { return m_chunks.size(); }
+
+    private:
+        struct Chunk
+        {
+            std::uint64_t occupied, full;       // a bit per row
+            std::uint32_t counts[chunkRows];    // the blocks in each row
+            std::vector<std::uint64_t> bits;    // chunkRows rows of m_words words
+        };
+
+        template<typename F>
+        static void forEachBit(std::uint64_t a_rows, unsigned int a_chunk, F & f)
+        {
+            while ( a_rows != 0 )
+            {
+                f(a_chunk * chunkRows + std::countr_zero(a_rows));
+                a_rows &= a_rows - 1;
+            }
+        }
+
+        // The chunk holding row y, if any.
+        Chunk const* find(unsigned int y) const;
+
+        std::map<unsigned int, Chunk>::iterator addChunk(unsigned int a_index);
+
+        // Moves row a_from, which has blocks, to the empty row a_to.
+        void moveRow(unsigned int a_from, unsigned int a_to);
+        void clearRow(unsigned int y);
+
+        std::map<unsigned int, Chunk> m_chunks; // by chunk index
+        unsigned int m_width, m_height;
+        unsigned int m_words;                   // words per row
+};
+
+// // // WELL // // //
+
+template<typename Storage>
+class BasicWell final
+{
+    public:
+        typedef Storage StorageType;
+        static const unsigned int maxPieceBlocks = 4;
+
+        // Stored inline, since pieces are copied on every move and rotation.
+        typedef FixedVector<Block, maxPieceBlocks> Piece;
+
+        // Everything about the well besides its fallen blocks: the falling piece and where the
+        // sequence of pieces is at.
+        struct PieceState
+        {
+            Piece piece;
+            unsigned int pieceID, nextPieceID;
+            int rotationID;
+            std::uint32_t randomState;
+        };
 
         // simply returns true iff b is pivot or falling.
         static bool isPieceComponent(BlockState b)
@@ -49,12 +360,23 @@ class Well final
         }
 
         // // // CONSTRUCTORS // // // 
-        
-        Well(unsigned int a_width, unsigned int a_height);
-        Well(WellMatrix a_initialWell);
+
+        // The arguments are passed on to the storage: a width and a height, or an initial matrix,
+        // for DynamicRows, and none for FixedRows.
+        template<typename... Args>
+        explicit BasicWell(Args&&... a_storageArgs)
+            : m_storage(std::forward<Args>(a_storageArgs)...)
+        {
+            init();
+        }
 
         // // // MUTATORS // // //  
 
+        // Restarts the sequence of pieces from a_seed, picking the next piece anew. The same seed
+        // gives the same pieces on every platform, which replays rely on. Wells are seeded randomly
+        // when constructed.
+        void seed(std::uint32_t a_seed);
+
         // Effects gravity onto the falling piece, checking and handling collision.
         // The return value represents whether the piece has been set into fallen blocks.
         bool updatePiece();
@@ -78,25 +400,68 @@ class Well final
         // WARNING: the list of rows to remove must be sorted !
         void removeRows(std::vector<unsigned int> const& a_rows);
 
+        // Pushes a_count rows of garbage in at the bottom, full but for column a_hole, shifting up
+        // the rows above; the falling piece is pushed up too if it would overlap them. Returns
+        // false if that pushed blocks out of the top of the well, which ends a game.
+        bool insertGarbageRows(unsigned int a_count, unsigned int a_hole);
+
+        // Removes every fallen block. The falling piece is kept.
+        void clear();
+
+        // Puts the well back into a state saved with getStorage and getPieceState.
+        void restore(Storage const& a_storage, PieceState const& a_state);
+
         // // // OBSERVERS // // // 
 
-        // A list of rows that are full.
-        std::vector<unsigned int> getFullRows() const;
+        // A list of rows that are full, in a_allocator's memory: the heap by default, or for example
+        // a FrameArena for a list that is only needed for the current frame.
+        template<typename Allocator = std::allocator<unsigned int>>
+        std::vector<unsigned int, Allocator> getFullRows(Allocator const& a_allocator = Allocator()) const
+        {
+            ALLOC_TAG(well);
+
+            std::vector<unsigned int, Allocator> fullRows(a_allocator);
+
+            m_storage.forEachFullRow([&fullRows] (unsigned int y)
+                    {
+                        fullRows.push_back(y);
+                    });
 
-        // A representation of the current well.
-        WellMatrix const& getWell() const;
+            return fullRows;
+        }
+
+        // Whether there is a fallen block at (x, y), which must be inside the well.
+        bool isOccupied(unsigned int x, unsigned int y) const
+        {
+            return m_storage.get(x, y);
+        }
+
+        // Calls f(y) for every row in [a_first, a_last) that has fallen blocks, top to bottom.
+        template<typename F>
+        void forEachOccupiedRow(unsigned int a_first, unsigned int a_last, F && f) const
+        {
+            m_storage.forEachOccupiedRow(a_first, a_last, f);
+        }
 
         Piece const& getPiece() const;
 
         // A Piece representing the current piece as if `fall` had hypothetically been called.
         Piece getFallenPiece();
 
-        unsigned int getWellWidth() const;
-        unsigned int getWellHeight() const;
+        unsigned int getWellWidth() const { return m_storage.getWidth(); }
+        unsigned int getWellHeight() const { return m_storage.getHeight(); }
         unsigned int getNextPieceID() const;
         unsigned int getPieceID() const;
 
+        Storage const& getStorage() const;
+        PieceState getPieceState() const;
+
     private:
+        // Advances the sequence of pieces, returning the next one.
+        unsigned int randomPiece();
+
+        void init();
+
         // Iterates over the blocks in the piece, and changes the corresponding locations in the well
         // to being occupied.
         void collidePiece(Piece const& p);
@@ -120,21 +485,35 @@ class Well final
 
         Piece rotatePiece(Piece const& piece, Direction d);
 
-        bool getBlock(Point const& p) const;
-        void setBlock(Point const& p, bool b);
-
-        WellMatrix m_well;
+        Storage m_storage;
         Piece m_piece; 
 
-        Piece m_fallenPieceMemo;
+        // The last piece getFallenPiece was asked about, and its answer. Cleared whenever the
+        // fallen blocks change.
+        Piece m_fallenPieceMemo, m_fallenPiece;
         unsigned int m_fallenPieceMemoID;
         
-        unsigned int m_wellWidth, m_wellHeight;
         unsigned int m_pieceID, m_nextPieceID;
         int m_rotationID;
 
-        std::default_random_engine m_rengine;
-        std::uniform_int_distribution<int> m_rdistribution;
+        // The state of the piece generator, which is std::minstd_rand's: both it and the way it is
+        // reduced to a piece are fully specified, unlike std::default_random_engine and
+        // std::uniform_int_distribution. It is kept as a plain number so that it can be saved.
+        std::uint32_t m_randomState;
 };
 
+// A well of any size, for custom boards.
+typedef BasicWell<DynamicRows> Well;
+
+// The standard 10x20 board that Game plays on.
+typedef BasicWell<FixedRows<10, 20>> StandardWell;
+
+// A well of any size that only stores its occupied rows, for stress tests.
+typedef BasicWell<ChunkedRows> HugeWell;
+
+// These are compiled once, in Well.cpp.
+extern template class BasicWell<DynamicRows>;
+extern template class BasicWell<FixedRows<10, 20>>;
+extern template class BasicWell<ChunkedRows>;
+
 #endif
@@ -0,0 +1,93 @@
+#ifndef WELLGRID_H
+#define WELLGRID_H
+
+#include <cstdint>
+#include <vector>
+
+#include "util_SDL.h"
+#include "Simulation.h"
+
+/** Many wells drawn scaled down into one surface, for watching dozens of games at once.
+ *
+ * Drawing each cell with a blit of its own costs a blit per cell per board, over ten thousand a
+ * frame for 64 boards. Instead, each board remembers what each of its rows showed when it was last
+ * drawn (the fallen blocks, the falling piece's blocks and whether the row is being cleared), and
+ * only rows that look different are drawn again, straight into the grid's pixels: a block row is
+ * two scanlines, one through the middle of the empty cells' squares and one above and below them,
+ * each built once and copied down the block's height. A board that did not change costs a
+ * comparison of its rows, and the whole grid reaches the screen in one blit.
+ *
+ * The grid's surface has 32 bits per pixel, in the screen's layout when that has 32 bits too, so
+ * the blit is a plain copy.
+ */
+class WellGrid final
+{
+    public:
+        typedef StandardWell::StorageType Rows;
+
+        WellGrid();
+
+        /** Lays out a_boards boards in the grid of columns and rows that gives them the largest
+         * blocks, of at most a_maxBlockSide, within a_width x a_height pixels; a_gap pixels apart.
+         * Allocates the grid, which starts with every board empty.
+         */
+        void load(unsigned int a_boards, unsigned int a_width, unsigned int a_height, unsigned int a_maxBlockSide,
+                  unsigned int a_gap, SDL_PixelFormat const* a_screenFormat);
+
+        /** Draws the rows of board a_board that look different from when it was last drawn.
+         * Returns whether there were any.
+         */
+        bool update(unsigned int a_board, Simulation const& a_simulation);
+
+        /** Blits the whole grid with its top-left corner at (a_x, a_y).
+         */
+        void draw(SDL_Surface *a_target, short a_x, short a_y) const;
+
+        unsigned int getBlockSide() const;
+        unsigned int getWidth() const;
+        unsigned int getHeight() const;
+
+        /** The rows drawn by update since the grid was loaded, for measuring.
+         */
+        std::uint64_t getRowsDrawn() const;
+
+    private:
+        // How a board row looked when it was last drawn.
+        struct RowLook
+        {
+            Rows::Row fallen, piece;
+            bool clearing;
+
+            bool operator==(RowLook const&) const = default;
+        };
+
+        struct Board
+        {
+            unsigned int x, y; // of its top-left cell in the grid, in pixels
+            RowLook rows[Rows::height];
+            unsigned int pending; // the garbage rows its bar shows
+        };
+
+        // Draws row a_row of a_board as a_look, into pixels the caller has locked.
+        void drawRow(Board const& a_board, unsigned int a_row, RowLook const& a_look);
+
+        // Draws a_board's garbage bar a_pending rows tall.
+        void drawBar(Board const& a_board, unsigned int a_pending);
+
+        // Fills a_count pixels from a_x, a_y with a_color.
+        void fillPixels(unsigned int a_x, unsigned int a_y, unsigned int a_count, Uint32 a_color);
+
+        Uint32 * pixelRow(unsigned int a_y);
+
+        unsigned int m_blockSide, m_inset, m_squareSide, m_barWidth;
+        Surface_ptr m_surface;
+        std::vector<Board> m_boards;
+
+        std::vector<Uint32> m_edgeLine, m_middleLine; // scratch, a well wide
+
+        Uint32 m_emptyColor, m_squareColor, m_fallenColor, m_pieceColor, m_clearedColor, m_garbageColor;
+
+        std::uint64_t m_rowsDrawn;
+};
+
+#endif
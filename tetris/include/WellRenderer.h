@@ -0,0 +1,41 @@
+#ifndef WELLRENDERER_H
+#define WELLRENDERER_H
+
+#include "util_SDL.h"
+#include "Simulation.h"
+
+/** Draws a simulation's well at any block size, for the screens that show several wells at once.
+ *
+ * The empty well is rendered once, at load, and drawn with one blit; only the cells that hold
+ * blocks are then filled in on top of it, a rectangle each, so a well costs a blit plus a fill per
+ * block rather than a blit per cell.
+ */
+class WellRenderer final
+{
+    public:
+        WellRenderer();
+
+        /** Renders the empty well for blocks of a_blockSide pixels, in a_format's colors.
+         */
+        void load(unsigned int a_blockSide, SDL_PixelFormat const* a_format);
+
+        /** Draws a_simulation's well with its top-left corner at (a_x, a_y): the fallen blocks, the
+         * falling piece, the rows being cleared, and, to the left of the well, a bar as tall as the
+         * garbage on its way. a_ghost also shows where the piece would land.
+         */
+        void draw(Simulation & a_simulation, SDL_Surface *a_target, short a_x, short a_y, bool a_ghost = false) const;
+
+        unsigned int getBlockSide() const;
+        unsigned int getWidth() const;
+        unsigned int getHeight() const;
+
+    private:
+        // Fills the cell at (a_column, a_row) of a well drawn at (a_x, a_y).
+        void fillCell(SDL_Surface *a_target, short a_x, short a_y, unsigned int a_column, unsigned int a_row, Uint32 a_color) const;
+
+        unsigned int m_blockSide;
+        Surface_ptr m_background;
+        Uint32 m_fallenColor, m_pieceColor, m_ghostColor, m_clearedColor, m_garbageColor;
+};
+
+#endif
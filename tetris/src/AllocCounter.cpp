@@ -0,0 +1,219 @@
+#include "AllocCounter.h"
+#include "AllocAccounting.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::uint64_t> allocations(0), deallocations(0);
+static thread_local std::uint64_t threadAllocations = 0;
+
+std::uint64_t getAllocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+std::uint64_t getThreadAllocationCount()
+{
+    return threadAllocations;
+}
+
+std::uint64_t getDeallocationCount()
+{
+    return deallocations.load(std::memory_order_relaxed);
+}
+
+#ifdef ENABLE_ALLOC_ACCOUNTING
+
+namespace
+{
+    const unsigned int tagCount = (unsigned int)AllocTag::count;
+
+    // Put in front of every allocation, so that freeing knows what to charge. Its size keeps the
+    // memory after it as aligned as malloc's.
+    struct alignas(alignof(std::max_align_t)) Header
+    {
+        std::size_t size;
+        AllocTag tag;
+    };
+
+    struct TagStats
+    {
+        std::atomic<std::uint64_t> allocations, liveBytes, peakBytes;
+
+        // Kept by frameEnded, on the main thread.
+        std::uint64_t allocationsAtLastFrame, maxPerFrame;
+    };
+
+    TagStats stats[tagCount];
+    std::uint64_t frames = 0, firstFrameAllocations[tagCount];
+
+    thread_local AllocTag currentTag = AllocTag::untagged;
+
+    const char * const tagNames[tagCount] = { "untagged", "well", "effects", "rendering", "ttf" };
+}
+
+static void * countedAllocate(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    threadAllocations++;
+
+    Header *header = (Header*)std::malloc(sizeof(Header) + size);
+    if ( header == nullptr )
+        return nullptr;
+
+    header->size = size;
+    header->tag = currentTag;
+
+    TagStats &tag = stats[(unsigned int)header->tag];
+    tag.allocations.fetch_add(1, std::memory_order_relaxed);
+
+    std::uint64_t live = tag.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::uint64_t peak = tag.peakBytes.load(std::memory_order_relaxed);
+    while ( live > peak && ! tag.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed) )
+        ;
+
+    return header + 1;
+}
+
+static void countedFree(void *ptr)
+{
+    if ( ptr == nullptr )
+        return;
+
+    deallocations.fetch_add(1, std::memory_order_relaxed);
+
+    Header *header = (Header*)ptr - 1;
+    stats[(unsigned int)header->tag].liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+    std::free(header);
+}
+
+allocAccounting::Scope::Scope(AllocTag a_tag)
+    : m_previous(currentTag)
+{
+    currentTag = a_tag;
+}
+
+allocAccounting::Scope::~Scope()
+{
+    currentTag = m_previous;
+}
+
+void allocAccounting::frameEnded()
+{
+    for ( unsigned int i = 0; i < tagCount; i++ )
+    {
+        std::uint64_t now = stats[i].allocations.load(std::memory_order_relaxed);
+
+        if ( frames == 0 )
+            firstFrameAllocations[i] = now;
+        else
+            stats[i].maxPerFrame = std::max(stats[i].maxPerFrame, now - stats[i].allocationsAtLastFrame);
+
+        stats[i].allocationsAtLastFrame = now;
+    }
+
+    frames++;
+}
+
+void allocAccounting::report(std::ostream & a_out)
+{
+    char line[128];
+
+    a_out << "Allocations by tag, over " << (frames > 0 ? frames - 1 : 0) << " frames" << std::endl;
+    std::snprintf(line, sizeof(line), "%-12s %12s %10s %10s %14s %14s", "",
+                  "total", "avg/frame", "max/frame", "live bytes", "peak bytes");
+    a_out << line << std::endl;
+
+    for ( unsigned int i = 0; i < tagCount; i++ )
+    {
+        TagStats const& tag = stats[i];
+        double perFrame = frames > 1 ? (double)(tag.allocationsAtLastFrame - firstFrameAllocations[i]) / (frames - 1) : 0;
+
+        std::snprintf(line, sizeof(line), "%-12s %12llu %10.2f %10llu %14llu %14llu", tagNames[i],
+                      (unsigned long long)tag.allocations.load(std::memory_order_relaxed), perFrame,
+                      (unsigned long long)tag.maxPerFrame,
+                      (unsigned long long)tag.liveBytes.load(std::memory_order_relaxed),
+                      (unsigned long long)tag.peakBytes.load(std::memory_order_relaxed));
+        a_out << line << std::endl;
+    }
+}
+
+#else
+
+static void * countedAllocate(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    threadAllocations++;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+static void countedFree(void *ptr)
+{
+    if ( ptr == nullptr )
+        return;
+
+    deallocations.fetch_add(1, std::memory_order_relaxed);
+    std::free(ptr);
+}
+
+#endif
+
+void * operator new(std::size_t size)
+{
+    void *ptr = countedAllocate(size);
+
+    if ( ptr == nullptr )
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+void * operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void * operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void * operator new[](std::size_t size, std::nothrow_t const&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete(void *ptr, std::nothrow_t const&) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::nothrow_t const&) noexcept
+{
+    countedFree(ptr);
+}
+
+// The sized forms are used by default since C++14, so they are replaced too.
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    countedFree(ptr);
+}
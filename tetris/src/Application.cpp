@@ -1,9 +1,24 @@
 #include "Application.h"
+#include "Log.h"
+
+#include <algorithm>
 
 Application::Application()
-    : State((const State*)nullptr), m_screen(nullptr)
+    : State((const State*)nullptr), m_screen(nullptr), m_instrumentation(new Instrumentation()),
+      m_replayDirectory("replays"), m_checksumInterval(Replay::defaultChecksumInterval),
+      m_versusBoards(VersusState::defaultBoards),
+      m_highScores(new HighScores()),
+      m_resources(new ResourceCache()),
+      m_loader(new StateLoader()),
+      m_showOverlay(false)
+#ifndef NDEBUG
+    , m_steadyFrames(0), m_allocationReports(0)
+#endif
 {
     m_child = std::make_shared<MenuState>(this);
+    m_pendingEvents.reserve(64);
+    m_highScores->setPath("highscores.dat");
+    m_overlay = std::make_shared<PerfOverlay>(this);
 }
 
 std::weak_ptr<SDL_Surface> Application::getScreen() const
@@ -11,9 +26,115 @@ std::weak_ptr<SDL_Surface> Application::getScreen() const
     return std::weak_ptr<SDL_Surface>(m_screen);
 }
 
+void Application::setResourceArchive(std::string const& a_path)
+{
+    m_archivePath = a_path;
+}
+
+void Application::setReplayDirectory(std::string const& a_path)
+{
+    m_replayDirectory = a_path;
+}
+
+std::string const& Application::getReplayDirectory() const
+{
+    return m_replayDirectory;
+}
+
+void Application::setChecksumInterval(unsigned int a_ticks)
+{
+    m_checksumInterval = a_ticks;
+}
+
+unsigned int Application::getChecksumInterval() const
+{
+    return m_checksumInterval;
+}
+
+void Application::setVersusBoards(unsigned int a_boards)
+{
+    m_versusBoards = std::clamp(a_boards, 2u, Match::maxBoards);
+}
+
+unsigned int Application::getVersusBoards() const
+{
+    return m_versusBoards;
+}
+
+bool Application::setTelemetryPath(std::string const& a_path)
+{
+    m_telemetry.reset(new Telemetry(a_path));
+
+    if ( ! m_telemetry->isOpen() )
+        m_telemetry.reset();
+
+    return m_telemetry != nullptr;
+}
+
+Telemetry * Application::getTelemetry() const
+{
+    return m_telemetry.get();
+}
+
+HighScores & Application::getHighScores() const
+{
+    return *m_highScores;
+}
+
+bool Application::playReplay(std::string const& a_path, double a_speed, std::uint64_t a_startTick)
+{
+    auto replay = std::make_shared<Replay>();
+
+    if ( ! replay->load(a_path) )
+        return false;
+
+    auto game = std::make_shared<Game>(this, std::move(replay), a_speed);
+    game->seek(a_startTick);
+
+    m_child = std::move(game);
+    return true;
+}
+
+void Application::spectate(unsigned int a_boards)
+{
+    m_child = std::make_shared<SpectatorState>(this, a_boards);
+}
+
+StartupProfile & Application::getStartupProfile()
+{
+    return m_startup;
+}
+
+Instrumentation & Application::getInstrumentation() const
+{
+    return *m_instrumentation;
+}
+
+ResourceCache & Application::getResources() const
+{
+    return *m_resources;
+}
+
+StateLoader & Application::getLoader() const
+{
+    return *m_loader;
+}
+
 void Application::load()
 {
-    SDL_Init(SDL_INIT_EVERYTHING);
+    // The resources are built into the executable, so the game does not depend on the directory it
+    // is started from.
+    bool archiveRead = m_archivePath.empty() ? m_archive.open(embeddedArchive, embeddedArchiveSize)
+                                             : m_archive.openFile(m_archivePath);
+    if ( !archiveRead )
+        LOG_WARNING("Failed to read the resource archive; reading resources from disk");
+    m_resources->setArchive(&m_archive);
+    m_startup.mark("resource archive");
+
+    // Video is the only subsystem used; SDL_GetTicks and SDL_Delay work without the timer.
+    SDL_Init(SDL_INIT_VIDEO);
+    m_startup.mark("SDL video");
+
     m_screen =
         Screen_ptr
             (SDL_SetVideoMode(screenWidth, 
@@ -21,10 +142,15 @@ void Application::load()
                               screenDepth, 
                               SDL_HWSURFACE | SDL_DOUBLEBUF),
              EmptyDeleter<SDL_Surface>());
+    m_startup.mark("video mode");
 
     TTF_Init();
+    m_startup.mark("SDL_ttf");
 
+    // Fonts are opened by the states that use them, straight from the archive. The game's are
+    // opened on the loader thread while the menu is up, and the overlay's when it is first shown.
     State::load();
+    m_startup.mark("menu load");
 }
 
 int Application::run()
@@ -37,7 +163,10 @@ int Application::run()
            thisTime = 0,
            deltaTime = 0,
            extraTime = 0;
-    bool skipFrame = false;
+    bool skipFrame = false, firstFrame = true;
+
+    Instrumentation::Micros frameStart = 0, phaseStart = 0;
+    unsigned long frame = 0;
 
     lastTime = SDL_GetTicks();
 
@@ -47,69 +176,192 @@ int Application::run()
 
     while ( m_status == AppState::running )
     {
+        TRACE_SCOPE_ARG("frame", "frame", frame);
+        frame++;
+
+#ifndef NDEBUG
+        std::uint64_t allocationsBefore = getThreadAllocationCount();
+        State const* childBefore = m_child.get();
+        AppState overlayBefore = m_overlay->getStatus();
+#endif
+
+        phaseStart = Instrumentation::now();
+        if ( frameStart != 0 )
+            m_instrumentation->record(Instrumentation::Metric::frameTotal, phaseStart - frameStart);
+        frameStart = phaseStart;
+
         if ( !skipFrame )
+        {
             draw (m_screen);
-        //else
-        //    std::cerr << "Skipped frame!" << std::endl;
+            m_instrumentation->record(Instrumentation::Metric::frameDraw, Instrumentation::now() - phaseStart);
+        }
+
+        if ( firstFrame )
+        {
+            m_startup.mark("first frame");
+            m_startup.report();
+            firstFrame = false;
+        }
 
         thisTime = SDL_GetTicks(); // the current time
         deltaTime = thisTime - lastTime; // how long did it take to draw the last frame.
-        // std::cerr << "This time = " << thisTime << " ; last time = " << lastTime << std::endl;
         extraTime = deltaTime < FRAMETIME ? FRAMETIME - deltaTime : 0; // how much time is "left" in the current frame.
-        
-        // std::cerr << "Extra time: " << extraTime << std::endl;
 
         // true if the last frame took longer than 1/60 s to draw.
         skipFrame = deltaTime > FRAMETIME;
 
-        // if there is sufficient time left over in this frame, simply stall the program for that time.
-        if ( extraTime > 10 ) 
-            SDL_Delay(extraTime);
+        // if there is sufficient time left over in this frame, stall the program for that time,
+        // collecting input as it arrives.
+        if ( extraTime > 0 )
+            idle(thisTime + extraTime);
         
         lastTime = SDL_GetTicks(); // update the last time to the current time. 
 
+        phaseStart = Instrumentation::now();
         update();
+        m_instrumentation->record(Instrumentation::Metric::frameUpdate, Instrumentation::now() - phaseStart);
+
+        m_instrumentation->collect();
+
+        if ( m_status != AppState::running ) // cleaned up, so the states and the overlay are gone
+            break;
+
+        m_overlay->update();
+        allocAccounting::frameEnded();
+
+#ifndef NDEBUG
+        // Frames that change state or load the overlay are expected to allocate.
+        if ( m_child.get() != childBefore || m_overlay->getStatus() != overlayBefore )
+            m_steadyFrames = 0;
+        else
+            checkSteadyFrame(frame, getThreadAllocationCount() - allocationsBefore);
+#endif
     }
 
+    // The reports go straight to stderr, after whatever is still queued in the log.
+    logging::flush();
+    m_instrumentation->reportOnExit();
+    allocAccounting::report(std::cerr);
+    trace::flush();
+
     return EXIT_SUCCESS;
 }
 
+#ifndef NDEBUG
+void Application::checkSteadyFrame(unsigned long a_frame, std::uint64_t a_allocations)
+{
+    static const unsigned int maxReports = 5;
+
+    if ( ++m_steadyFrames <= warmupFrames || a_allocations == 0 || m_allocationReports >= maxReports )
+        return;
+
+    LOG_WARNING("Frame %lu made %llu heap allocation(s) in a steady state.%s", a_frame, (unsigned long long)a_allocations,
+                ++m_allocationReports == maxReports ? " (Not reporting any more.)" : "");
+}
+#endif
+
 void Application::cleanup()
 {
+    if ( m_overlay == nullptr ) // already cleaned up
+        return;
+
     State::cleanup();
 
+    m_loader->stop();
+    m_overlay->cleanup();
+
+    // The states hold fonts and surfaces from the resource cache, some of whose data is in the
+    // archive; m_child is State's, so it would otherwise outlive both.
+    m_child.reset();
+    m_overlay.reset();
+
+    m_resources->clear();
+
     SDL_Quit();
 }
 
+void Application::pumpEvents()
+{
+    TimedEvent timed;
+
+    while ( SDL_PollEvent(&timed.event) )
+    {
+        timed.time = SDL_GetTicks();
+        timed.polled = Instrumentation::now();
+        m_pendingEvents.push_back(timed);
+    }
+}
+
+void Application::idle(Uint32 a_until)
+{
+    // SDL_Delay has a granularity of roughly a millisecond, so sleep in small steps and leave the
+    // last millisecond for the next frame's update.
+    for ( Uint32 now = SDL_GetTicks(); now + 1 < a_until; now = SDL_GetTicks() )
+    {
+        pumpEvents();
+        SDL_Delay(1);
+    }
+}
+
 void Application::update()
 {
-    static SDL_Event event;
+    TRACE_SCOPE("Application::update");
 
-    while ( SDL_PollEvent(&event) )
+    pumpEvents();
+
+    for ( auto &timed : m_pendingEvents )
     {
-        switch ( event.type )
+        if ( m_status != AppState::running ) // quit by an earlier event
+            break;
+
+        switch ( timed.event.type )
         {
             case SDL_QUIT:
-                std::cerr << "Got quit signal." << std::endl;
+                LOG_INFO("Got quit signal.");
                 cleanup();
                 break;
+            case SDL_KEYDOWN:
+                if ( timed.event.key.keysym.sym == overlayKey )
+                {
+                    m_showOverlay = !m_showOverlay;
+                    // Loaded when first shown, to keep it out of startup.
+                    if ( m_showOverlay && m_overlay->getStatus() == AppState::notReady )
+                        m_overlay->load();
+                    break;
+                }
+                // fall through
             default:
-                handleEvent(event); // this will pass the event on to the child
+                m_instrumentation->beginEvent(timed.polled);
+                handleEvent(timed.event, timed.time); // this will pass the event on to the child
+                m_instrumentation->endEvent();
                 break;
         }
     }
 
+    m_pendingEvents.clear();
+
     State::update();
 
+    // Whatever was allocated from the frame arena during this update, or the draw before it, is
+    // no longer in use.
+    frameArena().reset();
+
     if ( m_child == nullptr ) // if the child got nexted into null, then there is no more game
         cleanup(); // cleanup to finish this state, which will terminate the main loop
 }
 
-void Application::draw(Surface_ptr a_parent)
+void Application::draw(Surface_ptr const& a_parent)
 {
+    ALLOC_TAG(rendering);
+
+    TRACE_SCOPE("Application::draw");
+
     static Uint32 black = SDL_MapRGB (m_screen->format, 0, 0, 0);
     SDL_FillRect (m_screen.get(), NULL, black); 
     State::draw (m_screen);
+    if ( m_showOverlay )
+        m_overlay->draw (m_screen);
     SDL_Flip (m_screen.get());
+    m_instrumentation->framePresented();
 }
 
@@ -0,0 +1,82 @@
+#include "AutoShift.h"
+
+AutoShift::AutoShift(unsigned int a_delay, unsigned int a_repeatRate)
+    : m_delay(a_delay), m_repeatRate(a_repeatRate)
+{
+    reset();
+}
+
+// // // MUTATORS // // //
+
+void AutoShift::press(int a_direction, unsigned int a_time)
+{
+    held(a_direction) = true;
+
+    m_direction = a_direction;
+    m_pressTime = a_time;
+    m_repeats = 0;
+}
+
+void AutoShift::release(int a_direction, unsigned int a_time)
+{
+    held(a_direction) = false;
+
+    if ( m_direction != a_direction )
+        return;
+
+    if ( held(-a_direction) )
+    {
+        m_direction = -a_direction;
+        m_pressTime = a_time;
+        m_repeats = 0;
+    }
+    else
+        m_direction = 0;
+}
+
+unsigned int AutoShift::poll(unsigned int a_time)
+{
+    // a_time can be older than m_pressTime when the caller lags behind the event timestamps.
+    if ( m_direction == 0 || a_time < m_pressTime || a_time - m_pressTime < m_delay )
+        return 0;
+
+    if ( m_repeatRate == 0 )
+        return instant;
+
+    unsigned int due = 1 + (a_time - m_pressTime - m_delay) / m_repeatRate;
+    unsigned int result = due - m_repeats;
+
+    m_repeats = due;
+
+    return result;
+}
+
+void AutoShift::reset()
+{
+    m_leftHeld = m_rightHeld = false;
+    m_direction = 0;
+    m_pressTime = 0;
+    m_repeats = 0;
+}
+
+// // // OBSERVERS // // //
+
+int AutoShift::getDirection() const
+{
+    return m_direction;
+}
+
+unsigned int AutoShift::getDelay() const
+{
+    return m_delay;
+}
+
+unsigned int AutoShift::getRepeatRate() const
+{
+    return m_repeatRate;
+}
+
+bool & AutoShift::held(int a_direction)
+{
+    return a_direction < 0 ? m_leftHeld : m_rightHeld;
+}
@@ -0,0 +1,168 @@
+#include "Bot.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <limits>
+
+// From Yiyuan Lee's genetic search for a player that rarely loses.
+const Bot::Weights Bot::defaultWeights = { -0.510066, 0.760666, -0.35663, -0.184483 };
+
+Bot::Bot(Weights const& a_weights, unsigned int a_moveTicks)
+    : m_weights(a_weights), m_moveTicks(a_moveTicks), m_wait(0), m_planned(false), m_softDrop(false), m_rotations(0), m_targetColumn(0)
+{
+}
+
+void Bot::play(Simulation & a_simulation)
+{
+    if ( ! a_simulation.isFalling() || a_simulation.isOver() )
+    {
+        m_planned = false; // the next piece is a new one
+
+        if ( m_softDrop )
+            m_softDrop = ! a_simulation.apply(Simulation::Action::softDropOff);
+        return;
+    }
+
+    if ( ! m_planned )
+    {
+        plan(a_simulation.getWell());
+        m_planned = true;
+        m_wait = m_moveTicks;
+    }
+
+    if ( m_wait > 0 )
+    {
+        m_wait--;
+        return;
+    }
+
+    m_wait = m_moveTicks;
+
+    if ( m_rotations > 0 )
+    {
+        // A piece at the top of the well may have no room to turn yet: it is hurried down a row.
+        if ( a_simulation.apply(Simulation::Action::rotateCW) )
+            m_rotations--;
+        else if ( ! m_softDrop )
+            m_softDrop = a_simulation.apply(Simulation::Action::softDropOn);
+        return;
+    }
+
+    if ( m_softDrop )
+    {
+        m_softDrop = false;
+        a_simulation.apply(Simulation::Action::softDropOff);
+    }
+
+    unsigned int column = leftColumn(a_simulation.getWell().getPiece());
+
+    // A shift that is blocked on the way drops the piece where it is.
+    if ( column < m_targetColumn && a_simulation.apply(Simulation::Action::moveRight) )
+        return;
+    if ( column > m_targetColumn && a_simulation.apply(Simulation::Action::moveLeft) )
+        return;
+
+    a_simulation.apply(Simulation::Action::drop);
+}
+
+void Bot::reset()
+{
+    m_planned = false;
+    m_softDrop = false;
+    m_wait = 0;
+}
+
+void Bot::plan(StandardWell const& a_well)
+{
+    const int width = a_well.getWellWidth();
+
+    double best = -std::numeric_limits<double>::infinity();
+    m_rotations = 0;
+    m_targetColumn = leftColumn(a_well.getPiece());
+
+    StandardWell rotated = a_well;
+
+    for ( unsigned int rotations = 0; rotations < 4; rotations++ )
+    {
+        // As play will, moving the piece down to make room if it has none.
+        if ( rotations > 0 )
+        {
+            while ( ! rotated.rotatePiece(Direction::CW) )
+                if ( rotated.updatePiece() )
+                    return;
+        }
+
+        unsigned int start = leftColumn(rotated.getPiece());
+
+        for ( int shift = -(int)start; shift < width - (int)start; shift++ )
+        {
+            StandardWell placed = rotated;
+
+            if ( shift != 0 && ! placed.movePiece(shift) )
+                continue;
+
+            placed.fall();
+
+            double score = evaluate(placed);
+            if ( score > best )
+            {
+                best = score;
+                m_rotations = rotations;
+                m_targetColumn = start + shift;
+            }
+        }
+    }
+}
+
+double Bot::evaluate(StandardWell const& a_well) const
+{
+    typedef StandardWell::StorageType Rows;
+
+    auto const& storage = a_well.getStorage();
+
+    unsigned int lines = 0;
+    for ( unsigned int y = 0; y < Rows::height; y++ )
+        lines += storage.isRowFull(y);
+
+    // Top to bottom over the rows that stay, with the columns that have a block so far.
+    unsigned int remaining = Rows::height - lines, row = 0;
+    unsigned int heights[Rows::width] = {};
+    unsigned int holes = 0;
+    Rows::Row covered = 0;
+
+    for ( unsigned int y = 0; y < Rows::height; y++ )
+    {
+        Rows::Row blocks = storage.getRow(y);
+
+        if ( blocks == Rows::fullRow )
+            continue;
+
+        for ( Rows::Row first = blocks & ~covered; first != 0; first &= first - 1 )
+            heights[std::countr_zero(first)] = remaining - row;
+
+        holes += std::popcount((unsigned int)(covered & ~blocks));
+        covered |= blocks;
+        row++;
+    }
+
+    unsigned int height = 0, bumpiness = 0;
+    for ( unsigned int x = 0; x < Rows::width; x++ )
+    {
+        height += heights[x];
+        if ( x > 0 )
+            bumpiness += std::abs((int)heights[x] - (int)heights[x - 1]);
+    }
+
+    return m_weights.height * height + m_weights.lines * lines + m_weights.holes * holes + m_weights.bumpiness * bumpiness;
+}
+
+unsigned int Bot::leftColumn(StandardWell::Piece const& a_piece)
+{
+    unsigned int column = std::numeric_limits<unsigned int>::max();
+
+    for ( auto const& block : a_piece )
+        column = std::min(column, block.location.first);
+
+    return column;
+}
@@ -0,0 +1,65 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(std::size_t a_capacity)
+    : m_block(new unsigned char[a_capacity]), m_capacity(a_capacity), m_used(0), m_highWater(0),
+      m_overflowBytes(0)
+{
+}
+
+void * FrameArena::allocate(std::size_t a_size, std::size_t a_alignment)
+{
+    std::uintptr_t base = (std::uintptr_t)m_block.get();
+    std::size_t start = ((base + m_used + a_alignment - 1) & ~(std::uintptr_t)(a_alignment - 1)) - base;
+
+    if ( start + a_size <= m_capacity )
+    {
+        m_used = start + a_size;
+        return m_block.get() + start;
+    }
+
+    // new[] of unsigned char is only aligned for fundamental types, which is all this is used for.
+    m_overflow.emplace_back(new unsigned char[a_size == 0 ? 1 : a_size]);
+    m_overflowBytes += a_size;
+    return m_overflow.back().get();
+}
+
+void FrameArena::reset()
+{
+    std::size_t used = m_used + m_overflowBytes;
+    m_highWater = std::max(m_highWater, used);
+
+    if ( ! m_overflow.empty() )
+    {
+        m_overflow.clear();
+        m_overflowBytes = 0;
+
+        m_capacity = std::max(m_capacity * 2, used);
+        m_block.reset(new unsigned char[m_capacity]);
+    }
+
+    m_used = 0;
+}
+
+std::size_t FrameArena::getUsed() const
+{
+    return m_used + m_overflowBytes;
+}
+
+std::size_t FrameArena::getCapacity() const
+{
+    return m_capacity;
+}
+
+std::size_t FrameArena::getHighWater() const
+{
+    return m_highWater;
+}
+
+FrameArena & frameArena()
+{
+    thread_local FrameArena arena;
+    return arena;
+}
@@ -1,20 +1,30 @@
 #include "Game.h"
 #include "Application.h"
-
-Game::Game(const Application* a_owner, unsigned int a_initialSpeed)
-    : State (a_owner), m_well(wellWidth, wellHeight)
+#include "Log.h"
+
+#include <cstdio>
+#include <ctime>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#else
+#include <direct.h>
+#endif
+
+Game::Game(const Application* a_owner, unsigned int a_initialSpeed,
+           unsigned int a_autoShiftDelay, unsigned int a_autoRepeatRate)
+    : State (a_owner), m_playbackSpeed(0), m_playbackTicks(0),
+      m_simulation(std::random_device()(), a_initialSpeed), m_history(undoTicks),
+      m_autoShift(a_autoShiftDelay, a_autoRepeatRate)
 {
-    m_speed = a_initialSpeed;
-    m_score = 0;
-    m_clearedLines = 0;
-
-    m_fallFaster = false;
-    m_falling = true;
     m_easyMode = false;
+}
 
-    m_child = State_ptr { new MultiState(this) };
-
-    m_time = 1;
+Game::Game(const Application* a_owner, std::shared_ptr<Replay const> a_replay, double a_speed)
+    : State (a_owner), m_player(new ReplayPlayer(std::move(a_replay))), m_playbackSpeed(a_speed), m_playbackTicks(0),
+      m_simulation(m_player->makeSimulation()), m_history(1), m_autoShift(defaultAutoShiftDelay, defaultAutoRepeatRate)
+{
+    m_easyMode = false;
 }
 
 void Game::load()
@@ -23,131 +33,362 @@ void Game::load()
     // m_blockSurfaces[BlockState::falling] = makeSafeSurfacePtr(loadOptimized("resources/falling-block.png"));
     // m_blockSurfaces[BlockState::fallen]  = makeSafeSurfacePtr(loadOptimized("resources/fallen-block.png"));
     
-    m_pieceSurface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_HWSURFACE, blockSide, blockSide, Application::screenDepth, 0, 0, 0, 0));
-    m_fallenSurface  = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_HWSURFACE, blockSide, blockSide, Application::screenDepth, 0, 0, 0, 0));
-    m_freeSurface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_HWSURFACE, blockSide, blockSide, Application::screenDepth, 0, 0, 0, 0));
-    m_clearedSurface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_HWSURFACE, blockSide * m_well.getWellWidth(), blockSide, Application::screenDepth, 0, 0, 0, 0));
-    m_fallenPreviewSurface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_HWSURFACE, blockSide, blockSide, Application::screenDepth, 0, 0, 0, 0));
+    m_pieceSurface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_SWSURFACE, blockSide, blockSide, Application::screenDepth, 0, 0, 0, 0));
+    m_fallenSurface  = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_SWSURFACE, blockSide, blockSide, Application::screenDepth, 0, 0, 0, 0));
+    m_freeSurface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_SWSURFACE, blockSide, blockSide, Application::screenDepth, 0, 0, 0, 0));
+    m_clearedSurface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_SWSURFACE, blockSide * m_simulation.getWell().getWellWidth(), blockSide, Application::screenDepth, 0, 0, 0, 0));
+    m_fallenPreviewSurface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_SWSURFACE, blockSide, blockSide, Application::screenDepth, 0, 0, 0, 0));
     SDL_FillRect(m_pieceSurface.get(), nullptr, SDL_MapRGB(getOwner()->getScreen().lock()->format, 255, 64, 64));
     SDL_FillRect(m_fallenSurface.get(), nullptr, SDL_MapRGB(getOwner()->getScreen().lock()->format, 64, 64, 255));
     SDL_FillRect(m_freeSurface.get(), makeSafeRectPtr(8, 8, 16, 16).get(), SDL_MapRGB(getOwner()->getScreen().lock()->format, 128, 128, 128));
     SDL_FillRect(m_clearedSurface.get(), nullptr, SDL_MapRGB(getOwner()->getScreen().lock()->format, 255, 255, 255));
     SDL_FillRect(m_fallenPreviewSurface.get(), nullptr, SDL_MapRGB(getOwner()->getScreen().lock()->format, 64, 255, 64));
 
-    m_wellPosition.x = getOwner()->screenWidth / 2 - m_well.getWellWidth() * blockSide / 2;
-    m_wellPosition.y = getOwner()->screenHeight / 2 - m_well.getWellHeight() * blockSide / 2;
+    StandardWell const& well = m_simulation.getWell();
+
+    m_wellPosition.x = getOwner()->screenWidth / 2 - well.getWellWidth() * blockSide / 2;
+    m_wellPosition.y = getOwner()->screenHeight / 2 - well.getWellHeight() * blockSide / 2;
 
-    m_piecePreviewPosition.x = m_wellPosition.x + (m_well.getWellWidth() + 2) * blockSide;
+    m_piecePreviewPosition.x = m_wellPosition.x + (well.getWellWidth() + 2) * blockSide;
     m_piecePreviewPosition.y = m_wellPosition.y + 8 * blockSide;
 
+    // Sized up front, so that the game does not allocate while it runs.
+    m_effects.reserve(16);
+
     m_statusLocation.x = 20;
     m_statusLocation.y = 100;
 
-    m_statusFont    = makeSafeFontPtr(TTF_OpenFont("resources/statusfont.ttf", 20));
+    m_statusFont    = getOwner()->getResources().getFont("resources/statusfont.ttf", 20);
 
     m_statusColorFgNormal = { 255, 255, 255 };
     m_statusColorFgEffect = { 255, 64, 64 };
     m_statusColorBg = { 0, 0, 0 };
 
-    renderStatus(&m_scoreSurface, "Score: ", m_score, m_statusColorFgNormal);
-    renderStatus(&m_levelSurface, "Level: ", m_speed, m_statusColorFgNormal);
-    renderStatus(&m_linesSurface, "Lines: ", m_clearedLines, m_statusColorFgNormal);
+    // Only the characters the status lines can contain.
+    static const char *statusGlyphs = "0123456789 :ScoreLvlins";
+
+    m_statusAtlasNormal = getOwner()->getResources().getAtlas(m_statusFont, m_statusColorFgNormal, m_statusColorBg, statusGlyphs);
+    m_statusAtlasEffect = getOwner()->getResources().getAtlas(m_statusFont, m_statusColorFgEffect, m_statusColorBg, statusGlyphs);
 
-    if ( ! m_well.newPiece() )
-        std::cerr << "Failed to spawn initial piece." << std::endl;
+    m_scoreLine.label = "Score: ";
+    m_levelLine.label = "Level: ";
+    m_linesLine.label = "Lines: ";
 
-    m_child->activate();
+    m_shownScore = m_simulation.getScore();
+    m_shownLines = m_simulation.getClearedLines();
+    setStatus(&m_scoreLine, m_shownScore, m_statusAtlasNormal.get());
+    setStatus(&m_linesLine, m_shownLines, m_statusAtlasNormal.get());
+    // The level line is set in activate, since the speed may still change until then.
 
     State::load();
 }
 
+void Game::activate()
+{
+    m_shownLevel = m_simulation.getLevel();
+    setStatus(&m_levelLine, m_shownLevel, m_statusAtlasNormal.get());
+
+    State::activate();
+
+    m_statusAtlasNormal->optimize();
+    m_statusAtlasEffect->optimize();
+
+    m_simulation.warmUp();
+
+    // Replays are recorded from the start, once the initial speed is settled.
+    if ( m_player == nullptr && ! getOwner()->getReplayDirectory().empty() )
+        m_recorder.begin(m_simulation.getSeed(), m_simulation.getInitialSpeed(), getOwner()->getChecksumInterval());
+
+    m_history.reset(m_simulation);
+
+    // Replays report nothing: they are games that were played already.
+    if ( m_player == nullptr )
+        m_simulation.setTelemetry(getOwner()->getTelemetry());
+
+    m_nextGameOver = std::make_shared<GameOverState>(getOwner());
+    getOwner()->getLoader().prewarm(m_nextGameOver);
+}
+
+void Game::setInitialSpeed(unsigned int a_speed)
+{
+    m_simulation.setInitialSpeed(a_speed);
+}
+
+void Game::seek(std::uint64_t a_tick)
+{
+    if ( m_player != nullptr )
+        m_player->seek(m_simulation, a_tick);
+}
+
 void Game::cleanup()
 {
+    saveReplay();
+
+    m_effects.clear();
+
     State::cleanup();
 }
 
 void Game::update()
 {
-    // Make the blocks fall only once every (speedLimit / m_speed) frames
-    if ( m_time % (speedLimit / (m_fallFaster ? 10 > m_speed ? 10 : m_speed : m_speed)) == 0 )
-        if ( m_falling && m_well.updatePiece() ) // if a collision took place
-            handleNewPiece();
+    if ( m_player != nullptr )
+    {
+        // Any multiple of real time: whole ticks are run as they come due.
+        for ( m_playbackTicks += m_playbackSpeed; m_playbackTicks >= 1 && m_player->step(m_simulation); m_playbackTicks-- )
+            ;
+
+        if ( m_player->isDone(m_simulation) )
+            handleGameOver();
+    }
+    else
+    {
+        handleAutoShift(SDL_GetTicks());
+        step();
+    }
+
+    updateStatus();
+
+    {
+        ALLOC_TAG(effects);
+        m_effects.tick();
+    }
 
     State::update();
+}
+
+bool Game::submit(Simulation::Action a_action)
+{
+    std::uint64_t tick = m_simulation.getTicks();
+
+    if ( ! m_simulation.apply(a_action) )
+        return false;
+
+    m_recorder.record(tick, a_action);
+    return true;
+}
+
+void Game::step()
+{
+    m_simulation.tick();
+    m_recorder.afterTick(m_simulation);
+    m_history.afterTick(m_simulation);
+
+    if ( m_simulation.isOver() )
+        handleGameOver();
+}
+
+bool Game::undo()
+{
+    if ( m_history.isEmpty() )
+        return false;
+
+    std::uint64_t oldest = m_history.getOldestTick(), tick = m_history.getNewestTick();
+    auto falling = [this] (std::uint64_t a_tick) { return m_history.find(a_tick)->flags & Simulation::Snapshot::falling; };
+
+    // Back over the piece that is falling now, if any, then over the last one's lock sequence, to
+    // the tick it landed on.
+    while ( tick > oldest && falling(tick) )
+        tick--;
+    if ( falling(tick) ) // no piece landed as far back as the history goes
+        return false;
+    while ( tick > oldest && ! falling(tick) )
+        tick--;
+
+    // Then to when it appeared.
+    while ( tick > oldest && falling(tick - 1) )
+        tick--;
+
+    if ( ! falling(tick) || ! m_history.rewind(m_simulation, tick) )
+        return false;
+
+    // A game with undos cannot be replayed.
+    m_recorder.cancel();
+
+    // The keys may have changed since; they take effect again when pressed.
+    submit(Simulation::Action::softDropOff);
+    m_autoShift.reset();
+    return true;
+}
+
+void Game::updateStatus()
+{
+    if ( m_simulation.getScore() != m_shownScore )
+        setStatusWithDefaultEffect(&m_scoreLine, m_shownScore = m_simulation.getScore());
+
+    if ( m_simulation.getClearedLines() != m_shownLines )
+        setStatusWithDefaultEffect(&m_linesLine, m_shownLines = m_simulation.getClearedLines());
 
-    m_time++;
+    if ( m_simulation.getLevel() != m_shownLevel )
+    {
+        m_shownLevel = m_simulation.getLevel();
+        setStatusWithDefaultEffect(&m_levelLine, m_shownLevel);
+    }
 }
 
-void Game::handleEvent(SDL_Event const& event)
+void Game::handleGameOver()
 {
+    if ( getStatus() == AppState::finished )
+        return;
+
+    setState(AppState::finished);
+    if ( m_nextGameOver == nullptr )
+        m_nextGameOver = std::make_shared<GameOverState>(getOwner());
+    // A replay's game was ranked when it was played.
+    m_nextGameOver->setResults(m_simulation.getScore(), m_simulation.getLevel(), m_simulation.getClearedLines(),
+            m_player == nullptr);
+    m_next = m_nextGameOver;
+}
+
+void Game::saveReplay()
+{
+    if ( ! m_recorder.isRecording() )
+        return;
+
+    m_recorder.finish(m_simulation);
+
+    std::string directory = getOwner()->getReplayDirectory();
+
+#ifndef _WIN32
+    mkdir(directory.c_str(), 0755);
+#else
+    _mkdir(directory.c_str());
+#endif
+
+    // Named after when the game ended, and its seed, which tells apart games that end together.
+    char name[64];
+    std::time_t now = std::time(nullptr);
+    std::size_t length = std::strftime(name, sizeof(name), "%Y%m%d-%H%M%S", std::localtime(&now));
+    std::snprintf(name + length, sizeof(name) - length, "-%08x.trpl", (unsigned int)m_simulation.getSeed());
+
+    std::string path = directory + "/" + name;
+    if ( ! m_recorder.save(path) )
+        LOG_ERROR("Failed to save the replay to %s", path.c_str());
+}
+
+void Game::handleAutoShift(Uint32 a_time)
+{
+    unsigned int shifts = m_autoShift.poll(a_time);
+
+    // Repeats that come due while no piece is falling are dropped, but the key stays charged, so
+    // the next piece keeps moving as soon as it spawns.
+    if ( ! m_simulation.isFalling() )
+        return;
+
+    Simulation::Action move = m_autoShift.getDirection() < 0 ? Simulation::Action::moveLeft : Simulation::Action::moveRight;
+
+    for ( unsigned int i = 0; i < shifts; i++ )
+    {
+        std::uint64_t tick = m_simulation.getTicks();
+
+        if ( ! m_simulation.apply(move) )
+            break;
+
+        m_recorder.record(tick, move);
+    }
+}
+
+void Game::handleEvent(SDL_Event const& event, Uint32 a_time)
+{
+    if ( m_player != nullptr ) // the replay does the playing
+    {
+        if ( event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_LEFT )
+            seek(m_simulation.getTicks() > seekStep ? m_simulation.getTicks() - seekStep : 0);
+        else if ( event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_RIGHT )
+            seek(m_simulation.getTicks() + seekStep);
+
+        return;
+    }
+
+    bool applied = false; // only input that changed the game counts towards its latency
+
     switch ( event.type )
     {
-        case SDL_KEYUP:
+        case SDL_KEYDOWN:
+            // Catch up on repeats that were due before this event, so that input within one frame
+            // is applied in the order it happened.
+            handleAutoShift(a_time);
+
             switch ( event.key.keysym.sym )
             {
                 case SDLK_g:
                     m_easyMode = !m_easyMode;
+                    applied = true;
+                    break;
+                case SDLK_BACKSPACE:
+                    if ( m_easyMode )
+                        applied = undo();
                     break;
                 case SDLK_DOWN:
-                    m_fallFaster = false;
+                    applied = submit(Simulation::Action::softDropOn);
+                    break;
+                case SDLK_LEFT:
+                    m_autoShift.press(-1, a_time);
+                    applied = submit(Simulation::Action::moveLeft);
+                    break;
+                case SDLK_RIGHT:
+                    m_autoShift.press(1, a_time);
+                    applied = submit(Simulation::Action::moveRight);
+                    break;
+                case SDLK_z:
+                    applied = submit(Simulation::Action::rotateCCW);
+                    break;
+                case SDLK_x:
+                    applied = submit(Simulation::Action::rotateCW);
+                    break;
+                case SDLK_SPACE:
+                    applied = submit(Simulation::Action::drop);
                     break;
                 default:
                     break;
             }
+            break;
+        case SDL_KEYUP:
+            handleAutoShift(a_time);
 
-            if ( m_falling ) // all this input only makes sense if a piece is falling.
+            switch ( event.key.keysym.sym )
             {
-                switch ( event.key.keysym.sym )
-                {
-                    case SDLK_LEFT:
-                        m_well.movePiece(-1);
-                        // std::cerr << "Piece moved left: " << status << std::endl;
-                        break;
-                    case SDLK_RIGHT:
-                        m_well.movePiece(1);
-                        // std::cerr << "Piece moved right!" << status << std::endl;
-                        break;
-                    case SDLK_z:
-                        m_well.rotatePiece(Direction::CCW);
-                        break;
-                    case SDLK_x:
-                        m_well.rotatePiece(Direction::CW);
-                        break;
-                    case SDLK_SPACE:
-                        m_well.fall();
-                        handleNewPiece();
-                        break;
-                    default:
-                        break;
-                }
+                case SDLK_DOWN:
+                    applied = submit(Simulation::Action::softDropOff);
+                    break;
+                case SDLK_LEFT:
+                    m_autoShift.release(-1, a_time);
+                    break;
+                case SDLK_RIGHT:
+                    m_autoShift.release(1, a_time);
+                    break;
+                default:
+                    break;
             }
             break;
-        case SDL_KEYDOWN:
-            if ( event.key.keysym.sym == SDLK_DOWN )
-                m_fallFaster = true;
-            break;
+        default:
+            return;
     }
+
+    if ( applied )
+        getOwner()->getInstrumentation().eventApplied();
 }
 
-void Game::draw(Surface_ptr a_parent)
+void Game::draw(Surface_ptr const& a_parent)
 {
     static SDL_Rect drawLocation { 0, 0, 0, 0 };
 
-    for ( unsigned short i = 0; i < m_well.getWellWidth(); i++)
+    StandardWell & well = m_simulation.getWell();
+
+    for ( unsigned short i = 0; i < well.getWellWidth(); i++)
     {
-        for ( unsigned short j = 0; j < m_well.getWellHeight(); j++ )
+        for ( unsigned short j = 0; j < well.getWellHeight(); j++ )
         {
             drawLocation.x = m_wellPosition.x + (short)(i * blockSide); 
             drawLocation.y = m_wellPosition.y + (short)(j * blockSide);
 
-            Surface_ptr surface = m_well.getWell()[i][j] ? m_fallenSurface : m_freeSurface;
+            SDL_Surface *surface = (well.isOccupied(i, j) ? m_fallenSurface : m_freeSurface).get();
 
-            if ( SDL_BlitSurface(surface.get(), nullptr, a_parent.get(), &drawLocation) != 0 )
-                std::cerr << "Failed to draw well surface." << std::endl;
+            if ( blitSurface(surface, nullptr, a_parent.get(), &drawLocation) != 0 )
+                LOG_ERROR("Failed to draw the well surface: %s", SDL_GetError());
         }
     }
 
-    auto drawPiece = [this, a_parent] (Well::Piece const& piece, Surface_ptr pieceSurface)
+    auto drawPiece = [this, &a_parent] (StandardWell::Piece const& piece, Surface_ptr const& pieceSurface)
     {
         SDL_Rect drawLocation { 0, 0, 0, 0 };
 
@@ -156,41 +397,35 @@ void Game::draw(Surface_ptr a_parent)
             drawLocation.x = m_wellPosition.x + (short)(p.location.first * blockSide);
             drawLocation.y = m_wellPosition.y + (short)(p.location.second * blockSide);
 
-            if ( SDL_BlitSurface(pieceSurface.get(), nullptr, a_parent.get(), &drawLocation) != 0 )
-                std::cerr << "Failed to draw piece surface." << std::endl;
+            if ( blitSurface(pieceSurface.get(), nullptr, a_parent.get(), &drawLocation) != 0 )
+                LOG_ERROR("Failed to draw the piece surface: %s", SDL_GetError());
         }
     };
 
-    drawPiece(m_well.getPiece(), m_pieceSurface);
+    drawPiece(well.getPiece(), m_pieceSurface);
 
-    if ( m_falling && m_easyMode )
-        drawPiece(m_well.getFallenPiece(), m_fallenPreviewSurface);
+    if ( m_simulation.isFalling() && m_easyMode )
+        drawPiece(well.getFallenPiece(), m_fallenPreviewSurface);
 
-    for ( auto &p : m_clearingSurfaces )
+    for ( auto y : m_simulation.getClearingRows() )
     {
-        if ( SDL_BlitSurface(m_clearedSurface.get(), nullptr, a_parent.get(), &p) != 0 )
-            std::cerr << "Failed to draw clearing surface." << std::endl;
+        drawLocation = SDL_Rect { m_wellPosition.x, (short)(m_wellPosition.y + y * blockSide), 0, 0 };
+
+        if ( blitSurface(m_clearedSurface.get(), nullptr, a_parent.get(), &drawLocation) != 0 )
+            LOG_ERROR("Failed to draw the clearing surface: %s", SDL_GetError());
     }
 
     drawLocation = m_statusLocation;
-    if ( SDL_BlitSurface(m_scoreSurface.get(), nullptr, a_parent.get(), &drawLocation) 
-            != 0 )
-        std::cerr << "Failed to draw score surface." << std::endl;
-
-    drawLocation.y += 3 * m_scoreSurface->h / 2;
-    if ( SDL_BlitSurface(m_levelSurface.get(), nullptr, a_parent.get(), &drawLocation)
-            != 0 )
-        std::cerr << "Failed to draw level surface." << std::endl;
-
-    drawLocation.y += 3 * m_levelSurface->h / 2;
-    if ( SDL_BlitSurface(m_linesSurface.get(), nullptr, a_parent.get(), &drawLocation)
-            != 0 )
-        std::cerr << "Failed to draw lines surface." << std::endl;
+    for ( StatusLine const* line : { &m_scoreLine, &m_levelLine, &m_linesLine } )
+    {
+        line->atlas->draw(line->text, a_parent.get(), drawLocation.x, drawLocation.y);
+        drawLocation.y += 3 * line->atlas->getHeight() / 2;
+    }
 
     drawPreviewBox(a_parent);
 }
 
-void Game::drawPreviewBox(Surface_ptr a_parent)
+void Game::drawPreviewBox(Surface_ptr const& a_parent)
 {
     static SDL_Rect drawLocation { 0, 0, 0, 0 };
 
@@ -201,96 +436,32 @@ void Game::drawPreviewBox(Surface_ptr a_parent)
         for ( int j = 0; j < 5; j++ )
         {
             drawLocation.y = m_piecePreviewPosition.y = j * blockSide;
-            if( SDL_BlitSurface((PIECES[m_well.getNextPieceID()][0][j][i] == 0 ? m_freeSurface : m_pieceSurface).get(), 
+            if( blitSurface((PIECES[m_simulation.getWell().getNextPieceID()][0][j][i] == 0 ? m_freeSurface : m_pieceSurface).get(), 
                         nullptr, a_parent.get(), &drawLocation) != 0 )
-                std::cerr << "Failed to draw preview block at " << i << ", " << j << std::endl;
+                LOG_ERROR("Failed to draw the preview block at %d, %d: %s", i, j, SDL_GetError());
         }
     }
                                   
 }
 
-void Game::renderStatus(Surface_ptr * dest, std::string const& text, unsigned int value, SDL_Color fg)
+void Game::setStatus(StatusLine * line, unsigned int value, GlyphAtlas const* atlas)
 {
-    static std::stringstream sb;
-
-    sb.clear();
-    sb.str("");
-    sb << text << value;
-    (*dest) = makeSafeSurfacePtr(TTF_RenderText_Shaded(m_statusFont.get(), sb.str().c_str(), fg, m_statusColorBg));
+    std::snprintf(line->text, sizeof(line->text), "%s%u", line->label, value);
+    line->atlas = atlas;
 }
 
-void Game::renderStatusWithEffect(Surface_ptr * dest, std::string const& text, unsigned int value, SDL_Color fg1, SDL_Color fg2, unsigned int delayTime)
+void Game::setStatusWithEffect(StatusLine * line, unsigned int value, GlyphAtlas const* atlas1, GlyphAtlas const* atlas2, unsigned int delayTime)
 {
-    auto f = std::bind(&Game::renderStatus, this, dest, text, value, std::placeholders::_1);
-    f(fg1);
-    getChild()->add(makeDelay(this, delayTime, std::bind(f, fg2)));
-}
+    ALLOC_TAG(effects);
 
-void Game::renderStatusWithDefaultEffect(Surface_ptr * dest, std::string const& text, unsigned int value)
-{
-    renderStatusWithEffect(dest, text, value, m_statusColorFgEffect, m_statusColorFgNormal, statusChangeEffectTime);
+    setStatus(line, value, atlas1);
+    // Only the color is switched back, so a value that changed in the meantime is kept. A change
+    // during the effect restarts it.
+    m_effects.cancel(line->effect);
+    line->effect = m_effects.schedule(delayTime, [line, atlas2] () { line->atlas = atlas2; });
 }
 
-void Game::handleSpeed()
+void Game::setStatusWithDefaultEffect(StatusLine * line, unsigned int value)
 {
-
-    // +1 to account for the fact that with less than speedStep lines cleared, the division yields zero.
-    unsigned int ts = m_clearedLines / speedStep + 1;
-    if ( m_speed < ts )
-    {
-        m_speed = ts;
-        std::cerr << "Speed up! " << ts << std::endl;
-        renderStatusWithDefaultEffect(&m_levelSurface, "Level: ", m_speed);
-    }
+    setStatusWithEffect(line, value, m_statusAtlasEffect.get(), m_statusAtlasNormal.get(), statusChangeEffectTime);
 }
-
-void Game::handleGenNewPiece()
-{
-    if ( ! m_well.newPiece() )
-    {
-        setState(AppState::finished);
-        m_next = State_ptr { new GameOverState(getOwner(), m_score, m_speed, m_clearedLines) };
-    }
-    else
-    {
-        m_time = 1;
-    }
-
-    m_falling = true;
-}
-
-void Game::handleRows()
-{
-    auto rows = m_well.getFullRows();
-
-    if ( rows.size() > 0)
-    {  
-        auto callback_f = [this, rows] () {
-            handleGenNewPiece();
-            m_clearingSurfaces.clear();
-            m_score += baseRowScore * rows.size() * std::pow(2, rows.size() - 1); // TODO bells!!!
-            m_clearedLines += rows.size();
-            m_well.removeRows(std::move(rows));
-            handleSpeed();
-            renderStatusWithDefaultEffect(&m_scoreSurface, "Score: ", m_score);
-            renderStatusWithDefaultEffect(&m_linesSurface, "Lines: ", m_clearedLines);
-        };
-
-        for ( auto i = rows.begin(); i != rows.end(); i++ )
-             m_clearingSurfaces.push_back(SDL_Rect { m_wellPosition.x, (short)(m_wellPosition.y + *i * blockSide), 0, 0 } );
-
-        getChild()->add(makeDelay(this, 30, callback_f));
-    }
-    else
-        handleGenNewPiece();
-}
-
-void Game::handleNewPiece()
-{
-    auto f = std::bind(&Game::handleRows, this);
-    getChild()->add(makeDelay(this, 15, f));
-
-    m_falling = false; // disable the falling piece during the forstate's execution for the effect
-}
-
-
@@ -1,78 +1,94 @@
 #include "GameOverState.h"
 #include "MenuState.h"
 #include "Application.h"
+#include "Log.h"
+
+#include <cstdio>
+#include <ctime>
+
+GameOverState::GameOverState(const Application *a_parent)
+    : GameOverState(a_parent, 0, 0, 0)
+{
+}
 
 GameOverState::GameOverState(const Application *a_parent, unsigned int a_score, unsigned int a_speed, unsigned int a_lines)
-    : State(a_parent), m_scoreSurface(nullptr), m_levelSurface(nullptr), m_skillSurface(nullptr), m_linesSurface(nullptr), m_gameOverSurface(nullptr),
-      m_score(a_score), m_level(a_speed), m_lines(a_lines), m_font(nullptr), m_textColorFg(SDL_Color { 255, 255, 255 }),
+    : State(a_parent), m_gameOverSurface(nullptr), m_font(nullptr), m_textColorFg(SDL_Color { 255, 255, 255 }),
       m_textColorBg (SDL_Color { 0, 0, 0 })
 {
+    setResults(a_score, a_speed, a_lines);
+}
+
+void GameOverState::setResults(unsigned int a_score, unsigned int a_speed, unsigned int a_lines, bool a_ranked)
+{
+    m_ranked = a_ranked;
+    m_score = a_score;
+    m_level = a_speed;
+    m_lines = a_lines;
     m_skill = m_lines == 0 ? 0 : (int)((double)m_score / (double)m_lines);
 }
 
 void GameOverState::load()
 {
-    m_font = makeSafeFontPtr(TTF_OpenFont("resources/statusfont.ttf", 20));
+    m_font = getOwner()->getResources().getFont("resources/statusfont.ttf", 20);
 
-    m_gameOverSurface = makeSafeSurfacePtr(TTF_RenderText_Shaded(m_font.get(), "YOU ARE A TETRIS MASTER",
-                                                                 m_textColorFg, m_textColorBg));
+    m_gameOverSurface = getOwner()->getResources().getText(m_font, "YOU ARE A TETRIS MASTER",
+                                                           m_textColorFg, m_textColorBg);
 
-    auto makeStatus = [this] (std::string label, unsigned int value)
-    {
-        std::stringstream text;
-        text << label << value;
-        return makeSafeSurfacePtr(TTF_RenderText_Shaded(m_font.get(), text.str().c_str(),
-                    m_textColorFg, m_textColorBg));
-    };
+    m_atlas = getOwner()->getResources().getAtlas(m_font, m_textColorFg, m_textColorBg, "0123456789 :ScoreLvlinskRaf");
 
-    m_scoreSurface = makeStatus("Score: ", m_score);
+    // Read here, off the main thread when prewarmed, since the file grows with every game played.
+    getOwner()->getHighScores().load();
 
-    m_levelSurface = makeStatus("Level: ", m_level);
+    State::load();
+}
 
-    m_linesSurface = makeStatus("Lines: ", m_lines);
+void GameOverState::activate()
+{
+    std::snprintf(m_resultLines[0], sizeof(m_resultLines[0]), "Score: %u", m_score);
+    std::snprintf(m_resultLines[1], sizeof(m_resultLines[1]), "Level: %u", m_level);
+    std::snprintf(m_resultLines[2], sizeof(m_resultLines[2]), "Lines: %u", m_lines);
+    std::snprintf(m_resultLines[3], sizeof(m_resultLines[3]), "Skill: %u", m_skill);
 
-    m_skillSurface = makeStatus("Skill: ", m_skill);
+    HighScores & scores = getOwner()->getHighScores();
+    std::size_t rank = m_ranked ? scores.add(HighScores::Entry { m_score, m_lines, m_level, (std::int64_t)std::time(nullptr) })
+                                : scores.getRank(m_score);
+    std::snprintf(m_resultLines[4], sizeof(m_resultLines[4]), "Rank: %zu of %zu", rank, scores.getCount() + ! m_ranked);
 
-    State::load();
+    State::activate();
+
+    m_atlas->optimize();
+
+    m_nextMenu = std::make_shared<MenuState>(getOwner());
+    getOwner()->getLoader().prewarm(m_nextMenu);
 }
 
-void GameOverState::handleEvent(SDL_Event const& event)
+void GameOverState::handleEvent(SDL_Event const& event, Uint32 a_time)
 {
-    if ( event.type == SDL_KEYUP )
+    // Key down rather than key up, so that releasing the key that ended the game does not also
+    // dismiss this screen.
+    if ( event.type == SDL_KEYDOWN )
     {
         setState(AppState::finished);
-        m_next = std::make_shared<MenuState>(getOwner());
+        m_next = m_nextMenu != nullptr ? m_nextMenu : std::make_shared<MenuState>(getOwner());
     }
 }
 
-void GameOverState::draw(Surface_ptr a_parent)
+void GameOverState::draw(Surface_ptr const& a_parent)
 {
-    static SDL_Rect gameOverTextPosition { (short)(a_parent->w / 2 - m_gameOverSurface->w / 2),
-                                           (short)(a_parent->h / 3 - m_gameOverSurface->h / 2), 0, 0 };
-    static SDL_Rect scoreTextPosition { gameOverTextPosition.x, (short)(gameOverTextPosition.y + m_gameOverSurface->h + 50), 0, 0 };
-    static SDL_Rect levelTextPosition { gameOverTextPosition.x, (short)(scoreTextPosition.y + m_scoreSurface->h + 5), 0, 0 };
-    static SDL_Rect linesTextPosition { gameOverTextPosition.x, (short)(levelTextPosition.y + m_levelSurface->h + 5), 0, 0 };
-    static SDL_Rect skillTextPosition { gameOverTextPosition.x, (short)(linesTextPosition.y + m_linesSurface->h + 5), 0, 0 };
-
-    if ( SDL_BlitSurface (m_gameOverSurface.get(), nullptr, a_parent.get(), &gameOverTextPosition)
-            != 0 )
-        std::cerr << "Failed to blit game over text surface." << std::endl;
-
-    if ( SDL_BlitSurface (m_scoreSurface.get(), nullptr, a_parent.get(), &scoreTextPosition)
-            != 0 )
-        std::cerr << "Failed to blit score surface." << std::endl;
+    SDL_Rect gameOverTextPosition { (short)(a_parent->w / 2 - m_gameOverSurface->w / 2),
+                                    (short)(a_parent->h / 3 - m_gameOverSurface->h / 2), 0, 0 };
 
-    if ( SDL_BlitSurface (m_levelSurface.get(), nullptr, a_parent.get(), &levelTextPosition)
+    if ( blitSurface(m_gameOverSurface.get(), nullptr, a_parent.get(), &gameOverTextPosition)
             != 0 )
-        std::cerr << "Failed to blit level surface." << std::endl;
+        LOG_ERROR("Failed to blit the game over text surface: %s", SDL_GetError());
 
-    if ( SDL_BlitSurface (m_linesSurface.get(), nullptr, a_parent.get(), &linesTextPosition)
-            != 0 )
-        std::cerr << "Failed to blit lines surface." << std::endl;
+    short y = gameOverTextPosition.y + m_gameOverSurface->h + 50;
 
-    if ( SDL_BlitSurface (m_skillSurface.get(), nullptr, a_parent.get(), &skillTextPosition)
-            != 0 )
-        std::cerr << "Failed to blit skill surface." << std::endl;
+    for ( auto &line : m_resultLines )
+    {
+        m_atlas->draw(line, a_parent.get(), gameOverTextPosition.x, y);
+        y += m_atlas->getHeight() + 5;
+    }
 
     State::draw(a_parent);
 }
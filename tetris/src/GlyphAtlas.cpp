@@ -0,0 +1,106 @@
+#include "GlyphAtlas.h"
+#include "AllocAccounting.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+GlyphAtlas::GlyphAtlas(TTF_Font *a_font, SDL_Color a_fg, SDL_Color a_bg, const char *a_glyphs)
+    : m_optimized(false), m_height(0)
+{
+    ALLOC_TAG(ttf);
+
+    std::vector<Surface_ptr> rendered;
+    unsigned int width = 0;
+    char text[2] = { 0, 0 };
+
+    // Every glyph is rendered as a one character string rather than with TTF_RenderGlyph_*, so that
+    // all of them share the font's height and baseline and can simply be placed side by side.
+    // Glyphs left out of a_glyphs keep an empty rectangle.
+    for ( char c = firstGlyph; c <= lastGlyph; c++ )
+    {
+        text[0] = c;
+
+        if ( a_glyphs != nullptr && std::strchr(a_glyphs, c) == nullptr )
+            rendered.push_back(nullptr);
+        else
+            rendered.push_back(makeSafeSurfacePtr(TTF_RenderText_Shaded(a_font, text, a_fg, a_bg)));
+
+        SDL_Surface *s = rendered.back().get();
+        m_glyphs[c - firstGlyph] = makeRect(width, 0, s ? s->w : 0, s ? s->h : 0);
+
+        if ( s != nullptr )
+        {
+            width += s->w;
+            m_height = std::max(m_height, (unsigned int)s->h);
+        }
+    }
+
+    m_surface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_SWSURFACE, width, m_height, 32, 0, 0, 0, 0));
+
+    for ( unsigned int i = 0; i < rendered.size(); i++ )
+    {
+        SDL_Rect to = m_glyphs[i];
+        if ( rendered[i] != nullptr )
+            SDL_BlitSurface(rendered[i].get(), nullptr, m_surface.get(), &to);
+    }
+}
+
+void GlyphAtlas::optimize()
+{
+    if ( m_optimized )
+        return;
+
+    m_optimized = true;
+
+    SDL_Surface *optimized = SDL_DisplayFormat(m_surface.get());
+    if ( optimized != nullptr )
+        m_surface = makeSafeSurfacePtr(optimized);
+}
+
+unsigned int GlyphAtlas::draw(const char *a_text, SDL_Surface *a_dest, short a_x, short a_y) const
+{
+    SDL_Rect to { a_x, a_y, 0, 0 };
+
+    for ( ; *a_text != '\0'; a_text++ )
+    {
+        SDL_Rect const* from = glyph(*a_text);
+
+        if ( from == nullptr )
+            continue;
+
+        SDL_Rect source = *from;
+        blitSurface(m_surface.get(), &source, a_dest, &to);
+        to.x += from->w;
+    }
+
+    return to.x - a_x;
+}
+
+unsigned int GlyphAtlas::measure(const char *a_text) const
+{
+    unsigned int width = 0;
+
+    for ( ; *a_text != '\0'; a_text++ )
+    {
+        SDL_Rect const* from = glyph(*a_text);
+
+        if ( from != nullptr )
+            width += from->w;
+    }
+
+    return width;
+}
+
+unsigned int GlyphAtlas::getHeight() const
+{
+    return m_height;
+}
+
+SDL_Rect const* GlyphAtlas::glyph(char a_c) const
+{
+    if ( a_c < firstGlyph || a_c > lastGlyph || m_glyphs[a_c - firstGlyph].h == 0 )
+        return nullptr;
+
+    return &m_glyphs[a_c - firstGlyph];
+}
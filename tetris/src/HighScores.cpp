@@ -0,0 +1,436 @@
+#include "HighScores.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+static const char magic[4] = { 'T', 'H', 'S', 'C' };
+
+static void putFixed(unsigned char *a_out, std::uint64_t a_value, unsigned int a_bytes)
+{
+    for ( unsigned int i = 0; i < a_bytes; i++ )
+        a_out[i] = a_value >> (8 * i);
+}
+
+static std::uint64_t getFixed(const unsigned char *a_data, unsigned int a_bytes)
+{
+    std::uint64_t value = 0;
+
+    for ( unsigned int i = 0; i < a_bytes; i++ )
+        value |= std::uint64_t(a_data[i]) << (8 * i);
+
+    return value;
+}
+
+// Never 0 for a record of zeroes, which is what a file may hold where a write was cut short.
+static std::uint32_t check(HighScores::Entry const& a_entry)
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+
+    for ( std::uint64_t value : { (std::uint64_t)a_entry.score, (std::uint64_t)a_entry.lines,
+                                  (std::uint64_t)a_entry.level, (std::uint64_t)a_entry.time } )
+        hash = (hash ^ value) * 0x100000001b3;
+
+    return hash ^ (hash >> 32);
+}
+
+// Returns false if the record does not pass its check.
+static bool getRecord(const unsigned char *a_data, HighScores::Entry & a_entry)
+{
+    a_entry.score = getFixed(a_data, 4);
+    a_entry.lines = getFixed(a_data + 4, 4);
+    a_entry.level = getFixed(a_data + 8, 4);
+    a_entry.time = getFixed(a_data + 16, 8);
+
+    return getFixed(a_data + 12, 4) == check(a_entry);
+}
+
+HighScores::HighScores()
+    : m_loaded(false), m_writable(true), m_fileRecords(0), m_root(none), m_random(0x9e3779b9), m_writing(false),
+      m_stopping(false)
+{
+}
+
+HighScores::~HighScores()
+{
+    if ( ! m_writer.joinable() )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        m_stopping = true;
+    }
+    m_writeWake.notify_one();
+    m_writer.join();
+}
+
+void HighScores::setPath(std::string const& a_path)
+{
+    // The writer reads the path and the count of records in the file.
+    flush();
+
+    m_path = a_path;
+    m_loaded = false;
+}
+
+std::string const& HighScores::getPath() const
+{
+    return m_path;
+}
+
+bool HighScores::load()
+{
+    if ( m_loaded )
+        return m_writable;
+
+    m_loaded = true;
+    m_writable = true;
+    m_fileRecords = 0;
+    m_entries.clear();
+
+    MappedFile file;
+
+    // A file that cannot be opened is taken to be one that is not there yet.
+    if ( ! m_path.empty() && file.open(m_path) && file.size() >= headerSize )
+    {
+        const unsigned char *data = file.data();
+
+        if ( std::memcmp(data, magic, sizeof(magic)) != 0 || getFixed(data + 4, 4) != version
+                || getFixed(data + 8, 4) != recordSize )
+        {
+            m_writable = false;
+            build();
+            return false;
+        }
+
+        // A record cut short at the end is left out, and written over by the next one.
+        m_fileRecords = (file.size() - headerSize) / recordSize;
+        m_entries.reserve(m_fileRecords);
+
+        Entry entry;
+        for ( std::size_t i = 0; i < m_fileRecords; i++ )
+            if ( getRecord(data + headerSize + i * recordSize, entry) )
+                m_entries.push_back(entry);
+    }
+
+    build();
+    return true;
+}
+
+bool HighScores::isLoaded() const
+{
+    return m_loaded;
+}
+
+std::size_t HighScores::add(Entry const& a_entry)
+{
+    load();
+
+    std::size_t rank = getRank(a_entry.score);
+
+    std::uint32_t node = m_entries.size();
+    m_entries.push_back(a_entry);
+    m_nodes.push_back(Node { none, none, 1, nextPriority() });
+    m_root = insert(m_root, node);
+
+    if ( ! m_path.empty() && m_writable )
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+
+        if ( ! m_writer.joinable() )
+            m_writer = std::thread(&HighScores::write, this);
+        m_writes.push_back(a_entry);
+        m_writeWake.notify_one();
+    }
+
+    return rank;
+}
+
+void HighScores::flush()
+{
+    std::unique_lock<std::mutex> lock(m_writeMutex);
+    m_writeDone.wait(lock, [this] { return m_writes.empty() && ! m_writing; });
+}
+
+void HighScores::encode(Entry const& a_entry, unsigned char *a_out)
+{
+    putFixed(a_out, a_entry.score, 4);
+    putFixed(a_out + 4, a_entry.lines, 4);
+    putFixed(a_out + 8, a_entry.level, 4);
+    putFixed(a_out + 12, check(a_entry), 4);
+    putFixed(a_out + 16, a_entry.time, 8);
+}
+
+// // // QUERIES // // //
+
+std::size_t HighScores::getCount() const
+{
+    return m_entries.size();
+}
+
+std::size_t HighScores::getRank(unsigned int a_score) const
+{
+    std::size_t higher = 0;
+
+    for ( std::uint32_t node = m_root; node != none; )
+    {
+        if ( m_entries[node].score > a_score )
+        {
+            higher += sizeOf(m_nodes[node].left) + 1;
+            node = m_nodes[node].right;
+        }
+        else
+            node = m_nodes[node].left;
+    }
+
+    return higher + 1;
+}
+
+void HighScores::getTop(std::size_t a_count, std::vector<Entry> & a_out) const
+{
+    a_out.clear();
+
+    // In order, with the path down to the next node on a stack, which is as deep as the tree.
+    std::vector<std::uint32_t> path;
+
+    for ( std::uint32_t node = m_root; a_out.size() < a_count && (node != none || ! path.empty()); )
+    {
+        if ( node != none )
+        {
+            path.push_back(node);
+            node = m_nodes[node].left;
+            continue;
+        }
+
+        node = path.back();
+        path.pop_back();
+        a_out.push_back(m_entries[node]);
+        node = m_nodes[node].right;
+    }
+}
+
+HighScores::Entry const& HighScores::getNth(std::size_t a_position) const
+{
+    std::uint32_t node = m_root;
+
+    for ( ;; )
+    {
+        std::size_t left = sizeOf(m_nodes[node].left);
+
+        if ( a_position == left )
+            return m_entries[node];
+
+        if ( a_position < left )
+            node = m_nodes[node].left;
+        else
+        {
+            a_position -= left + 1;
+            node = m_nodes[node].right;
+        }
+    }
+}
+
+// // // INDEX // // //
+
+bool HighScores::before(std::uint32_t a_a, std::uint32_t a_b) const
+{
+    // Entries are added in order, so the lower index is the older one.
+    return m_entries[a_a].score != m_entries[a_b].score ? m_entries[a_a].score > m_entries[a_b].score : a_a < a_b;
+}
+
+std::uint32_t HighScores::sizeOf(std::uint32_t a_node) const
+{
+    return a_node == none ? 0 : m_nodes[a_node].size;
+}
+
+void HighScores::update(std::uint32_t a_node)
+{
+    m_nodes[a_node].size = sizeOf(m_nodes[a_node].left) + sizeOf(m_nodes[a_node].right) + 1;
+}
+
+void HighScores::build()
+{
+    std::uint32_t count = m_entries.size();
+
+    m_nodes.assign(count, Node { none, none, 1, 0 });
+    for ( Node & node : m_nodes )
+        node.priority = nextPriority();
+
+    std::vector<std::uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this] (std::uint32_t a_a, std::uint32_t a_b) { return before(a_a, a_b); });
+
+    // A Cartesian tree over the sorted entries: each node goes at the bottom of the right spine,
+    // above the nodes there with lower priorities, which become its left subtree.
+    std::vector<std::uint32_t> spine;
+    for ( std::uint32_t node : order )
+    {
+        std::uint32_t last = none;
+        while ( ! spine.empty() && m_nodes[spine.back()].priority < m_nodes[node].priority )
+        {
+            last = spine.back();
+            spine.pop_back();
+        }
+
+        m_nodes[node].left = last;
+        if ( ! spine.empty() )
+            m_nodes[spine.back()].right = node;
+        spine.push_back(node);
+    }
+
+    m_root = spine.empty() ? none : spine.front();
+
+    // Subtree sizes, children before their parents.
+    std::vector<std::uint32_t> pending;
+    std::vector<std::uint32_t> & visited = order; // reused, as the nodes in pre-order
+    visited.clear();
+
+    if ( m_root != none )
+        pending.push_back(m_root);
+
+    while ( ! pending.empty() )
+    {
+        std::uint32_t node = pending.back();
+        pending.pop_back();
+        visited.push_back(node);
+
+        for ( std::uint32_t child : { m_nodes[node].left, m_nodes[node].right } )
+            if ( child != none )
+                pending.push_back(child);
+    }
+
+    for ( auto it = visited.rbegin(); it != visited.rend(); ++it )
+        update(*it);
+}
+
+std::uint32_t HighScores::insert(std::uint32_t a_root, std::uint32_t a_node)
+{
+    if ( a_root == none )
+        return a_node;
+
+    if ( m_nodes[a_node].priority > m_nodes[a_root].priority )
+    {
+        split(a_root, a_node, m_nodes[a_node].left, m_nodes[a_node].right);
+        update(a_node);
+        return a_node;
+    }
+
+    if ( before(a_node, a_root) )
+        m_nodes[a_root].left = insert(m_nodes[a_root].left, a_node);
+    else
+        m_nodes[a_root].right = insert(m_nodes[a_root].right, a_node);
+
+    update(a_root);
+    return a_root;
+}
+
+void HighScores::split(std::uint32_t a_root, std::uint32_t a_key, std::uint32_t & a_left, std::uint32_t & a_right)
+{
+    if ( a_root == none )
+    {
+        a_left = a_right = none;
+        return;
+    }
+
+    if ( before(a_root, a_key) )
+    {
+        split(m_nodes[a_root].right, a_key, m_nodes[a_root].right, a_right);
+        a_left = a_root;
+    }
+    else
+    {
+        split(m_nodes[a_root].left, a_key, a_left, m_nodes[a_root].left);
+        a_right = a_root;
+    }
+
+    update(a_root);
+}
+
+std::uint32_t HighScores::nextPriority()
+{
+    // xorshift32
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return m_random;
+}
+
+// // // FILE // // //
+
+bool HighScores::append(Entry const& a_entry)
+{
+    if ( m_path.empty() || ! m_writable )
+        return false;
+
+    std::FILE *file = std::fopen(m_path.c_str(), "r+b");
+    if ( file == nullptr )
+        file = std::fopen(m_path.c_str(), "w+b"); // there is no file yet
+    if ( file == nullptr )
+        return false;
+
+    // A new file gets its header in the same write as its first record.
+    unsigned char bytes[headerSize + recordSize];
+    std::size_t offset = 0, size = 0;
+
+    if ( m_fileRecords == 0 )
+    {
+        std::memcpy(bytes, magic, sizeof(magic));
+        putFixed(bytes + 4, version, 4);
+        putFixed(bytes + 8, recordSize, 4);
+        putFixed(bytes + 12, 0, 4);
+        size = headerSize;
+    }
+    else
+        offset = headerSize + m_fileRecords * recordSize;
+
+    encode(a_entry, bytes + size);
+    size += recordSize;
+
+    bool written = std::fseek(file, offset, SEEK_SET) == 0 && std::fwrite(bytes, 1, size, file) == size
+            && std::fflush(file) == 0;
+#ifndef _WIN32
+    written = written && fsync(fileno(file)) == 0;
+#else
+    written = written && _commit(_fileno(file)) == 0;
+#endif
+
+    std::fclose(file);
+
+    if ( written )
+        m_fileRecords++;
+
+    return written;
+}
+
+void HighScores::write()
+{
+    std::unique_lock<std::mutex> lock(m_writeMutex);
+
+    // Whatever is queued is written before stopping.
+    while ( true )
+    {
+        m_writeWake.wait(lock, [this] { return ! m_writes.empty() || m_stopping; });
+        if ( m_writes.empty() )
+            break;
+
+        Entry entry = m_writes.front();
+        m_writes.pop_front();
+        m_writing = true;
+
+        lock.unlock();
+        append(entry); // an entry that cannot be written stays in the index only
+        lock.lock();
+
+        m_writing = false;
+        if ( m_writes.empty() )
+            m_writeDone.notify_all();
+    }
+}
@@ -0,0 +1,224 @@
+#include "Instrumentation.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// // // LatencyHistogram // // //
+
+LatencyHistogram::LatencyHistogram()
+{
+    clear();
+}
+
+void LatencyHistogram::record(std::uint32_t a_micros)
+{
+    m_buckets[bucketOf(a_micros)]++;
+    m_count++;
+    m_max = std::max(m_max, a_micros);
+}
+
+void LatencyHistogram::clear()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_max = 0;
+}
+
+std::uint64_t LatencyHistogram::getCount() const
+{
+    return m_count;
+}
+
+std::uint32_t LatencyHistogram::getMax() const
+{
+    return m_max;
+}
+
+std::uint32_t LatencyHistogram::getQuantile(double a_quantile) const
+{
+    if ( m_count == 0 )
+        return 0;
+
+    std::uint64_t rank = (std::uint64_t)std::ceil(a_quantile * m_count);
+    std::uint64_t seen = 0;
+
+    if ( rank == 0 )
+        rank = 1;
+
+    for ( unsigned int i = 0; i < bucketCount; i++ )
+    {
+        seen += m_buckets[i];
+        if ( seen >= rank )
+            return std::min(bucketValue(i), m_max);
+    }
+
+    return m_max;
+}
+
+// Values below linearBuckets map to themselves. Above that, every power of two [2^k, 2^(k+1)) is
+// split into subBuckets equal parts.
+unsigned int LatencyHistogram::bucketOf(std::uint32_t a_micros)
+{
+    if ( a_micros < linearBuckets )
+        return a_micros;
+
+    unsigned int log = 31 - __builtin_clz(a_micros); // at least 6
+    unsigned int shift = log - 5;
+
+    return linearBuckets + (log - 6) * subBuckets + ((a_micros >> shift) & (subBuckets - 1));
+}
+
+std::uint32_t LatencyHistogram::bucketValue(unsigned int a_bucket)
+{
+    if ( a_bucket < linearBuckets )
+        return a_bucket;
+
+    a_bucket -= linearBuckets;
+
+    unsigned int log = a_bucket / subBuckets + 6;
+    unsigned int sub = a_bucket % subBuckets;
+
+    return (std::uint32_t)(subBuckets + sub) << (log - 5);
+}
+
+// // // Instrumentation // // //
+
+Instrumentation::Instrumentation()
+    : m_dropped(0), m_currentEvent(0), m_currentApplied(false), m_pendingCount(0)
+{
+    m_last.fill(0);
+}
+
+Instrumentation::Micros Instrumentation::now()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Instrumentation::beginEvent(Micros a_polled)
+{
+    m_currentEvent = a_polled;
+    m_currentApplied = false;
+}
+
+void Instrumentation::endEvent()
+{
+    m_currentEvent = 0;
+}
+
+void Instrumentation::eventApplied()
+{
+    if ( m_currentEvent == 0 || m_currentApplied )
+        return;
+
+    m_currentApplied = true;
+    record(Metric::pollToApply, now() - m_currentEvent);
+
+    if ( m_pendingCount < maxPendingEvents )
+        m_pendingEvents[m_pendingCount++] = m_currentEvent;
+}
+
+void Instrumentation::framePresented()
+{
+    Micros flipped = now();
+
+    for ( unsigned int i = 0; i < m_pendingCount; i++ )
+        record(Metric::pollToFlip, flipped - m_pendingEvents[i]);
+
+    m_pendingCount = 0;
+}
+
+void Instrumentation::record(Metric a_metric, Micros a_duration)
+{
+    Sample sample { a_metric, (std::uint32_t)std::min<Micros>(a_duration, UINT32_MAX) };
+
+    m_last[(unsigned int)a_metric] = sample.micros;
+
+    if ( ! m_samples.push(sample) )
+        m_dropped++;
+}
+
+void Instrumentation::collect()
+{
+    Sample sample;
+
+    while ( m_samples.pop(sample) )
+        m_histograms[(unsigned int)sample.metric].record(sample.micros);
+}
+
+LatencyHistogram const& Instrumentation::getHistogram(Metric a_metric) const
+{
+    return m_histograms[(unsigned int)a_metric];
+}
+
+std::uint32_t Instrumentation::getLast(Metric a_metric) const
+{
+    return m_last[(unsigned int)a_metric];
+}
+
+void Instrumentation::setReportPath(std::string const& a_path)
+{
+    m_reportPath = a_path;
+}
+
+std::string const& Instrumentation::getReportPath() const
+{
+    return m_reportPath;
+}
+
+void Instrumentation::report(std::ostream & a_out)
+{
+    static const char * const names[] =
+    {
+        "input: poll -> apply",
+        "input: poll -> flip",
+        "frame: update",
+        "frame: draw",
+        "frame: total"
+    };
+
+    collect();
+
+    a_out << "Performance statistics (microseconds)" << std::endl
+          << std::left << std::setw(24) << "" << std::right
+          << std::setw(10) << "samples" << std::setw(10) << "p50"
+          << std::setw(10) << "p99"     << std::setw(10) << "max" << std::endl;
+
+    for ( unsigned int i = 0; i < (unsigned int)Metric::count; i++ )
+    {
+        LatencyHistogram const& h = m_histograms[i];
+
+        a_out << std::left << std::setw(24) << names[i] << std::right
+              << std::setw(10) << h.getCount()
+              << std::setw(10) << h.getQuantile(0.5)
+              << std::setw(10) << h.getQuantile(0.99)
+              << std::setw(10) << h.getMax() << std::endl;
+    }
+
+    if ( m_dropped > 0 )
+        a_out << m_dropped << " samples were dropped." << std::endl;
+}
+
+void Instrumentation::reportOnExit()
+{
+    if ( m_reportPath.empty() )
+        return;
+
+    if ( m_reportPath == "-" )
+    {
+        report(std::cerr);
+        return;
+    }
+
+    std::ofstream out(m_reportPath);
+
+    if ( out )
+        report(out);
+    else
+        LOG_ERROR("Failed to open %s for the performance report", m_reportPath.c_str());
+}
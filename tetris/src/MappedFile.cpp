@@ -0,0 +1,103 @@
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+MappedFile::MappedFile()
+    : m_data(nullptr), m_size(0), m_mapped(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(std::string const& a_path)
+{
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(a_path.c_str(), O_RDONLY);
+    if ( fd < 0 )
+        return false;
+
+    struct stat info;
+    if ( fstat(fd, &info) != 0 )
+    {
+        ::close(fd);
+        return false;
+    }
+
+    m_size = info.st_size;
+
+    if ( m_size > 0 )
+    {
+        void *mapped = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping stays valid without the descriptor
+
+        if ( mapped == MAP_FAILED )
+        {
+            m_size = 0;
+            return false;
+        }
+
+        m_data = (const unsigned char*)mapped;
+        m_mapped = true;
+    }
+    else
+    {
+        ::close(fd);
+        m_data = (const unsigned char*)"";
+    }
+
+    return true;
+#else
+    std::ifstream in(a_path, std::ios::binary);
+    if ( ! in )
+        return false;
+
+    m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    if ( m_data == nullptr )
+        m_data = (const unsigned char*)"";
+
+    return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+    if ( m_mapped )
+        munmap((void*)m_data, m_size);
+#endif
+
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+}
+
+bool MappedFile::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+const unsigned char * MappedFile::data() const
+{
+    return m_data;
+}
+
+std::size_t MappedFile::size() const
+{
+    return m_size;
+}
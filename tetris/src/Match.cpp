@@ -0,0 +1,183 @@
+#include "Match.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+const unsigned int Match::garbageTable[5] = { 0, 0, 1, 2, 4 };
+
+Match::Match(unsigned int a_boards, std::uint32_t a_seed, unsigned int a_initialSpeed, std::uint64_t a_maxTicks)
+    : m_maxTicks(a_maxTicks)
+{
+    a_boards = std::clamp(a_boards, 1u, maxBoards);
+
+    m_boards.reserve(a_boards);
+    for ( unsigned int i = 0; i < a_boards; i++ )
+        m_boards.emplace_back(new Simulation(a_seed, a_initialSpeed));
+
+    m_lines.resize(a_boards);
+    m_sent.resize(a_boards);
+
+    restart(a_seed);
+}
+
+void Match::restart(std::uint32_t a_seed)
+{
+    for ( auto & board : m_boards )
+        board->reset(a_seed);
+
+    std::fill(m_lines.begin(), m_lines.end(), 0);
+    std::fill(m_sent.begin(), m_sent.end(), 0);
+
+    m_nextTarget = 0;
+    m_randomState = a_seed % 2147483647 == 0 ? 1 : a_seed % 2147483647;
+
+    m_ticks = 0;
+    m_over = false;
+    m_winner = -1;
+}
+
+bool Match::apply(unsigned int a_board, Simulation::Action a_action)
+{
+    if ( m_over || a_board >= m_boards.size() )
+        return false;
+
+    return m_boards[a_board]->apply(a_action);
+}
+
+void Match::tick()
+{
+    TRACE_SCOPE("Match::tick");
+
+    if ( m_over )
+        return;
+
+    for ( unsigned int i = 0; i < m_boards.size(); i++ )
+    {
+        Simulation & board = *m_boards[i];
+
+        if ( board.isOver() )
+            continue;
+
+        board.tick();
+
+        // Rows are cleared at the end of the clearing effect, all at once.
+        unsigned int lines = board.getClearedLines();
+        if ( lines != m_lines[i] )
+        {
+            sendGarbage(i, lines - m_lines[i]);
+            m_lines[i] = lines;
+        }
+    }
+
+    m_ticks++;
+    checkOver();
+}
+
+void Match::sendGarbage(unsigned int a_from, unsigned int a_lines)
+{
+    unsigned int rows = garbageTable[std::min(a_lines, 4u)];
+
+    rows = m_boards[a_from]->cancelGarbage(rows);
+    if ( rows == 0 )
+        return;
+
+    // The next board round from m_nextTarget that is still playing, other than the sender.
+    for ( unsigned int i = 0; i < m_boards.size(); i++ )
+    {
+        unsigned int target = (m_nextTarget + i) % m_boards.size();
+
+        if ( target == a_from || m_boards[target]->isOver() )
+            continue;
+
+        m_randomState = std::uint64_t(m_randomState) * 48271 % 2147483647;
+        m_boards[target]->addGarbage(rows, m_randomState % StandardWell::StorageType::width);
+
+        m_sent[a_from] += rows;
+        m_nextTarget = target + 1;
+        return;
+    }
+}
+
+void Match::checkOver()
+{
+    unsigned int playing = 0, last = 0;
+
+    for ( unsigned int i = 0; i < m_boards.size(); i++ )
+    {
+        if ( ! m_boards[i]->isOver() )
+        {
+            playing++;
+            last = i;
+        }
+    }
+
+    // A lone board plays until it tops out, and wins nothing.
+    if ( m_boards.size() > 1 && playing == 1 )
+    {
+        m_over = true;
+        m_winner = last;
+    }
+    else if ( playing == 0 )
+        m_over = true;
+    else if ( m_maxTicks > 0 && m_ticks >= m_maxTicks )
+    {
+        m_over = true;
+
+        // The best score among the boards still playing, unless it is shared.
+        unsigned int best = 0, shared = 0;
+        for ( unsigned int i = 0; i < m_boards.size(); i++ )
+        {
+            if ( m_boards[i]->isOver() )
+                continue;
+
+            if ( shared == 0 || m_boards[i]->getScore() > best )
+            {
+                best = m_boards[i]->getScore();
+                shared = 1;
+                m_winner = i;
+            }
+            else if ( m_boards[i]->getScore() == best )
+                shared++;
+        }
+
+        if ( shared > 1 )
+            m_winner = -1;
+    }
+}
+
+// // // OBSERVERS // // //
+
+unsigned int Match::getBoardCount() const
+{
+    return m_boards.size();
+}
+
+Simulation & Match::getBoard(unsigned int a_board)
+{
+    return *m_boards[a_board];
+}
+
+Simulation const& Match::getBoard(unsigned int a_board) const
+{
+    return *m_boards[a_board];
+}
+
+unsigned int Match::getSent(unsigned int a_board) const
+{
+    return m_sent[a_board];
+}
+
+bool Match::isOver() const
+{
+    return m_over;
+}
+
+int Match::getWinner() const
+{
+    return m_winner;
+}
+
+std::uint64_t Match::getTicks() const
+{
+    return m_ticks;
+}
@@ -2,53 +2,27 @@
 #include "Application.h"
 
 MenuState::MenuState(const Application *a_parent)
-    : State(a_parent), m_selectedSpeed(0)
+    : State(a_parent), m_selectedSpeed(0), m_drawn(false)
 {
 
 }
 
 void MenuState::load()
 {
-    m_titleFont = makeSafeFontPtr(TTF_OpenFont("resources/statusfont.ttf", 48));
-    m_menuFont  = makeSafeFontPtr(TTF_OpenFont("resources/statusfont.ttf", 24));
+    // Everything here comes from the application's resource cache, so only the first visit to the
+    // menu opens fonts and renders text.
+    ResourceCache &resources = getOwner()->getResources();
 
-    m_titleText = makeSafeSurfacePtr(TTF_RenderText_Shaded(m_titleFont.get(), 
-                                                           "TETRIS", 
-                                                           SDL_Color {255, 255, 255}, 
-                                                           SDL_Color {0,   0,   0  }));
+    m_titleFont = resources.getFont("resources/statusfont.ttf", 48);
+    m_menuFont  = resources.getFont("resources/statusfont.ttf", 24);
 
-    auto makeLine = [this] (const char* text) 
+    m_titleText = resources.getText(m_titleFont, "TETRIS", SDL_Color {255, 255, 255}, SDL_Color {0, 0, 0});
+
+    auto makeLine = [this, &resources] (const char* text) 
     {
-        return makeSafeSurfacePtr(TTF_RenderText_Shaded(m_menuFont.get(), text, 
-                    SDL_Color {255, 255, 255}, SDL_Color {0, 0, 0}));
+        return resources.getText(m_menuFont, text, SDL_Color {255, 255, 255}, SDL_Color {0, 0, 0});
     };
     
-    std::vector<Surface_ptr> lines; 
-    lines.push_back(makeLine("<Left> and <Right> to move the piece and in the menu."));
-    lines.push_back(makeLine("<Enter> selects an initial speed in the menu."));
-    lines.push_back(makeLine("<Z> and <X> rotate the piece counterclockwise and clockwise."));
-    lines.push_back(makeLine("<Space> jumps to the bottom, and <Down> makes it fall faster."));
-
-    short helpHeight = 0, helpWidth = 0;
-
-    for ( auto &p : lines )
-    {
-        helpWidth = std::max((int)helpWidth, p->w);
-        helpHeight += p->h;
-    }
-
-    m_helpText = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_HWSURFACE, helpWidth, helpHeight, 
-                Application::screenDepth, 0, 0, 0, 0));
-
-    helpHeight = 0;
-
-    for ( unsigned int i = 0; i < lines.size(); i++ )
-    {
-        SDL_Rect drawPosition { (short)(helpWidth / 2 - lines[i]->w / 2), helpHeight, 0, 0 };
-        SDL_BlitSurface(lines[i].get(), nullptr, m_helpText.get(), &drawPosition);
-        helpHeight += lines[i]->h;
-    }
-
     m_speedSelectText = makeLine("Select initial speed. (Recommended: 3 or 4.)");
 
     std::stringstream ss;
@@ -57,9 +31,8 @@ void MenuState::load()
         ss.clear();
         ss.str("");
         ss << i + 1;
-        m_initialSpeedTexts.push_back(makeSafeSurfacePtr(TTF_RenderText_Blended(m_menuFont.get(),
-                                                                                ss.str().c_str(),
-                                                                                SDL_Color {0, 0, 0})));
+        m_initialSpeedTexts.push_back(resources.getText(m_menuFont, ss.str(), SDL_Color {0, 0, 0},
+                                                        SDL_Color {0, 0, 0}, ResourceCache::TextStyle::blended));
     }
 
     m_boxWidth = (*std::max_element(m_initialSpeedTexts.begin(), m_initialSpeedTexts.end(),
@@ -71,33 +44,106 @@ void MenuState::load()
                 return a->h < b->h;
             }))->h;
 
-    m_selectedSpeedSurface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_HWSURFACE, m_boxWidth, 
-                m_boxHeight, Application::screenDepth, 0, 0, 0, 0));
-    m_unselectedSpeedSurface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_HWSURFACE, m_boxWidth,
-                m_boxHeight, Application::screenDepth, 0, 0, 0, 0));
-    SDL_FillRect(m_selectedSpeedSurface.get(), nullptr, SDL_MapRGB(getOwner()->getScreen().lock()->format, 255, 128, 128));
-    SDL_FillRect(m_unselectedSpeedSurface.get(), nullptr, SDL_MapRGB(getOwner()->getScreen().lock()->format, 128, 255, 128));
+    auto makeBox = [this] (Uint8 r, Uint8 g, Uint8 b)
+    {
+        Surface_ptr box = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_SWSURFACE, m_boxWidth, 
+                    m_boxHeight, Application::screenDepth, 0, 0, 0, 0));
+        SDL_FillRect(box.get(), nullptr, SDL_MapRGB(getOwner()->getScreen().lock()->format, r, g, b));
+        return box;
+    };
+
+    m_selectedSpeedSurface = resources.getSurface("MenuState.selectedSpeed", std::bind(makeBox, 255, 128, 128));
+    m_unselectedSpeedSurface = resources.getSurface("MenuState.unselectedSpeed", std::bind(makeBox, 128, 255, 128));
 
     m_titlePosition = SDL_Rect { (short)(getOwner()->getScreen().lock()->w / 2 - m_titleText->w / 2),
                                  (short)(m_titleText->h / 2 + 100), 0, 0 };
     m_initialSpeedPosition = SDL_Rect { (short)(getOwner()->getScreen().lock()->w / 2 - (m_boxWidth * maxSpeed + buttonSpacing * (maxSpeed - 1)) / 2),
                                         (short)(m_titlePosition.y + m_titleText->h + 100) };
 
-    m_helpPosition = SDL_Rect { (short)(getOwner()->getScreen().lock()->w / 2 - m_helpText->w / 2),
-                                (short)(m_initialSpeedPosition.y + m_boxHeight + 50) };
-
     m_speedSelectPosition = SDL_Rect { (short)(getOwner()->getScreen().lock()->w / 2 - 
                                        m_speedSelectText->w / 2), (short)(m_initialSpeedPosition.y -
                                        m_speedSelectText->h) };
 
+    // Only rendered on the first visit; see update.
+    if ( resources.findSurface("MenuState.help") != nullptr )
+        loadHelp();
+
     State::load();
 }
 
-void MenuState::draw(Surface_ptr a_parent)
+void MenuState::update()
 {
-    SDL_BlitSurface(m_titleText.get(), nullptr, a_parent.get(), &m_titlePosition);
-    SDL_BlitSurface(m_helpText.get(), nullptr, a_parent.get(), &m_helpPosition);
-    SDL_BlitSurface(m_speedSelectText.get(), nullptr, a_parent.get(), &m_speedSelectPosition);
+    // The help text is rendered once the first frame is up, so that the menu appears sooner.
+    if ( m_helpText == nullptr && m_drawn )
+        loadHelp();
+
+    State::update();
+}
+
+void MenuState::loadHelp()
+{
+    ResourceCache &resources = getOwner()->getResources();
+
+    m_helpText = resources.getSurface("MenuState.help", [this, &resources] ()
+    {
+        auto makeLine = [this, &resources] (const char* text)
+        {
+            return resources.getText(m_menuFont, text, SDL_Color {255, 255, 255}, SDL_Color {0, 0, 0});
+        };
+
+        std::vector<Surface_ptr> lines;
+        lines.push_back(makeLine("<Left> and <Right> to move the piece and in the menu."));
+        lines.push_back(makeLine("<Enter> selects an initial speed in the menu."));
+        lines.push_back(makeLine("<Z> and <X> rotate the piece counterclockwise and clockwise."));
+        lines.push_back(makeLine("<Space> jumps to the bottom, and <Down> makes it fall faster."));
+        lines.push_back(makeLine("<V> starts a versus match against the computer instead."));
+        lines.push_back(makeLine("<W> watches the computer play itself."));
+
+        short helpHeight = 0, helpWidth = 0;
+
+        for ( auto &p : lines )
+        {
+            helpWidth = std::max((int)helpWidth, p->w);
+            helpHeight += p->h;
+        }
+
+        Surface_ptr helpText = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_SWSURFACE, helpWidth, helpHeight, 
+                    Application::screenDepth, 0, 0, 0, 0));
+
+        helpHeight = 0;
+
+        for ( unsigned int i = 0; i < lines.size(); i++ )
+        {
+            SDL_Rect drawPosition { (short)(helpWidth / 2 - lines[i]->w / 2), helpHeight, 0, 0 };
+            blitSurface(lines[i].get(), nullptr, helpText.get(), &drawPosition);
+            helpHeight += lines[i]->h;
+        }
+
+        return helpText;
+    });
+
+    m_helpPosition = SDL_Rect { (short)(getOwner()->getScreen().lock()->w / 2 - m_helpText->w / 2),
+                                (short)(m_initialSpeedPosition.y + m_boxHeight + 50) };
+}
+
+void MenuState::activate()
+{
+    State::activate();
+
+    // The game does not depend on the speed until it starts, so it can be loaded while the player
+    // is still choosing.
+    m_nextGame = std::make_shared<Game>(getOwner(), 1);
+    getOwner()->getLoader().prewarm(m_nextGame);
+}
+
+void MenuState::draw(Surface_ptr const& a_parent)
+{
+    m_drawn = true;
+
+    blitSurface(m_titleText.get(), nullptr, a_parent.get(), &m_titlePosition);
+    if ( m_helpText != nullptr )
+        blitSurface(m_helpText.get(), nullptr, a_parent.get(), &m_helpPosition);
+    blitSurface(m_speedSelectText.get(), nullptr, a_parent.get(), &m_speedSelectPosition);
 
     SDL_Rect drawLocation;
 
@@ -106,26 +152,37 @@ void MenuState::draw(Surface_ptr a_parent)
         drawLocation = m_initialSpeedPosition;
         drawLocation.x += i * m_boxWidth + (i * buttonSpacing);
 
-        SDL_BlitSurface(i == m_selectedSpeed ? 
+        blitSurface(i == m_selectedSpeed ? 
                 m_selectedSpeedSurface.get() : m_unselectedSpeedSurface.get(),
                 nullptr, a_parent.get(), &drawLocation);
 
         drawLocation.x += m_boxWidth / 2 - m_initialSpeedTexts[i]->w / 2;
         drawLocation.y += m_boxHeight / 2 - m_initialSpeedTexts[i]->h / 2;
 
-        SDL_BlitSurface(m_initialSpeedTexts[i].get(), nullptr, a_parent.get(), &drawLocation);
+        blitSurface(m_initialSpeedTexts[i].get(), nullptr, a_parent.get(), &drawLocation);
     }
 }
 
-void MenuState::handleEvent(SDL_Event const& event)
+void MenuState::handleEvent(SDL_Event const& event, Uint32 a_time)
 {
-    if ( event.type == SDL_KEYUP )
+    if ( event.type == SDL_KEYDOWN )
     {
         switch ( event.key.keysym.sym )
         {
             case SDLK_RETURN:
                 setState(AppState::finished);
-                m_next = std::make_shared<Game>(getOwner(), m_selectedSpeed + 1);
+                if ( m_nextGame == nullptr )
+                    m_nextGame = std::make_shared<Game>(getOwner(), 1);
+                m_nextGame->setInitialSpeed(m_selectedSpeed + 1);
+                m_next = m_nextGame;
+                break;
+            case SDLK_v:
+                setState(AppState::finished);
+                m_next = std::make_shared<VersusState>(getOwner(), getOwner()->getVersusBoards(), m_selectedSpeed + 1);
+                break;
+            case SDLK_w:
+                setState(AppState::finished);
+                m_next = std::make_shared<SpectatorState>(getOwner(), SpectatorState::defaultBoards);
                 break;
             case SDLK_LEFT:
                 if ( --m_selectedSpeed < 0 )
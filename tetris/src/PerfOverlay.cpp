@@ -0,0 +1,112 @@
+#include "PerfOverlay.h"
+#include "Application.h"
+#include "AllocCounter.h"
+#include "Scheduler.h"
+#include "FrameArena.h"
+
+#include <cstdio>
+
+PerfOverlay::PerfOverlay(const Application *a_owner)
+    : State(a_owner), m_historyHead(0), m_historySize(0), m_lastBlits(0), m_ownBlits(0),
+      m_blitsPerFrame(0), m_lastAllocations(0), m_allocationsPerFrame(0),
+      m_arenaPeak(0)
+{
+    m_frameTimes.fill(0);
+}
+
+void PerfOverlay::load()
+{
+    SDL_PixelFormat *format = getOwner()->getScreen().lock()->format;
+
+    m_font  = getOwner()->getResources().getFont("resources/statusfont.ttf", 14);
+    m_atlas = getOwner()->getResources().getAtlas(m_font, SDL_Color { 255, 255, 255 }, SDL_Color { 32, 32, 32 });
+    m_atlas->optimize(); // the overlay is loaded on the main thread, when first shown
+
+    m_panelColor   = SDL_MapRGB(format, 32, 32, 32);
+    m_barColor     = SDL_MapRGB(format, 64, 200, 64);
+    m_slowBarColor = SDL_MapRGB(format, 230, 64, 64);
+    m_budgetColor  = SDL_MapRGB(format, 200, 200, 200);
+
+    m_lastBlits = getBlitCount();
+    m_lastAllocations = getAllocationCount();
+
+    State::load();
+}
+
+void PerfOverlay::update()
+{
+    unsigned long blits = getBlitCount();
+    std::uint64_t allocations = getAllocationCount();
+
+    // The overlay's own blits are left out, so that showing it does not change what it reports.
+    m_blitsPerFrame = blits - m_lastBlits - m_ownBlits;
+    m_allocationsPerFrame = allocations - m_lastAllocations;
+    m_arenaPeak = frameArena().getHighWater();
+    m_lastBlits = blits;
+    m_lastAllocations = allocations;
+    m_ownBlits = 0;
+
+    m_frameTimes[m_historyHead] = getOwner()->getInstrumentation().getLast(Instrumentation::Metric::frameTotal);
+    m_historyHead = (m_historyHead + 1) % historyLength;
+    if ( m_historySize < historyLength )
+        m_historySize++;
+}
+
+void PerfOverlay::draw(Surface_ptr const& a_parent)
+{
+    Instrumentation const& instrumentation = getOwner()->getInstrumentation();
+    unsigned long blitsBefore = getBlitCount();
+
+    std::uint64_t total = 0;
+    for ( unsigned int i = 0; i < m_historySize; i++ )
+        total += m_frameTimes[i];
+
+    double averageFrame = m_historySize == 0 ? 0 : (double)total / m_historySize / 1000.0;
+    double fps = averageFrame == 0 ? 0 : 1000.0 / averageFrame;
+
+    char lines[4][64];
+    std::snprintf(lines[0], sizeof(lines[0]), "FPS %5.1f   frame %5.2f ms", fps, averageFrame);
+    std::snprintf(lines[1], sizeof(lines[1]), "update %5.2f ms   draw %5.2f ms",
+                  instrumentation.getLast(Instrumentation::Metric::frameUpdate) / 1000.0,
+                  instrumentation.getLast(Instrumentation::Metric::frameDraw) / 1000.0);
+    std::snprintf(lines[2], sizeof(lines[2]), "blits %lu   allocs %lu   arena peak %lu B",
+                  m_blitsPerFrame, (unsigned long)m_allocationsPerFrame, (unsigned long)m_arenaPeak);
+    std::snprintf(lines[3], sizeof(lines[3]), "timers %lu", (unsigned long)Scheduler::getTotalPending());
+
+    unsigned short width = historyLength * barWidth, textHeight = 4 * m_atlas->getHeight();
+    for ( auto &line : lines )
+        width = std::max(width, (unsigned short)m_atlas->measure(line));
+
+    SDL_Rect panel = makeRect(a_parent->w - width - 3 * margin, margin, width + 2 * margin,
+                              textHeight + graphHeight + 3 * margin);
+    SDL_FillRect(a_parent.get(), &panel, m_panelColor);
+
+    short y = panel.y + margin;
+    for ( auto &line : lines )
+    {
+        m_atlas->draw(line, a_parent.get(), panel.x + margin, y);
+        y += m_atlas->getHeight();
+    }
+
+    drawGraph(a_parent.get(), panel.x + margin, y + margin);
+
+    m_ownBlits += getBlitCount() - blitsBefore;
+}
+
+// One bar per frame, oldest on the left, with a line at the frame budget.
+void PerfOverlay::drawGraph(SDL_Surface *a_dest, short a_x, short a_y)
+{
+    static const unsigned int budget = 1000000 / Application::FRAMERATE; // microseconds
+
+    for ( unsigned int i = 0; i < m_historySize; i++ )
+    {
+        std::uint32_t micros = m_frameTimes[(m_historyHead + historyLength - m_historySize + i) % historyLength];
+        unsigned short height = std::min((std::uint32_t)graphHeight, micros * graphScale / 1000);
+
+        SDL_Rect bar = makeRect(a_x + i * barWidth, a_y + graphHeight - height, barWidth, height);
+        SDL_FillRect(a_dest, &bar, micros > budget + 1000 ? m_slowBarColor : m_barColor);
+    }
+
+    SDL_Rect line = makeRect(a_x, a_y + graphHeight - budget * graphScale / 1000, historyLength * barWidth, 1);
+    SDL_FillRect(a_dest, &line, m_budgetColor);
+}
@@ -0,0 +1,631 @@
+#include "Replay.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <fstream>
+
+static const char magic[4] = { 'T', 'R', 'P', 'L' };
+
+// Room for an hour of play. Actions average about a quarter of a byte a tick, reserved twice over;
+// a checksum entry is at most a 3-byte varint and the checksum.
+static const std::size_t reservedTicks = 60 * 60 * 60;
+static const std::size_t reservedActionBytes = reservedTicks / 2;
+static const std::size_t checksumEntryBytes = 3 + 4;
+static const std::size_t reservedKeyframes = reservedTicks / Replay::keyframeInterval;
+
+static void putVarint(std::vector<unsigned char> & a_out, std::uint64_t a_value)
+{
+    while ( a_value >= 0x80 )
+    {
+        a_out.push_back((a_value & 0x7f) | 0x80);
+        a_value >>= 7;
+    }
+    a_out.push_back(a_value);
+}
+
+// Reads a varint at a_pos, advancing it. Returns false if the data ends first or the value does
+// not fit.
+static bool getVarint(const unsigned char *a_data, std::size_t a_size, std::size_t & a_pos, std::uint64_t & a_value)
+{
+    a_value = 0;
+
+    for ( unsigned int shift = 0; shift < 64; shift += 7 )
+    {
+        if ( a_pos >= a_size )
+            return false;
+
+        unsigned char byte = a_data[a_pos++];
+        a_value |= std::uint64_t(byte & 0x7f) << shift;
+
+        if ( (byte & 0x80) == 0 )
+            return true;
+    }
+
+    return false;
+}
+
+static void putFixed(std::vector<unsigned char> & a_out, std::uint64_t a_value, unsigned int a_bytes)
+{
+    for ( unsigned int i = 0; i < a_bytes; i++ )
+        a_out.push_back(a_value >> (8 * i));
+}
+
+static std::uint64_t getFixed(const unsigned char *a_data, unsigned int a_bytes)
+{
+    std::uint64_t value = 0;
+
+    for ( unsigned int i = 0; i < a_bytes; i++ )
+        value |= std::uint64_t(a_data[i]) << (8 * i);
+
+    return value;
+}
+
+static const char keyMagic[4] = { 'T', 'K', 'E', 'Y' };
+
+static const std::size_t indexEntrySize = 24;
+static const std::size_t trailerSize = 24;
+
+static_assert(sizeof(StandardWell::StorageType::Row) <= 2, "keyframes store the well's rows in 16 bits");
+
+// Keyframes are written field by field, so that the file does not depend on the snapshot's layout.
+static void putSnapshot(std::vector<unsigned char> & a_out, Simulation::Snapshot const& a_snapshot)
+{
+    for ( auto row : a_snapshot.rows )
+        putFixed(a_out, row, 2);
+
+    for ( auto const& block : a_snapshot.blocks )
+        a_out.insert(a_out.end(), block, block + 2);
+
+    for ( std::uint8_t byte : { a_snapshot.blockCount, a_snapshot.pivots, a_snapshot.pieceID, a_snapshot.nextPieceID,
+                                a_snapshot.rotationID, a_snapshot.flags, a_snapshot.lockPhase, a_snapshot.lockTicks } )
+        a_out.push_back(byte);
+
+    for ( std::uint32_t word : { a_snapshot.clearingRows, a_snapshot.randomState, a_snapshot.time,
+                                 a_snapshot.score, a_snapshot.clearedLines, a_snapshot.speed } )
+        putFixed(a_out, word, 4);
+
+    putFixed(a_out, a_snapshot.ticks, 8);
+    putFixed(a_out, a_snapshot.checksum, 4);
+}
+
+static void getSnapshot(const unsigned char *a_data, Simulation::Snapshot & a_snapshot)
+{
+    for ( auto & row : a_snapshot.rows )
+    {
+        row = getFixed(a_data, 2);
+        a_data += 2;
+    }
+
+    for ( auto & block : a_snapshot.blocks )
+    {
+        block[0] = *a_data++;
+        block[1] = *a_data++;
+    }
+
+    for ( std::uint8_t *byte : { &a_snapshot.blockCount, &a_snapshot.pivots, &a_snapshot.pieceID, &a_snapshot.nextPieceID,
+                                 &a_snapshot.rotationID, &a_snapshot.flags, &a_snapshot.lockPhase, &a_snapshot.lockTicks } )
+        *byte = *a_data++;
+
+    for ( std::uint32_t *word : { &a_snapshot.clearingRows, &a_snapshot.randomState, &a_snapshot.time,
+                                  &a_snapshot.score, &a_snapshot.clearedLines, &a_snapshot.speed } )
+    {
+        *word = getFixed(a_data, 4);
+        a_data += 4;
+    }
+
+    a_snapshot.ticks = getFixed(a_data, 8);
+    a_snapshot.checksum = getFixed(a_data + 8, 4);
+}
+
+// // // REPLAY // // //
+
+Replay::Replay()
+{
+    close();
+}
+
+bool Replay::load(std::string const& a_path)
+{
+    close();
+
+    if ( ! m_file.open(a_path) )
+        return false;
+
+    m_data = m_file.data();
+    m_size = m_file.size();
+
+    return open();
+}
+
+bool Replay::parse(const unsigned char *a_data, std::size_t a_size)
+{
+    close();
+
+    m_copy.assign(a_data, a_data + a_size);
+    m_data = m_copy.data();
+    m_size = m_copy.size();
+
+    return open();
+}
+
+bool Replay::open()
+{
+    std::size_t pos = sizeof(magic);
+    std::uint64_t fileVersion, seed, initialSpeed;
+
+    if ( m_size < sizeof(magic) || std::memcmp(m_data, magic, sizeof(magic)) != 0 ||
+         ! getVarint(m_data, m_size, pos, fileVersion) || fileVersion != version ||
+         ! getVarint(m_data, m_size, pos, seed) || seed > 0xffffffff ||
+         ! getVarint(m_data, m_size, pos, initialSpeed) || initialSpeed == 0 || initialSpeed > Simulation::speedLimit )
+    {
+        close();
+        return false;
+    }
+
+    if ( m_size < pos + trailerSize || std::memcmp(m_data + m_size - sizeof(keyMagic), keyMagic, sizeof(keyMagic)) != 0 )
+    {
+        close();
+        return false;
+    }
+
+    const unsigned char *trailer = m_data + m_size - trailerSize;
+
+    std::uint64_t length = getFixed(trailer, 8);
+    std::size_t recordsEnd = getFixed(trailer + 8, 4), indexOffset = getFixed(trailer + 12, 4),
+                keyframeCount = getFixed(trailer + 16, 4);
+
+    if ( recordsEnd < pos || recordsEnd > indexOffset ||
+         (m_size - trailerSize - indexOffset) / indexEntrySize != keyframeCount ||
+         (m_size - trailerSize - indexOffset) % indexEntrySize != 0 )
+    {
+        close();
+        return false;
+    }
+
+    for ( std::size_t i = 0; i < keyframeCount; i++ )
+    {
+        const unsigned char *entry = m_data + indexOffset + i * indexEntrySize;
+        std::uint64_t keyframeOffset = getFixed(entry + 20, 4);
+
+        if ( getFixed(entry + 16, 4) < pos || getFixed(entry + 16, 4) > recordsEnd ||
+             keyframeOffset < recordsEnd || keyframeOffset + keyframeSize > indexOffset ||
+             (i > 0 && getFixed(entry, 8) <= getFixed(entry - indexEntrySize, 8)) )
+        {
+            close();
+            return false;
+        }
+
+        // Seeking restores keyframes as they are, so each must be one a simulation can take.
+        Simulation::Snapshot snapshot;
+        getSnapshot(m_data + keyframeOffset, snapshot);
+
+        if ( ! Simulation::isValid(snapshot) )
+        {
+            close();
+            return false;
+        }
+    }
+
+    // One pass over the records, to reject a damaged replay before it is played. It does not
+    // keep anything: records are read again as they are played.
+    std::uint64_t tick = 0, record;
+    bool ended = false, hasResults = false;
+    Results results {};
+
+    while ( ! ended && getVarint(m_data, recordsEnd, pos, record) )
+    {
+        tick += record >> kindBits;
+        unsigned int kind = record & endKind;
+
+        if ( kind == endKind )
+            ended = true;
+        else if ( hasResults ) // only the end record comes after the results
+            break;
+        else if ( kind == checksumKind )
+        {
+            if ( recordsEnd - pos < 4 )
+                break;
+            pos += 4;
+        }
+        else if ( kind == resultsKind )
+        {
+            std::uint64_t score, lines, level;
+
+            if ( ! getVarint(m_data, recordsEnd, pos, score) || score > 0xffffffff ||
+                 ! getVarint(m_data, recordsEnd, pos, lines) || lines > 0xffffffff ||
+                 ! getVarint(m_data, recordsEnd, pos, level) || level > 0xffffffff || recordsEnd - pos < 4 )
+                break;
+
+            results = Results { (unsigned int)score, (unsigned int)lines, (unsigned int)level, (std::uint32_t)getFixed(m_data + pos, 4) };
+            hasResults = true;
+            pos += 4;
+        }
+        else if ( kind >= Simulation::actionCount )
+            break;
+    }
+
+    // The end record is the last, and agrees with the trailer.
+    if ( ! ended || pos != recordsEnd || tick != length )
+    {
+        close();
+        return false;
+    }
+
+    m_seed = seed;
+    m_initialSpeed = initialSpeed;
+    m_length = tick;
+    m_hasResults = hasResults;
+    m_results = results;
+    m_recordsBegin = sizeof(magic);
+    m_recordsEnd = recordsEnd;
+    m_indexOffset = indexOffset;
+    m_keyframeCount = keyframeCount;
+
+    // Past the header.
+    getVarint(m_data, m_size, m_recordsBegin, record);
+    getVarint(m_data, m_size, m_recordsBegin, record);
+    getVarint(m_data, m_size, m_recordsBegin, record);
+
+    return true;
+}
+
+void Replay::close()
+{
+    m_file.close();
+    m_copy.clear();
+    m_data = nullptr;
+    m_size = 0;
+
+    m_seed = 0;
+    m_initialSpeed = 1;
+    m_length = 0;
+    m_hasResults = false;
+    m_results = Results {};
+    m_recordsBegin = m_recordsEnd = m_indexOffset = m_keyframeCount = 0;
+}
+
+// // // OBSERVERS // // //
+
+std::uint32_t Replay::getSeed() const
+{
+    return m_seed;
+}
+
+unsigned int Replay::getInitialSpeed() const
+{
+    return m_initialSpeed;
+}
+
+std::uint64_t Replay::getLength() const
+{
+    return m_length;
+}
+
+std::size_t Replay::getKeyframeCount() const
+{
+    return m_keyframeCount;
+}
+
+bool Replay::hasResults() const
+{
+    return m_hasResults;
+}
+
+Replay::Results const& Replay::getResults() const
+{
+    return m_results;
+}
+
+Replay::Cursor Replay::begin() const
+{
+    return Cursor { m_recordsBegin, 0 };
+}
+
+bool Replay::next(Cursor & a_cursor, Entry & a_entry) const
+{
+    std::uint64_t record;
+
+    // Checked when the replay was opened: every record before the results and the end record is
+    // an action or a checksum.
+    if ( ! getVarint(m_data, m_recordsEnd, a_cursor.offset, record) ||
+         (record & endKind) == endKind || (record & endKind) == resultsKind )
+        return false;
+
+    a_cursor.tick += record >> kindBits;
+    a_entry.tick = a_cursor.tick;
+    a_entry.isChecksum = (record & endKind) == checksumKind;
+
+    if ( a_entry.isChecksum )
+    {
+        a_entry.checksum = getFixed(m_data + a_cursor.offset, 4);
+        a_cursor.offset += 4;
+    }
+    else
+        a_entry.action = (Simulation::Action)(record & endKind);
+
+    return true;
+}
+
+bool Replay::findKeyframe(std::uint64_t a_tick, Simulation::Snapshot & a_snapshot, Cursor & a_cursor) const
+{
+    // The first entry after a_tick; the one before it is the keyframe.
+    std::size_t low = 0, high = m_keyframeCount;
+
+    while ( low < high )
+    {
+        std::size_t middle = (low + high) / 2;
+
+        if ( getFixed(m_data + m_indexOffset + middle * indexEntrySize, 8) <= a_tick )
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    if ( low == 0 )
+        return false;
+
+    const unsigned char *entry = m_data + m_indexOffset + (low - 1) * indexEntrySize;
+
+    a_cursor.tick = getFixed(entry + 8, 8);
+    a_cursor.offset = getFixed(entry + 16, 4);
+    getSnapshot(m_data + getFixed(entry + 20, 4), a_snapshot);
+
+    return true;
+}
+
+// // // RECORDER // // //
+
+ReplayRecorder::ReplayRecorder()
+    : m_checksumInterval(0), m_lastTick(0), m_afterTick(0), m_recording(false), m_finished(false)
+{
+}
+
+void ReplayRecorder::begin(std::uint32_t a_seed, unsigned int a_initialSpeed, unsigned int a_checksumInterval)
+{
+    std::size_t checksums = a_checksumInterval == 0 ? 0 : reservedTicks / a_checksumInterval;
+
+    m_bytes.clear();
+    m_bytes.reserve(reservedActionBytes + checksums * checksumEntryBytes);
+    m_keyframes.clear();
+    m_keyframes.reserve(reservedKeyframes * Replay::keyframeSize);
+    m_index.clear();
+    m_index.reserve(reservedKeyframes);
+
+    m_bytes.insert(m_bytes.end(), magic, magic + sizeof(magic));
+    putVarint(m_bytes, Replay::version);
+    putVarint(m_bytes, a_seed);
+    putVarint(m_bytes, a_initialSpeed);
+
+    m_checksumInterval = a_checksumInterval;
+    m_lastTick = 0;
+    m_afterTick = 0;
+    m_recording = true;
+    m_finished = false;
+}
+
+void ReplayRecorder::record(std::uint64_t a_tick, Simulation::Action a_action)
+{
+    if ( m_recording )
+        put(a_tick, (unsigned int)a_action);
+}
+
+void ReplayRecorder::afterTick(Simulation const& a_simulation)
+{
+    std::uint64_t tick = a_simulation.getTicks();
+
+    // A simulation that is over no longer ticks, but may still be passed in.
+    if ( ! m_recording || tick == m_afterTick )
+        return;
+
+    m_afterTick = tick;
+
+    if ( tick % Replay::keyframeInterval == 0 )
+    {
+        m_index.push_back(IndexEntry { tick, m_lastTick, (std::uint32_t)m_bytes.size(), (std::uint32_t)m_keyframes.size() });
+        putSnapshot(m_keyframes, a_simulation.snapshot());
+    }
+
+    if ( m_checksumInterval != 0 && tick % m_checksumInterval == 0 )
+    {
+        put(tick, Replay::checksumKind);
+        putFixed(m_bytes, a_simulation.getChecksum(), 4);
+    }
+}
+
+void ReplayRecorder::finish(Simulation const& a_simulation)
+{
+    if ( ! m_recording )
+        return;
+
+    std::uint64_t ticks = a_simulation.getTicks();
+
+    put(ticks, Replay::resultsKind);
+    putVarint(m_bytes, a_simulation.getScore());
+    putVarint(m_bytes, a_simulation.getClearedLines());
+    putVarint(m_bytes, a_simulation.getLevel());
+    putFixed(m_bytes, a_simulation.getChecksum(), 4);
+
+    put(ticks, Replay::endKind);
+
+    std::size_t recordsEnd = m_bytes.size();
+    m_bytes.insert(m_bytes.end(), m_keyframes.begin(), m_keyframes.end());
+
+    std::size_t indexOffset = m_bytes.size();
+    for ( IndexEntry const& entry : m_index )
+    {
+        putFixed(m_bytes, entry.tick, 8);
+        putFixed(m_bytes, entry.recordTick, 8);
+        putFixed(m_bytes, entry.recordOffset, 4);
+        putFixed(m_bytes, recordsEnd + entry.keyframeOffset, 4);
+    }
+
+    putFixed(m_bytes, ticks, 8);
+    putFixed(m_bytes, recordsEnd, 4);
+    putFixed(m_bytes, indexOffset, 4);
+    putFixed(m_bytes, m_index.size(), 4);
+    m_bytes.insert(m_bytes.end(), keyMagic, keyMagic + sizeof(keyMagic));
+
+    m_recording = false;
+    m_finished = true;
+}
+
+void ReplayRecorder::cancel()
+{
+    m_recording = false;
+    m_finished = false;
+}
+
+bool ReplayRecorder::isRecording() const
+{
+    return m_recording;
+}
+
+bool ReplayRecorder::isFinished() const
+{
+    return m_finished;
+}
+
+bool ReplayRecorder::save(std::string const& a_path) const
+{
+    if ( ! m_finished )
+        return false;
+
+    std::ofstream out(a_path, std::ios::binary);
+    out.write((const char*)m_bytes.data(), m_bytes.size());
+
+    return (bool)out;
+}
+
+std::vector<unsigned char> const& ReplayRecorder::getBytes() const
+{
+    return m_bytes;
+}
+
+void ReplayRecorder::put(std::uint64_t a_tick, unsigned int a_kind)
+{
+    putVarint(m_bytes, ((a_tick - m_lastTick) << Replay::kindBits) | a_kind);
+    m_lastTick = a_tick;
+}
+
+// // // PLAYER // // //
+
+ReplayPlayer::ReplayPlayer(std::shared_ptr<Replay const> a_replay)
+    : m_replay(std::move(a_replay)), m_cursor(m_replay->begin()),
+      m_diverged(false), m_divergedTick(0), m_lastVerifiedTick(0), m_verifiedCount(0)
+{
+    fetch();
+}
+
+Simulation ReplayPlayer::makeSimulation() const
+{
+    return Simulation(m_replay->getSeed(), m_replay->getInitialSpeed());
+}
+
+bool ReplayPlayer::step(Simulation & a_simulation)
+{
+    if ( isDone(a_simulation) )
+        return false;
+
+    while ( m_hasNext && m_next.tick <= a_simulation.getTicks() )
+    {
+        if ( m_next.isChecksum )
+            verify(a_simulation);
+        else
+            a_simulation.apply(m_next.action);
+        fetch();
+    }
+
+    a_simulation.tick();
+
+    // The checksum of the tick that just ran comes before its actions; checking it now catches
+    // the last one, after which the replay is done.
+    while ( m_hasNext && m_next.isChecksum && m_next.tick <= a_simulation.getTicks() )
+    {
+        verify(a_simulation);
+        fetch();
+    }
+
+    return true;
+}
+
+void ReplayPlayer::seek(Simulation & a_simulation, std::uint64_t a_tick)
+{
+    Simulation::Snapshot keyframe;
+    Replay::Cursor cursor = m_replay->begin();
+    bool found = m_replay->findKeyframe(a_tick, keyframe, cursor);
+
+    // Going on from where the simulation is saves restoring, when no keyframe is closer.
+    if ( a_tick < a_simulation.getTicks() || (found && keyframe.ticks > a_simulation.getTicks()) )
+    {
+        a_simulation.restore(found ? keyframe : makeSimulation().snapshot());
+        m_cursor = cursor;
+        fetch();
+    }
+
+    while ( a_simulation.getTicks() < a_tick && step(a_simulation) )
+        ;
+}
+
+bool ReplayPlayer::isDone(Simulation const& a_simulation) const
+{
+    return a_simulation.isOver() || a_simulation.getTicks() >= m_replay->getLength();
+}
+
+Replay const& ReplayPlayer::getReplay() const
+{
+    return *m_replay;
+}
+
+bool ReplayPlayer::hasDiverged() const
+{
+    return m_diverged;
+}
+
+std::uint64_t ReplayPlayer::getDivergedTick() const
+{
+    return m_divergedTick;
+}
+
+std::uint64_t ReplayPlayer::getLastVerifiedTick() const
+{
+    return m_lastVerifiedTick;
+}
+
+unsigned long ReplayPlayer::getVerifiedCount() const
+{
+    return m_verifiedCount;
+}
+
+bool ReplayPlayer::matchesResults(Simulation const& a_simulation) const
+{
+    if ( ! m_replay->hasResults() )
+        return true;
+
+    Replay::Results const& results = m_replay->getResults();
+
+    return a_simulation.getTicks() == m_replay->getLength() &&
+           a_simulation.getScore() == results.score && a_simulation.getClearedLines() == results.clearedLines &&
+           a_simulation.getLevel() == results.level && a_simulation.getChecksum() == results.checksum;
+}
+
+void ReplayPlayer::fetch()
+{
+    m_hasNext = m_replay->next(m_cursor, m_next);
+}
+
+void ReplayPlayer::verify(Simulation const& a_simulation)
+{
+    if ( m_next.tick != a_simulation.getTicks() || m_diverged )
+        return;
+
+    if ( m_next.checksum == a_simulation.getChecksum() )
+    {
+        m_lastVerifiedTick = m_next.tick;
+        m_verifiedCount++;
+    }
+    else
+    {
+        m_diverged = true;
+        m_divergedTick = m_next.tick;
+    }
+}
@@ -0,0 +1,78 @@
+#include "ResourceArchive.h"
+
+#include <cstring>
+
+static std::uint32_t readU32(const unsigned char *p)
+{
+    return (std::uint32_t)p[0] | (std::uint32_t)p[1] << 8 | (std::uint32_t)p[2] << 16 | (std::uint32_t)p[3] << 24;
+}
+
+ResourceArchive::ResourceArchive()
+{
+}
+
+bool ResourceArchive::open(const unsigned char *a_data, std::size_t a_size)
+{
+    m_entries.clear();
+
+    if ( a_size < 12 || std::memcmp(a_data, "TPAK", 4) != 0 || readU32(a_data + 4) != version )
+        return false;
+
+    std::uint32_t count = readU32(a_data + 8);
+    std::size_t at = 12;
+
+    for ( std::uint32_t i = 0; i < count; i++ )
+    {
+        if ( at + 2 > a_size )
+            break;
+
+        std::size_t nameLength = a_data[at] | a_data[at + 1] << 8;
+        at += 2;
+
+        if ( at + nameLength + 8 > a_size )
+            break;
+
+        std::string name((const char*)a_data + at, nameLength);
+        at += nameLength;
+
+        std::uint32_t offset = readU32(a_data + at), size = readU32(a_data + at + 4);
+        at += 8;
+
+        if ( (std::size_t)offset + size > a_size )
+            break;
+
+        m_entries[name] = Entry { a_data + offset, size };
+    }
+
+    if ( m_entries.size() != count )
+    {
+        m_entries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool ResourceArchive::openFile(std::string const& a_path)
+{
+    if ( ! m_file.open(a_path) )
+        return false;
+
+    return open(m_file.data(), m_file.size());
+}
+
+bool ResourceArchive::find(std::string const& a_name, Entry & a_entry) const
+{
+    auto found = m_entries.find(a_name);
+
+    if ( found == m_entries.end() )
+        return false;
+
+    a_entry = found->second;
+    return true;
+}
+
+std::size_t ResourceArchive::getCount() const
+{
+    return m_entries.size();
+}
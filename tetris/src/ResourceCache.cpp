@@ -0,0 +1,224 @@
+#include "ResourceCache.h"
+#include "AllocAccounting.h"
+#include "Log.h"
+
+ResourceCache::ResourceCache()
+    : m_archive(nullptr), m_hits(0), m_misses(0)
+{
+}
+
+void ResourceCache::setArchive(ResourceArchive const* a_archive)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    m_archive = a_archive;
+}
+
+// // // LOOKUP // // //
+
+Font_ptr ResourceCache::getFont(std::string const& a_path, int a_size)
+{
+    ALLOC_TAG(ttf);
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    FontKey key(a_path, a_size);
+    auto found = m_fonts.find(key);
+
+    if ( found != m_fonts.end() )
+    {
+        m_hits++;
+        return found->second;
+    }
+
+    m_misses++;
+
+    // Fonts from the archive are read in place; SDL_ttf keeps reading from the memory for as long
+    // as the font is open.
+    ResourceArchive::Entry entry;
+    Font_ptr font = makeSafeFontPtr(m_archive != nullptr && m_archive->find(a_path, entry)
+            ? TTF_OpenFontRW(SDL_RWFromConstMem(entry.data, entry.size), 1, a_size)
+            : TTF_OpenFont(a_path.c_str(), a_size));
+
+    if ( font.get() == nullptr )
+    {
+        LOG_ERROR("Failed to open the font %s: %s", a_path.c_str(), SDL_GetError());
+        return font; // not cached, so that the next call tries again
+    }
+
+    m_fonts[key] = font;
+    return font;
+}
+
+Surface_ptr ResourceCache::getText(Font_ptr a_font, std::string const& a_text, SDL_Color a_fg, SDL_Color a_bg,
+                                   TextStyle a_style)
+{
+    ALLOC_TAG(ttf);
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    TextKey key(a_font.get(), a_text, packColor(a_fg),
+                a_style == TextStyle::blended ? 0 : packColor(a_bg), (int)a_style);
+    auto found = m_texts.find(key);
+
+    if ( found != m_texts.end() )
+    {
+        m_hits++;
+        return found->second.resource;
+    }
+
+    m_misses++;
+
+    Surface_ptr text = makeSafeSurfacePtr(a_style == TextStyle::shaded
+            ? TTF_RenderText_Shaded(a_font.get(), a_text.c_str(), a_fg, a_bg)
+            : TTF_RenderText_Blended(a_font.get(), a_text.c_str(), a_fg));
+
+    if ( text.get() != nullptr )
+        m_texts[key] = Rendered<SDL_Surface> { a_font, text };
+
+    return text;
+}
+
+GlyphAtlas_ptr ResourceCache::getAtlas(Font_ptr a_font, SDL_Color a_fg, SDL_Color a_bg, const char *a_glyphs)
+{
+    ALLOC_TAG(ttf);
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    AtlasKey key(a_font.get(), packColor(a_fg), packColor(a_bg), a_glyphs == nullptr ? "" : a_glyphs);
+    auto found = m_atlases.find(key);
+
+    if ( found != m_atlases.end() )
+    {
+        m_hits++;
+        return found->second.resource;
+    }
+
+    m_misses++;
+
+    GlyphAtlas_ptr atlas = std::make_shared<GlyphAtlas>(a_font.get(), a_fg, a_bg, a_glyphs);
+    m_atlases[key] = Rendered<GlyphAtlas> { a_font, atlas };
+
+    return atlas;
+}
+
+Surface_ptr ResourceCache::getSurface(std::string const& a_name, std::function<Surface_ptr()> a_make)
+{
+    ALLOC_TAG(ttf);
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    auto found = m_surfaces.find(a_name);
+
+    if ( found != m_surfaces.end() )
+    {
+        m_hits++;
+        return found->second;
+    }
+
+    m_misses++;
+
+    Surface_ptr surface = a_make();
+
+    if ( surface.get() != nullptr )
+        m_surfaces[a_name] = surface;
+
+    return surface;
+}
+
+Surface_ptr ResourceCache::findSurface(std::string const& a_name) const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    auto found = m_surfaces.find(a_name);
+
+    return found == m_surfaces.end() ? nullptr : found->second;
+}
+
+// // // PRELOADING AND EVICTION // // //
+
+void ResourceCache::preloadFont(std::string const& a_path, int a_size)
+{
+    getFont(a_path, a_size);
+}
+
+// Erases the entries of a_map whose handle, as returned by a_handle, is not shared with anyone.
+template<typename Map, typename Handle>
+static unsigned int evictUnshared(Map & a_map, Handle a_handle)
+{
+    unsigned int evicted = 0;
+
+    for ( auto i = a_map.begin(); i != a_map.end(); )
+    {
+        if ( a_handle(i->second).use_count() == 1 )
+        {
+            i = a_map.erase(i);
+            evicted++;
+        }
+        else
+            i++;
+    }
+
+    return evicted;
+}
+
+unsigned int ResourceCache::evictUnused()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    unsigned int evicted = 0;
+
+    // Renderings go first, since they hold references to fonts.
+    // (The lambdas return references; a copy of the handle would count as another user.)
+    evicted += evictUnshared(m_texts, [] (Rendered<SDL_Surface> const& r) -> Surface_ptr const& { return r.resource; });
+    evicted += evictUnshared(m_atlases, [] (Rendered<GlyphAtlas> const& r) -> GlyphAtlas_ptr const& { return r.resource; });
+    evicted += evictUnshared(m_surfaces, [] (Surface_ptr const& s) -> Surface_ptr const& { return s; });
+    evicted += evictUnshared(m_fonts, [] (Font_ptr const& f) -> Font_ptr const& { return f; });
+
+    return evicted;
+}
+
+void ResourceCache::evictFont(std::string const& a_path, int a_size)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    m_fonts.erase(FontKey(a_path, a_size));
+}
+
+void ResourceCache::evictSurface(std::string const& a_name)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    m_surfaces.erase(a_name);
+}
+
+void ResourceCache::clear()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    m_texts.clear();
+    m_atlases.clear();
+    m_surfaces.clear();
+    m_fonts.clear();
+}
+
+// // // STATISTICS // // //
+
+unsigned int ResourceCache::getHits() const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    return m_hits;
+}
+
+unsigned int ResourceCache::getMisses() const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    return m_misses;
+}
+
+Uint32 ResourceCache::packColor(SDL_Color a_color)
+{
+    return (Uint32)a_color.r << 16 | (Uint32)a_color.g << 8 | (Uint32)a_color.b;
+}
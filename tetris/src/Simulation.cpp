@@ -0,0 +1,507 @@
+#include "Simulation.h"
+#include "FrameArena.h"
+#include "Trace.h"
+#include "AllocAccounting.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <utility>
+
+// One round of a hash over 64-bit words, as in xxHash.
+static std::uint64_t mix(std::uint64_t a_hash, std::uint64_t a_value)
+{
+    a_hash ^= a_value * 0x9e3779b97f4a7c15;
+    a_hash = (a_hash << 31) | (a_hash >> 33);
+    return a_hash * 0xc2b2ae3d27d4eb4f;
+}
+
+// Hashes everything in a_snapshot but its checksum, field by field, so that padding is left out.
+static std::uint64_t hashState(Simulation::Snapshot const& a_snapshot)
+{
+    std::uint64_t hash = 0, word = 0;
+
+    for ( unsigned int y = 0; y < Simulation::wellHeight; y++ )
+    {
+        word = (word << 16) | a_snapshot.rows[y];
+        if ( y % 4 == 3 || y == Simulation::wellHeight - 1 )
+            hash = mix(hash, word);
+    }
+
+    word = 0;
+    for ( auto const& block : a_snapshot.blocks )
+        word = (word << 16) | (block[0] << 8) | block[1];
+    hash = mix(hash, word);
+
+    word = 0;
+    for ( std::uint8_t byte : { a_snapshot.blockCount, a_snapshot.pivots, a_snapshot.pieceID, a_snapshot.nextPieceID,
+                                a_snapshot.rotationID, a_snapshot.flags, a_snapshot.lockPhase, a_snapshot.lockTicks } )
+        word = (word << 8) | byte;
+    hash = mix(hash, word);
+
+    hash = mix(hash, (std::uint64_t(a_snapshot.clearingRows) << 32) | a_snapshot.randomState);
+    hash = mix(hash, (std::uint64_t(a_snapshot.time) << 32) | a_snapshot.score);
+    hash = mix(hash, (std::uint64_t(a_snapshot.clearedLines) << 32) | a_snapshot.speed);
+    return mix(hash, a_snapshot.ticks);
+}
+
+Simulation::Simulation(std::uint32_t a_seed, unsigned int a_initialSpeed)
+    : m_lockPhase(LockPhase::none), m_pendingGarbage(0), m_fallFaster(false), m_falling(true), m_over(false),
+      m_seed(a_seed), m_initialSpeed(a_initialSpeed), m_ticks(0), m_checksum(0),
+      m_time(1), m_score(0), m_clearedLines(0), m_speed(a_initialSpeed), m_telemetry(nullptr)
+{
+    // Sized up front, so that the game does not allocate while it runs.
+    m_clearingRows.reserve(m_well.getWellHeight());
+    m_garbage.reserve(m_well.getWellHeight());
+    m_scheduler.reserve(4);
+
+    m_well.seed(a_seed);
+    m_well.newPiece(); // cannot fail in an empty well
+}
+
+void Simulation::setInitialSpeed(unsigned int a_speed)
+{
+    m_initialSpeed = a_speed;
+    m_speed = a_speed;
+}
+
+void Simulation::warmUp()
+{
+    // Never started: handleNewPiece replaces it, and the new sequence reuses its frame.
+    if ( m_lockPhase == LockPhase::none )
+        m_lockScript = lockPiece();
+}
+
+void Simulation::restore(Snapshot const& a_snapshot)
+{
+    ALLOC_TAG(effects);
+
+    StandardWell::StorageType rows;
+    StandardWell::PieceState piece;
+
+    for ( unsigned int y = 0; y < wellHeight; y++ )
+        rows.setRow(y, a_snapshot.rows[y]);
+
+    for ( unsigned int i = 0; i < a_snapshot.blockCount && i < StandardWell::maxPieceBlocks; i++ )
+        piece.piece.push_back(Block({ a_snapshot.blocks[i][0], a_snapshot.blocks[i][1] },
+                    (a_snapshot.pivots >> i) & 1 ? BlockState::pivot : BlockState::falling));
+
+    piece.pieceID = a_snapshot.pieceID;
+    piece.nextPieceID = a_snapshot.nextPieceID;
+    piece.rotationID = a_snapshot.rotationID;
+    piece.randomState = a_snapshot.randomState;
+
+    m_well.restore(rows, piece);
+
+    m_clearingRows.clear();
+    for ( unsigned int y = 0; y < wellHeight; y++ )
+        if ( (a_snapshot.clearingRows >> y) & 1 )
+            m_clearingRows.push_back(y);
+
+    m_fallFaster = a_snapshot.flags & Snapshot::fallFaster;
+    m_falling = a_snapshot.flags & Snapshot::falling;
+    m_over = a_snapshot.flags & Snapshot::over;
+
+    m_time = a_snapshot.time;
+    m_score = a_snapshot.score;
+    m_clearedLines = a_snapshot.clearedLines;
+    m_speed = a_snapshot.speed;
+    m_ticks = a_snapshot.ticks;
+    m_checksum = a_snapshot.checksum;
+
+    m_lockScript.reset();
+    m_lockPhase = LockPhase::none;
+
+    if ( a_snapshot.lockPhase != (std::uint8_t)LockPhase::none )
+    {
+        m_lockScript = lockPiece((LockPhase)a_snapshot.lockPhase, a_snapshot.lockTicks);
+        m_lockScript.start(m_scheduler);
+    }
+}
+
+bool Simulation::isValid(Snapshot const& a_snapshot)
+{
+    const unsigned int pieceCount = std::size(PIECES), rotationCount = std::size(PIECES[0]);
+
+    if ( a_snapshot.pieceID >= pieceCount || a_snapshot.nextPieceID >= pieceCount ||
+         a_snapshot.rotationID >= rotationCount || a_snapshot.blockCount > StandardWell::maxPieceBlocks ||
+         a_snapshot.speed == 0 || a_snapshot.speed > speedLimit ||
+         a_snapshot.lockPhase > (std::uint8_t)LockPhase::clearing || a_snapshot.randomState == 0 )
+        return false;
+
+    for ( unsigned int i = 0; i < a_snapshot.blockCount; i++ )
+        if ( a_snapshot.blocks[i][0] >= StandardWell::StorageType::width || a_snapshot.blocks[i][1] >= wellHeight )
+            return false;
+
+    // Rotating goes round the pivot, so a piece must have exactly one, and a falling one must be there.
+    unsigned int pivots = a_snapshot.pivots & ((1u << a_snapshot.blockCount) - 1);
+
+    if ( (a_snapshot.blockCount > 0 && (pivots == 0 || (pivots & (pivots - 1)) != 0)) ||
+         ((a_snapshot.flags & Snapshot::falling) && a_snapshot.blockCount == 0) )
+        return false;
+
+    return true;
+}
+
+void Simulation::reset(std::uint32_t a_seed)
+{
+    m_lockScript.reset();
+    m_lockPhase = LockPhase::none;
+
+    m_clearingRows.clear();
+    m_garbage.clear();
+    m_pendingGarbage = 0;
+
+    m_fallFaster = false;
+    m_falling = true;
+    m_over = false;
+
+    m_seed = a_seed;
+    m_ticks = 0;
+    m_checksum = 0;
+
+    m_time = 1;
+    m_score = 0;
+    m_clearedLines = 0;
+    m_speed = m_initialSpeed;
+
+    m_well.clear();
+    m_well.seed(a_seed);
+    m_well.newPiece();
+
+    report(TelemetryEvent::Type::gameStarted, m_seed, m_initialSpeed);
+    report(TelemetryEvent::Type::pieceSpawned, m_well.getPieceID(), m_well.getNextPieceID());
+}
+
+void Simulation::setTelemetry(Telemetry *a_telemetry)
+{
+    m_telemetry = a_telemetry;
+
+    report(TelemetryEvent::Type::gameStarted, m_seed, m_initialSpeed);
+    report(TelemetryEvent::Type::pieceSpawned, m_well.getPieceID(), m_well.getNextPieceID());
+}
+
+// // // MUTATORS // // //
+
+bool Simulation::apply(Action a_action)
+{
+    switch ( a_action )
+    {
+        case Action::softDropOn:
+            return ! std::exchange(m_fallFaster, true);
+        case Action::softDropOff:
+            return std::exchange(m_fallFaster, false);
+        default:
+            break;
+    }
+
+    if ( ! m_falling ) // all the other actions only make sense if a piece is falling.
+        return false;
+
+    bool changed = false;
+
+    switch ( a_action )
+    {
+        case Action::moveLeft:
+        case Action::moveRight:
+            changed = m_well.movePiece(a_action == Action::moveLeft ? -1 : 1);
+            if ( changed )
+                report(TelemetryEvent::Type::pieceMoved, a_action == Action::moveRight);
+            break;
+        case Action::rotateCCW:
+        case Action::rotateCW:
+            changed = m_well.rotatePiece(a_action == Action::rotateCCW ? Direction::CCW : Direction::CW);
+            if ( changed )
+                report(TelemetryEvent::Type::pieceRotated, a_action == Action::rotateCW);
+            break;
+        case Action::drop:
+            m_well.fall();
+            report(TelemetryEvent::Type::pieceLocked, m_well.getPieceID(), 1);
+            handleNewPiece();
+            changed = true;
+            break;
+        default:
+            break;
+    }
+
+    return changed;
+}
+
+void Simulation::tick()
+{
+    if ( m_over )
+        return;
+
+    if ( m_pendingGarbage > 0 && m_falling && m_lockPhase == LockPhase::none )
+    {
+        handleGarbage();
+        if ( m_over )
+            return;
+    }
+
+    // Make the blocks fall only once every (speedLimit / m_speed) ticks
+    if ( m_time % (speedLimit / (m_fallFaster ? 10 > m_speed ? 10 : m_speed : m_speed)) == 0 )
+        if ( m_falling && m_well.updatePiece() ) // if a collision took place
+        {
+            report(TelemetryEvent::Type::pieceLocked, m_well.getPieceID(), 0);
+            handleNewPiece();
+        }
+
+    {
+        ALLOC_TAG(effects);
+        m_scheduler.tick();
+    }
+
+    m_time++;
+    m_ticks++;
+
+    std::uint64_t hash = mix(m_checksum, hashState(snapshot()));
+    m_checksum = hash ^ (hash >> 32);
+}
+
+void Simulation::addGarbage(unsigned int a_rows, unsigned int a_hole)
+{
+    a_rows = std::min(a_rows, wellHeight - m_pendingGarbage);
+    if ( a_rows == 0 )
+        return;
+
+    // Each entry has at least one row, so there are never more than m_garbage has room for.
+    m_garbage.push_back(Garbage { a_rows, a_hole % m_well.getWellWidth() });
+    m_pendingGarbage += a_rows;
+}
+
+unsigned int Simulation::cancelGarbage(unsigned int a_rows)
+{
+    auto it = m_garbage.begin();
+
+    for ( ; it != m_garbage.end() && a_rows > 0; ++it )
+    {
+        unsigned int cancelled = std::min(a_rows, it->rows);
+
+        it->rows -= cancelled;
+        a_rows -= cancelled;
+        m_pendingGarbage -= cancelled;
+
+        if ( it->rows > 0 )
+            break;
+    }
+
+    m_garbage.erase(m_garbage.begin(), it);
+    return a_rows;
+}
+
+void Simulation::handleGarbage()
+{
+    TRACE_SCOPE("Simulation::handleGarbage");
+
+    for ( auto const& garbage : m_garbage )
+    {
+        if ( ! m_well.insertGarbageRows(garbage.rows, garbage.hole) )
+        {
+            m_over = true;
+            report(TelemetryEvent::Type::gameOver, m_score, m_clearedLines);
+            break;
+        }
+    }
+
+    m_garbage.clear();
+    m_pendingGarbage = 0;
+}
+
+void Simulation::handleNewPiece()
+{
+    ALLOC_TAG(effects);
+
+    m_falling = false; // disable the falling piece until the lock sequence is over
+
+    m_lockScript.reset(); // first, so that the new task reuses its frame
+    m_lockScript = lockPiece();
+    m_lockScript.start(m_scheduler);
+}
+
+Task Simulation::lockPiece(LockPhase a_phase, unsigned int a_ticks)
+{
+    if ( a_phase == LockPhase::settling )
+    {
+        m_lockPhase = LockPhase::settling;
+        co_await frames(a_ticks);
+
+        // Scanned into frame memory; the rows are only kept (in m_clearingRows, which has room
+        // for a whole well) if there are any.
+        auto rows = m_well.getFullRows(ArenaAllocator<unsigned int>(frameArena()));
+
+        if ( rows.size() == 0 )
+        {
+            m_lockPhase = LockPhase::none;
+            handleGenNewPiece();
+            co_return;
+        }
+
+        m_clearingRows.assign(rows.begin(), rows.end());
+        a_ticks = clearDelay;
+    }
+
+    m_lockPhase = LockPhase::clearing;
+    co_await frames(a_ticks);
+
+    m_lockPhase = LockPhase::none;
+    handleGenNewPiece();
+    handleRows(m_clearingRows);
+    m_clearingRows.clear();
+}
+
+void Simulation::handleGenNewPiece()
+{
+    if ( ! m_well.newPiece() )
+    {
+        m_over = true;
+        report(TelemetryEvent::Type::gameOver, m_score, m_clearedLines);
+    }
+    else
+    {
+        m_time = 1;
+        report(TelemetryEvent::Type::pieceSpawned, m_well.getPieceID(), m_well.getNextPieceID());
+    }
+
+    m_falling = true;
+}
+
+void Simulation::handleRows(std::vector<unsigned int> const& a_rows)
+{
+    TRACE_SCOPE("Simulation::handleRows");
+
+    m_score += baseRowScore * a_rows.size() * std::pow(2, a_rows.size() - 1); // TODO bells!!!
+    m_clearedLines += a_rows.size();
+    m_well.removeRows(a_rows);
+    report(TelemetryEvent::Type::rowsCleared, a_rows.size(), m_score);
+    handleSpeed();
+}
+
+void Simulation::handleSpeed()
+{
+    // +1 to account for the fact that with less than speedStep lines cleared, the division yields zero.
+    // Capped at speedLimit, past which blocks would fall more than once a tick.
+    unsigned int ts = std::min(m_clearedLines / speedStep + 1, speedLimit);
+    if ( m_speed < ts )
+    {
+        m_speed = ts;
+        report(TelemetryEvent::Type::levelUp, m_speed);
+    }
+}
+
+void Simulation::report(TelemetryEvent::Type a_type, std::uint32_t a_a, std::uint32_t a_b)
+{
+    if ( m_telemetry != nullptr )
+        m_telemetry->record(a_type, m_ticks, a_a, a_b);
+}
+
+// // // OBSERVERS // // //
+
+Simulation::Snapshot Simulation::snapshot() const
+{
+    Snapshot s;
+
+    for ( unsigned int y = 0; y < wellHeight; y++ )
+        s.rows[y] = m_well.getStorage().getRow(y);
+
+    StandardWell::PieceState piece = m_well.getPieceState();
+
+    s.blockCount = piece.piece.size();
+    s.pivots = 0;
+    for ( unsigned int i = 0; i < StandardWell::maxPieceBlocks; i++ )
+    {
+        bool used = i < piece.piece.size();
+
+        s.blocks[i][0] = used ? piece.piece[i].location.first : 0;
+        s.blocks[i][1] = used ? piece.piece[i].location.second : 0;
+        if ( used && piece.piece[i].type == BlockState::pivot )
+            s.pivots |= 1 << i;
+    }
+
+    s.pieceID = piece.pieceID;
+    s.nextPieceID = piece.nextPieceID;
+    s.rotationID = piece.rotationID;
+    s.randomState = piece.randomState;
+
+    s.flags = (m_fallFaster ? Snapshot::fallFaster : 0) | (m_falling ? Snapshot::falling : 0) | (m_over ? Snapshot::over : 0);
+    s.lockPhase = (std::uint8_t)m_lockPhase;
+    s.lockTicks = m_lockPhase == LockPhase::none ? 0 : m_lockScript.getPendingTicks();
+
+    s.clearingRows = 0;
+    for ( auto y : m_clearingRows )
+        s.clearingRows |= std::uint32_t(1) << y;
+
+    s.time = m_time;
+    s.score = m_score;
+    s.clearedLines = m_clearedLines;
+    s.speed = m_speed;
+    s.ticks = m_ticks;
+    s.checksum = m_checksum;
+
+    return s;
+}
+
+StandardWell & Simulation::getWell()
+{
+    return m_well;
+}
+
+StandardWell const& Simulation::getWell() const
+{
+    return m_well;
+}
+
+std::vector<unsigned int> const& Simulation::getClearingRows() const
+{
+    return m_clearingRows;
+}
+
+bool Simulation::isFalling() const
+{
+    return m_falling;
+}
+
+bool Simulation::isOver() const
+{
+    return m_over;
+}
+
+unsigned int Simulation::getPendingGarbage() const
+{
+    return m_pendingGarbage;
+}
+
+std::uint32_t Simulation::getSeed() const
+{
+    return m_seed;
+}
+
+unsigned int Simulation::getInitialSpeed() const
+{
+    return m_initialSpeed;
+}
+
+std::uint64_t Simulation::getTicks() const
+{
+    return m_ticks;
+}
+
+std::uint32_t Simulation::getChecksum() const
+{
+    return m_checksum;
+}
+
+unsigned int Simulation::getScore() const
+{
+    return m_score;
+}
+
+unsigned int Simulation::getLevel() const
+{
+    return m_speed;
+}
+
+unsigned int Simulation::getClearedLines() const
+{
+    return m_clearedLines;
+}
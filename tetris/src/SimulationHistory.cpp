@@ -0,0 +1,90 @@
+#include "SimulationHistory.h"
+
+#include <cassert>
+
+SimulationHistory::SimulationHistory(std::size_t a_capacity)
+    : m_snapshots(a_capacity), m_oldest(0), m_size(0)
+{
+    assert(a_capacity > 0);
+}
+
+// // // MUTATORS // // //
+
+void SimulationHistory::reset(Simulation const& a_simulation)
+{
+    m_oldest = 0;
+    m_size = 1;
+
+    m_snapshots[0] = a_simulation.snapshot();
+}
+
+void SimulationHistory::afterTick(Simulation const& a_simulation)
+{
+    std::uint64_t tick = a_simulation.getTicks();
+
+    if ( ! isEmpty() && tick == getNewestTick() ) // the simulation is over, and did not tick
+        return;
+
+    if ( isEmpty() || tick != getNewestTick() + 1 )
+    {
+        reset(a_simulation);
+        return;
+    }
+
+    // The oldest snapshot makes room once the ring is full.
+    if ( m_size == m_snapshots.size() )
+        m_oldest = (m_oldest + 1) % m_snapshots.size();
+    else
+        m_size++;
+
+    at(tick) = a_simulation.snapshot();
+}
+
+bool SimulationHistory::rewind(Simulation & a_simulation, std::uint64_t a_tick)
+{
+    if ( ! contains(a_tick) )
+        return false;
+
+    m_size = a_tick - getOldestTick() + 1;
+
+    a_simulation.restore(at(a_tick));
+
+    return true;
+}
+
+// // // OBSERVERS // // //
+
+bool SimulationHistory::isEmpty() const
+{
+    return m_size == 0;
+}
+
+std::uint64_t SimulationHistory::getOldestTick() const
+{
+    return m_snapshots[m_oldest].ticks;
+}
+
+std::uint64_t SimulationHistory::getNewestTick() const
+{
+    return getOldestTick() + m_size - 1;
+}
+
+Simulation::Snapshot const* SimulationHistory::find(std::uint64_t a_tick) const
+{
+    return contains(a_tick) ? &at(a_tick) : nullptr;
+}
+
+Simulation::Snapshot & SimulationHistory::at(std::uint64_t a_tick)
+{
+    return m_snapshots[(m_oldest + (a_tick - getOldestTick())) % m_snapshots.size()];
+}
+
+Simulation::Snapshot const& SimulationHistory::at(std::uint64_t a_tick) const
+{
+    return m_snapshots[(m_oldest + (a_tick - getOldestTick())) % m_snapshots.size()];
+}
+
+bool SimulationHistory::contains(std::uint64_t a_tick) const
+{
+    return ! isEmpty() && a_tick >= getOldestTick() && a_tick <= getNewestTick();
+}
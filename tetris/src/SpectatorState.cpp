@@ -0,0 +1,126 @@
+#include "SpectatorState.h"
+#include "Application.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+SpectatorState::SpectatorState(const Application* a_owner, unsigned int a_boards)
+    : State(a_owner), m_boards(std::clamp(a_boards / 2 * 2, 2u, maxBoards)), m_nextSeed(0), m_matchesPlayed(0),
+      m_gridPosition { 0, 0, 0, 0 }, m_shownMatches(0)
+{
+}
+
+void SpectatorState::load()
+{
+    const unsigned int width = Application::screenWidth, height = Application::screenHeight;
+
+    m_statusAtlas = getOwner()->getResources().getAtlas(getOwner()->getResources().getFont("resources/statusfont.ttf", 16),
+            SDL_Color { 255, 255, 255 }, SDL_Color { 0, 0, 0 }, "Matches played: 0123456789");
+    unsigned int textHeight = m_statusAtlas->getHeight();
+
+    m_grid.load(m_boards, width - 2 * boardSpacing, height - 3 * boardSpacing - textHeight, maxBlockSide, boardSpacing,
+                getOwner()->getScreen().lock()->format);
+
+    // Centered below the status line.
+    m_gridPosition = SDL_Rect { (short)(((int)width - (int)m_grid.getWidth()) / 2),
+                                (short)(2 * boardSpacing + textHeight), 0, 0 };
+
+    std::snprintf(m_statusText, sizeof(m_statusText), "Matches played: 0");
+
+    // The same opponents for every match, the same on every run.
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> scale(0.5, 1.5);
+
+    m_bots.clear();
+    for ( unsigned int i = 0; i < m_boards / 2; i++ )
+    {
+        Bot::Weights challenger = Bot::defaultWeights;
+        challenger.height *= scale(random);
+        challenger.lines *= scale(random);
+        challenger.holes *= scale(random);
+        challenger.bumpiness *= scale(random);
+
+        m_bots.emplace_back(Bot::defaultWeights, botMoveTicks);
+        m_bots.emplace_back(challenger, botMoveTicks);
+    }
+
+    m_finishedTicks.assign(m_boards / 2, 0);
+
+    State::load();
+}
+
+void SpectatorState::activate()
+{
+    m_nextSeed = std::random_device()();
+
+    m_matches.clear();
+    for ( unsigned int i = 0; i < m_boards / 2; i++ )
+    {
+        m_matches.emplace_back(new Match(2, m_nextSeed++, 1));
+
+        for ( unsigned int b = 0; b < 2; b++ )
+            m_matches.back()->getBoard(b).warmUp();
+    }
+
+    State::activate();
+
+    m_statusAtlas->optimize();
+}
+
+void SpectatorState::update()
+{
+    for ( unsigned int i = 0; i < m_matches.size(); i++ )
+    {
+        Match & match = *m_matches[i];
+
+        if ( ! match.isOver() )
+        {
+            for ( unsigned int b = 0; b < 2; b++ )
+                m_bots[2 * i + b].play(match.getBoard(b));
+
+            match.tick();
+
+            if ( match.isOver() )
+                m_matchesPlayed++;
+
+            continue;
+        }
+
+        if ( ++m_finishedTicks[i] < restartTicks )
+            continue;
+
+        // On the same boards and bots, so that starting again allocates nothing.
+        m_finishedTicks[i] = 0;
+        match.restart(m_nextSeed++);
+        for ( unsigned int b = 0; b < 2; b++ )
+        {
+            match.getBoard(b).warmUp();
+            m_bots[2 * i + b].reset();
+        }
+    }
+
+    if ( m_matchesPlayed != m_shownMatches )
+        std::snprintf(m_statusText, sizeof(m_statusText), "Matches played: %u", m_shownMatches = m_matchesPlayed);
+
+    State::update();
+}
+
+void SpectatorState::handleEvent(SDL_Event const& event, Uint32 a_time)
+{
+    if ( event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE )
+    {
+        setState(AppState::finished);
+        m_next = std::make_shared<MenuState>(getOwner());
+    }
+}
+
+void SpectatorState::draw(Surface_ptr const& a_parent)
+{
+    for ( unsigned int i = 0; i < m_matches.size(); i++ )
+        for ( unsigned int b = 0; b < 2; b++ )
+            m_grid.update(2 * i + b, m_matches[i]->getBoard(b));
+
+    m_grid.draw(a_parent.get(), m_gridPosition.x, m_gridPosition.y);
+    m_statusAtlas->draw(m_statusText, a_parent.get(), m_gridPosition.x, boardSpacing);
+}
@@ -0,0 +1,41 @@
+#include "StartupProfile.h"
+
+#include <cstdio>
+
+StartupProfile::StartupProfile()
+    : m_enabled(false), m_start(Instrumentation::now())
+{
+    m_marks.reserve(16);
+}
+
+void StartupProfile::setEnabled(bool a_enabled)
+{
+    m_enabled = a_enabled;
+}
+
+bool StartupProfile::isEnabled() const
+{
+    return m_enabled;
+}
+
+void StartupProfile::mark(const char *a_phase)
+{
+    if ( m_enabled )
+        m_marks.push_back(Mark { a_phase, Instrumentation::now() });
+}
+
+void StartupProfile::report() const
+{
+    if ( ! m_enabled )
+        return;
+
+    std::fprintf(stderr, "startup profile              phase ms    total ms\n");
+
+    Instrumentation::Micros previous = m_start;
+    for ( auto &mark : m_marks )
+    {
+        std::fprintf(stderr, "  %-24s %10.2f  %10.2f\n", mark.phase,
+                     (mark.at - previous) / 1000.0, (mark.at - m_start) / 1000.0);
+        previous = mark.at;
+    }
+}
@@ -8,12 +8,19 @@ State::State (const State *a_parent)
 
 void State::update()
 {
+    TRACE_SCOPE("State::update");
+
     if ( m_child != nullptr )
     {
         if ( m_child->m_status == AppState::running )
             m_child->update ();
         else if ( m_child->m_status == AppState::finished )
         {
+            // A successor that is still being loaded in the background is swapped in on a later
+            // frame, once it is ready, rather than waited for.
+            if ( m_child->m_next != nullptr && m_child->m_next->m_status == AppState::loading )
+                return;
+
             m_child->cleanup ();
             m_child = m_child->m_next;
 
@@ -24,7 +31,7 @@ void State::update()
 
 }
 
-void State::draw (Surface_ptr a_parent)
+void State::draw (Surface_ptr const& a_parent)
 {
     if ( m_child != nullptr && m_child->m_status == AppState::running )
         m_child->draw (a_parent);
@@ -32,13 +39,14 @@ void State::draw (Surface_ptr a_parent)
 
 void State::load ()
 {
-    m_status = AppState::ready;
-
     if ( m_child != nullptr )
     {
         if ( m_child->m_status == AppState::notReady )
             m_child->load();
     }
+
+    // Last, so that a state loaded on another thread only looks ready once it completely is.
+    m_status = AppState::ready;
 }
 
 void State::cleanup ()
@@ -64,10 +72,10 @@ void State::activate ()
         throw std::exception ();
 }
 
-void State::handleEvent (SDL_Event const& event)
+void State::handleEvent (SDL_Event const& event, Uint32 a_time)
 {
     if ( m_child != nullptr )
-        m_child->handleEvent(event);
+        m_child->handleEvent(event, a_time);
 }
 
 void State::setState (AppState a_state)
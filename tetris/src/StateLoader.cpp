@@ -0,0 +1,74 @@
+#include "StateLoader.h"
+#include "Log.h"
+
+StateLoader::StateLoader()
+    : m_stopping(false), m_thread(&StateLoader::work, this)
+{
+}
+
+StateLoader::~StateLoader()
+{
+    stop();
+}
+
+void StateLoader::prewarm(State_ptr a_state)
+{
+    if ( a_state == nullptr || a_state->m_status != AppState::notReady )
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if ( m_stopping )
+        return;
+
+    a_state->m_status = AppState::loading;
+    m_queue.push_back(a_state);
+    m_wake.notify_one();
+}
+
+void StateLoader::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_stopping = true;
+
+        for ( auto &state : m_queue )
+            state->m_status = AppState::notReady;
+        m_queue.clear();
+
+        m_wake.notify_one();
+    }
+
+    if ( m_thread.joinable() )
+        m_thread.join();
+}
+
+void StateLoader::work()
+{
+    for ( ; ; )
+    {
+        State_ptr state;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] () { return m_stopping || ! m_queue.empty(); });
+
+            if ( m_stopping )
+                return;
+
+            state = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        try
+        {
+            state->load(); // ends with State::load, which sets the status to ready
+        }
+        catch ( std::exception const& e )
+        {
+            LOG_ERROR("Failed to prewarm a state: %s", e.what());
+            state->m_status = AppState::notReady; // activating it will try again synchronously
+        }
+    }
+}
@@ -0,0 +1,140 @@
+#include "Telemetry.h"
+
+#include <chrono>
+
+static const char magic[4] = { 'T', 'T', 'E', 'L' };
+
+// How long the writer sleeps when there is nothing to write, and how long it keeps a batch that
+// is not full before writing it anyway.
+static const std::chrono::milliseconds idleSleep(5);
+static const std::chrono::milliseconds flushInterval(250);
+
+static void putVarint(std::vector<unsigned char> & a_out, std::uint64_t a_value)
+{
+    while ( a_value >= 0x80 )
+    {
+        a_out.push_back((a_value & 0x7f) | 0x80);
+        a_value >>= 7;
+    }
+    a_out.push_back(a_value);
+}
+
+static void putFixed32(std::vector<unsigned char> & a_out, std::size_t a_offset, std::uint32_t a_value)
+{
+    for ( unsigned int i = 0; i < 4; i++ )
+        a_out[a_offset + i] = a_value >> (8 * i);
+}
+
+Telemetry::Telemetry(std::string const& a_path)
+    : m_file(std::fopen(a_path.c_str(), "wb")), m_dropped(0), m_stopping(false)
+{
+    if ( m_file == nullptr )
+        return;
+
+    std::fwrite(magic, 1, sizeof(magic), m_file);
+    std::fputc(version, m_file);
+
+    m_thread = std::thread(&Telemetry::run, this);
+}
+
+Telemetry::~Telemetry()
+{
+    m_stopping.store(true, std::memory_order_release);
+
+    if ( m_thread.joinable() )
+        m_thread.join();
+
+    if ( m_file != nullptr )
+        std::fclose(m_file);
+}
+
+bool Telemetry::isOpen() const
+{
+    return m_file != nullptr;
+}
+
+// // // RECORDING // // //
+
+void Telemetry::record(TelemetryEvent::Type a_type, std::uint64_t a_tick, std::uint32_t a_a, std::uint32_t a_b)
+{
+    if ( m_file == nullptr )
+        return;
+
+    if ( ! m_ring.push(TelemetryEvent { a_type, a_tick, a_a, a_b }) )
+        m_dropped++;
+}
+
+std::uint64_t Telemetry::getDropped() const
+{
+    return m_dropped;
+}
+
+// // // WRITER // // //
+
+void Telemetry::run()
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::vector<TelemetryEvent> batch;
+    batch.reserve(batchSize);
+
+    Clock::time_point lastWrite = Clock::now();
+
+    for ( ;; )
+    {
+        // Read before draining, so that everything recorded before the flag was set is written.
+        bool stopping = m_stopping.load(std::memory_order_acquire);
+
+        TelemetryEvent event;
+        bool took = false;
+
+        while ( batch.size() < batchSize && m_ring.pop(event) )
+        {
+            batch.push_back(event);
+            took = true;
+        }
+
+        if ( ! batch.empty() && (batch.size() == batchSize || stopping || Clock::now() - lastWrite >= flushInterval) )
+        {
+            writeBlock(batch);
+            batch.clear();
+            lastWrite = Clock::now();
+            continue;
+        }
+
+        if ( stopping )
+            break;
+
+        if ( ! took )
+            std::this_thread::sleep_for(idleSleep);
+    }
+
+    std::fflush(m_file);
+}
+
+void Telemetry::writeBlock(std::vector<TelemetryEvent> const& a_events)
+{
+    m_block.assign(8, 0); // count and size, filled in below
+
+    for ( TelemetryEvent const& event : a_events )
+        m_block.push_back((std::uint8_t)event.type);
+
+    std::uint64_t tick = 0;
+    for ( TelemetryEvent const& event : a_events )
+    {
+        // Zigzagged, since a new game starts again from tick 0.
+        std::int64_t delta = event.tick - tick;
+        putVarint(m_block, (std::uint64_t(delta) << 1) ^ std::uint64_t(delta >> 63));
+        tick = event.tick;
+    }
+
+    for ( TelemetryEvent const& event : a_events )
+        putVarint(m_block, event.a);
+    for ( TelemetryEvent const& event : a_events )
+        putVarint(m_block, event.b);
+
+    putFixed32(m_block, 0, a_events.size());
+    putFixed32(m_block, 4, m_block.size() - 8);
+
+    std::fwrite(m_block.data(), 1, m_block.size(), m_file);
+}
@@ -1,4 +1,4 @@
-#include "Game.h"
+#include "Well.h"
 
 const char PIECES[7][4][5][5] = // one dimension for the kind of piece, then for its rotation, then the x data, then the y data.
     {
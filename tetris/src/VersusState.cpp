@@ -0,0 +1,207 @@
+#include "VersusState.h"
+#include "Application.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+VersusState::VersusState(const Application* a_owner, unsigned int a_boards, unsigned int a_initialSpeed)
+    : State(a_owner), m_boards(std::clamp(a_boards, 2u, Match::maxBoards)), m_initialSpeed(a_initialSpeed),
+      m_autoShift(Game::defaultAutoShiftDelay, Game::defaultAutoRepeatRate)
+{
+}
+
+void VersusState::load()
+{
+    // The largest blocks at which the boards fit on the screen, over every number of columns.
+    const unsigned int width = Application::screenWidth, height = Application::screenHeight;
+    const unsigned int wellWidth = StandardWell::StorageType::width, wellHeight = StandardWell::StorageType::height;
+
+    m_scoreAtlas = getOwner()->getResources().getAtlas(getOwner()->getResources().getFont("resources/statusfont.ttf", 16),
+            SDL_Color { 255, 255, 255 }, SDL_Color { 0, 0, 0 }, "0123456789");
+    unsigned int textHeight = m_scoreAtlas->getHeight();
+
+    unsigned int blockSide = 0, columns = 1;
+    for ( unsigned int c = 1; c <= m_boards; c++ )
+    {
+        unsigned int rows = (m_boards + c - 1) / c;
+
+        // Each board has half a block to its left for its garbage bar, and its score above it.
+        int across = ((int)width - (int)((c + 1) * boardSpacing)) * 2 / (int)(c * (2 * wellWidth + 1));
+        int down = ((int)height - (int)((rows + 1) * boardSpacing + rows * textHeight)) / (int)(rows * wellHeight);
+        unsigned int side = std::max(0, std::min(across, down));
+
+        if ( side > blockSide )
+        {
+            blockSide = side;
+            columns = c;
+        }
+    }
+
+    blockSide = std::clamp(blockSide, 2u, maxBlockSide);
+    m_renderer.load(blockSide, getOwner()->getScreen().lock()->format);
+
+    // Centered, row by row.
+    unsigned int rows = (m_boards + columns - 1) / columns;
+    unsigned int cellWidth = m_renderer.getWidth() + blockSide / 2 + boardSpacing;
+    unsigned int cellHeight = m_renderer.getHeight() + textHeight + boardSpacing;
+    short left = ((int)width - (int)(columns * cellWidth - boardSpacing)) / 2 + blockSide / 2;
+    short top = ((int)height - (int)(rows * cellHeight - boardSpacing)) / 2 + textHeight;
+
+    m_boardPositions.clear();
+    for ( unsigned int i = 0; i < m_boards; i++ )
+        m_boardPositions.push_back(SDL_Rect { (short)(left + (i % columns) * cellWidth),
+                                              (short)(top + (i / columns) * cellHeight), 0, 0 });
+
+    m_shownScores.assign(m_boards, 0);
+    for ( unsigned int i = 0; i < m_boards; i++ )
+        std::snprintf(m_scoreText[i], sizeof(m_scoreText[i]), "0");
+
+    m_bots.assign(m_boards - 1, Bot(Bot::defaultWeights, botMoveTicks));
+
+    State::load();
+}
+
+void VersusState::activate()
+{
+    m_match.reset(new Match(m_boards, std::random_device()(), m_initialSpeed));
+
+    for ( unsigned int i = 0; i < m_match->getBoardCount(); i++ )
+        m_match->getBoard(i).warmUp();
+
+    State::activate();
+
+    m_scoreAtlas->optimize();
+
+    m_nextGameOver = std::make_shared<GameOverState>(getOwner());
+    getOwner()->getLoader().prewarm(m_nextGameOver);
+}
+
+void VersusState::setInitialSpeed(unsigned int a_speed)
+{
+    m_initialSpeed = a_speed;
+}
+
+void VersusState::update()
+{
+    handleAutoShift(SDL_GetTicks());
+
+    for ( unsigned int i = 0; i < m_bots.size(); i++ )
+        m_bots[i].play(m_match->getBoard(i + 1));
+
+    m_match->tick();
+
+    for ( unsigned int i = 0; i < m_boards; i++ )
+    {
+        unsigned int score = m_match->getBoard(i).getScore();
+        if ( score != m_shownScores[i] )
+            std::snprintf(m_scoreText[i], sizeof(m_scoreText[i]), "%u", m_shownScores[i] = score);
+    }
+
+    if ( m_match->getBoard(0).isOver() || m_match->isOver() )
+        handleGameOver();
+
+    State::update();
+}
+
+void VersusState::handleGameOver()
+{
+    if ( getStatus() == AppState::finished )
+        return;
+
+    Simulation const& player = m_match->getBoard(0);
+
+    setState(AppState::finished);
+    if ( m_nextGameOver == nullptr )
+        m_nextGameOver = std::make_shared<GameOverState>(getOwner());
+    // Scores against opponents that send garbage are not comparable with the others.
+    m_nextGameOver->setResults(player.getScore(), player.getLevel(), player.getClearedLines(), false);
+    m_next = m_nextGameOver;
+}
+
+void VersusState::handleAutoShift(Uint32 a_time)
+{
+    unsigned int shifts = m_autoShift.poll(a_time);
+
+    if ( ! m_match->getBoard(0).isFalling() )
+        return;
+
+    Simulation::Action move = m_autoShift.getDirection() < 0 ? Simulation::Action::moveLeft : Simulation::Action::moveRight;
+
+    for ( unsigned int i = 0; i < shifts; i++ )
+        if ( ! m_match->apply(0, move) )
+            break;
+}
+
+void VersusState::handleEvent(SDL_Event const& event, Uint32 a_time)
+{
+    bool applied = false; // only input that changed the game counts towards its latency
+
+    switch ( event.type )
+    {
+        case SDL_KEYDOWN:
+            handleAutoShift(a_time);
+
+            switch ( event.key.keysym.sym )
+            {
+                case SDLK_DOWN:
+                    applied = m_match->apply(0, Simulation::Action::softDropOn);
+                    break;
+                case SDLK_LEFT:
+                    m_autoShift.press(-1, a_time);
+                    applied = m_match->apply(0, Simulation::Action::moveLeft);
+                    break;
+                case SDLK_RIGHT:
+                    m_autoShift.press(1, a_time);
+                    applied = m_match->apply(0, Simulation::Action::moveRight);
+                    break;
+                case SDLK_z:
+                    applied = m_match->apply(0, Simulation::Action::rotateCCW);
+                    break;
+                case SDLK_x:
+                    applied = m_match->apply(0, Simulation::Action::rotateCW);
+                    break;
+                case SDLK_SPACE:
+                    applied = m_match->apply(0, Simulation::Action::drop);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case SDL_KEYUP:
+            handleAutoShift(a_time);
+
+            switch ( event.key.keysym.sym )
+            {
+                case SDLK_DOWN:
+                    applied = m_match->apply(0, Simulation::Action::softDropOff);
+                    break;
+                case SDLK_LEFT:
+                    m_autoShift.release(-1, a_time);
+                    break;
+                case SDLK_RIGHT:
+                    m_autoShift.release(1, a_time);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            return;
+    }
+
+    if ( applied )
+        getOwner()->getInstrumentation().eventApplied();
+}
+
+void VersusState::draw(Surface_ptr const& a_parent)
+{
+    for ( unsigned int i = 0; i < m_boards; i++ )
+    {
+        SDL_Rect const& position = m_boardPositions[i];
+
+        m_renderer.draw(m_match->getBoard(i), a_parent.get(), position.x, position.y, i == 0);
+        m_scoreAtlas->draw(m_scoreText[i], a_parent.get(), position.x, position.y - m_scoreAtlas->getHeight());
+    }
+}
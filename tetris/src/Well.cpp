@@ -1,52 +1,312 @@
 #include "Well.h"
+#include "Trace.h"
+#include "AllocAccounting.h"
 
-Well::Well(unsigned int a_width, unsigned int a_height)
-    : m_rdistribution(0, 6)
+// // // STORAGE // // //
+
+DynamicRows::DynamicRows(unsigned int a_width, unsigned int a_height)
+    : m_cells(a_width, std::vector<bool>(a_height, false)), m_width(a_width), m_height(a_height)
+{
+}
+
+DynamicRows::DynamicRows(WellMatrix a_initialWell)
+    : m_cells(std::move(a_initialWell))
 {
-    m_well = std::vector<std::vector<bool>>(a_width);
+    m_width = m_cells.size();
+    m_height = m_width > 0 ? m_cells[0].size() : 0;
+
+    unsigned int height = m_height;
+
+    if ( std::any_of(m_cells.begin(), m_cells.end(), [height] (std::vector<bool> const& b) { return b.size() != height;  } ) )
+        throw new std::exception (); // The heights are not uniform in the initial well.
+}
 
-    for ( WellMatrix::iterator i = m_well.begin(); i != m_well.end(); i++ )
+bool DynamicRows::isRowFull(unsigned int y) const
+{
+    for ( unsigned int x = 0; x < m_width; x++ )
     {
-        (*i) = std::vector<bool>(a_height);
-        for ( std::vector<bool>::iterator j = i->begin(); j != i->end(); j++ )
+        if ( ! m_cells[x][y] )
+            return false;
+    }
+
+    return true;
+}
+
+bool DynamicRows::isRowEmpty(unsigned int y) const
+{
+    for ( unsigned int x = 0; x < m_width; x++ )
+    {
+        if ( m_cells[x][y] )
+            return false;
+    }
+
+    return true;
+}
+
+void DynamicRows::removeRows(std::vector<unsigned int> const& a_rows)
+{
+    for ( auto y : a_rows )
+    {
+        for ( unsigned int x = 0; x < m_width; x++ )
         {
-            *j = false;
+            for ( unsigned int y_ = y; y_ > 0; y_-- )
+                m_cells[x][y_] = m_cells[x][y_ - 1]; // shift down rows above the removed row
+
+            m_cells[x][0] = false; // clear the top row.
         }
     }
+}
 
-    std::random_device seeder;
+bool DynamicRows::insertRows(unsigned int a_count, unsigned int a_hole)
+{
+    a_count = std::min(a_count, m_height);
 
-    m_rengine.seed(seeder());
+    bool kept = true;
 
-    m_wellWidth = a_width;
-    m_wellHeight = a_height;
+    for ( unsigned int x = 0; x < m_width; x++ )
+    {
+        auto &column = m_cells[x];
 
-    m_nextPieceID = m_rdistribution(m_rengine);
+        kept = kept && std::find(column.begin(), column.begin() + a_count, true) == column.begin() + a_count;
 
-    m_fallenPieceMemoID = 0;
+        std::copy(column.begin() + a_count, column.end(), column.begin());
+        std::fill(column.end() - a_count, column.end(), x != a_hole);
+    }
 
-    m_rotationID = 0;
+    return kept;
 }
 
-Well::Well(WellMatrix a_initialMatrix)
+void DynamicRows::clear()
 {
-    m_well = a_initialMatrix;
+    for ( auto &column : m_cells )
+        std::fill(column.begin(), column.end(), false);
+}
 
-    unsigned int height = m_well[0].size();
+ChunkedRows::ChunkedRows(unsigned int a_width, unsigned int a_height)
+    : m_width(a_width), m_height(a_height), m_words((a_width + 63) / 64)
+{
+}
 
-    if ( std::any_of(m_well.begin(), m_well.end(), [height] (std::vector<bool> const& b) { return b.size() != height;  } ) )
-        throw new std::exception (); // The heights are not uniform in the initial well.
+ChunkedRows::Chunk const* ChunkedRows::find(unsigned int y) const
+{
+    auto c = m_chunks.find(y / chunkRows);
+    return c == m_chunks.end() ? nullptr : &c->second;
+}
+
+bool ChunkedRows::get(unsigned int x, unsigned int y) const
+{
+    Chunk const* c = find(y);
+
+    if ( c == nullptr )
+        return false;
+
+    return (c->bits[(y % chunkRows) * m_words + x / 64] >> (x % 64)) & 1;
+}
+
+void ChunkedRows::set(unsigned int x, unsigned int y, bool b)
+{
+    auto i = m_chunks.find(y / chunkRows);
+
+    if ( i == m_chunks.end() )
+    {
+        if ( ! b )
+            return;
+
+        i = addChunk(y / chunkRows);
+    }
+
+    Chunk &c = i->second;
+    unsigned int row = y % chunkRows;
+    std::uint64_t &word = c.bits[row * m_words + x / 64];
+    std::uint64_t bit = std::uint64_t(1) << (x % 64);
+
+    if ( bool(word & bit) == b )
+        return;
+
+    word ^= bit;
+    c.counts[row] += b ? 1 : -1;
+
+    std::uint64_t rowBit = std::uint64_t(1) << row;
+    c.occupied = c.counts[row] > 0 ? c.occupied | rowBit : c.occupied & ~rowBit;
+    c.full = c.counts[row] == m_width ? c.full | rowBit : c.full & ~rowBit;
+
+    if ( c.occupied == 0 )
+        m_chunks.erase(i);
+}
+
+bool ChunkedRows::isRowFull(unsigned int y) const
+{
+    Chunk const* c = find(y);
+    return c != nullptr && (c->full >> (y % chunkRows)) & 1;
+}
+
+unsigned int ChunkedRows::nextOccupiedRow(unsigned int y) const
+{
+    for ( auto c = m_chunks.lower_bound(y / chunkRows); c != m_chunks.end(); c++ )
+    {
+        std::uint64_t rows = c->second.occupied;
+        unsigned int base = c->first * chunkRows;
+
+        if ( y > base )
+            rows &= ~std::uint64_t(0) << (y - base);
+        if ( rows != 0 )
+            return base + std::countr_zero(rows);
+    }
+
+    return m_height;
+}
+
+void ChunkedRows::removeRows(std::vector<unsigned int> const& a_rows)
+{
+    if ( a_rows.empty() )
+        return;
+
+    // Only occupied rows above the last removed one move, each down by the number of removed
+    // rows below it. Going from the bottom up, a row's destination has always been vacated.
+    std::vector<unsigned int> occupied;
+    forEachOccupiedRow(0, a_rows.back() + 1, [&occupied] (unsigned int y) { occupied.push_back(y); });
+
+    std::size_t removedBelow = 0;
+    auto removed = a_rows.rbegin();
+
+    for ( auto y = occupied.rbegin(); y != occupied.rend(); y++ )
+    {
+        while ( removed != a_rows.rend() && *removed > *y )
+        {
+            removed++;
+            removedBelow++;
+        }
+
+        if ( removed != a_rows.rend() && *removed == *y )
+            clearRow(*y);
+        else if ( removedBelow > 0 )
+            moveRow(*y, *y + removedBelow);
+    }
+}
+
+bool ChunkedRows::insertRows(unsigned int a_count, unsigned int a_hole)
+{
+    a_count = std::min(a_count, m_height);
+    if ( a_count == 0 )
+        return true;
+
+    std::vector<unsigned int> occupied;
+    forEachOccupiedRow(0, m_height, [&occupied] (unsigned int y) { occupied.push_back(y); });
+
+    bool kept = occupied.empty() || occupied.front() >= a_count;
+
+    // Going from the top down, a row's destination has always been vacated.
+    for ( auto y : occupied )
+    {
+        if ( y < a_count )
+            clearRow(y);
+        else
+            moveRow(y, y - a_count);
+    }
+
+    for ( unsigned int y = m_height - a_count; y < m_height; y++ )
+        for ( unsigned int x = 0; x < m_width; x++ )
+            if ( x != a_hole )
+                set(x, y, true);
+
+    return kept;
+}
+
+void ChunkedRows::moveRow(unsigned int a_from, unsigned int a_to)
+{
+    auto to = m_chunks.find(a_to / chunkRows);
+
+    if ( to == m_chunks.end() )
+        to = addChunk(a_to / chunkRows);
+
+    // Map nodes stay put when others are added, so this is still valid.
+    Chunk const& from = m_chunks.find(a_from / chunkRows)->second;
+    unsigned int fromRow = a_from % chunkRows, toRow = a_to % chunkRows;
+
+    std::copy(from.bits.begin() + fromRow * m_words, from.bits.begin() + (fromRow + 1) * m_words,
+            to->second.bits.begin() + toRow * m_words);
+    to->second.counts[toRow] = from.counts[fromRow];
+    to->second.occupied |= std::uint64_t(1) << toRow;
+    if ( (from.full >> fromRow) & 1 )
+        to->second.full |= std::uint64_t(1) << toRow;
+
+    clearRow(a_from);
+}
+
+void ChunkedRows::clearRow(unsigned int y)
+{
+    auto i = m_chunks.find(y / chunkRows);
+
+    if ( i == m_chunks.end() )
+        return;
+
+    Chunk &c = i->second;
+    unsigned int row = y % chunkRows;
+    std::uint64_t rowBit = std::uint64_t(1) << row;
+
+    std::fill(c.bits.begin() + row * m_words, c.bits.begin() + (row + 1) * m_words, 0);
+    c.counts[row] = 0;
+    c.occupied &= ~rowBit;
+    c.full &= ~rowBit;
+
+    if ( c.occupied == 0 )
+        m_chunks.erase(i);
+}
+
+std::map<unsigned int, ChunkedRows::Chunk>::iterator ChunkedRows::addChunk(unsigned int a_index)
+{
+    auto i = m_chunks.emplace(a_index, Chunk()).first;
+
+    i->second.occupied = i->second.full = 0;
+    std::fill(i->second.counts, i->second.counts + chunkRows, 0);
+    i->second.bits.assign(chunkRows * m_words, 0);
+
+    return i;
+}
+
+void ChunkedRows::clear()
+{
+    m_chunks.clear();
+}
+
+// // // CONSTRUCTORS // // //
+
+template<typename Storage>
+void BasicWell<Storage>::init()
+{
+    ALLOC_TAG(well);
+
+    std::random_device seeder;
+
+    seed(seeder());
+    m_pieceID = m_nextPieceID;
+
+    m_fallenPieceMemoID = 0;
+
+    m_rotationID = 0;
 }
 
 // // // MUTATORS // // //
 
-bool Well::updatePiece(Piece & p) const
+template<typename Storage>
+void BasicWell<Storage>::seed(std::uint32_t a_seed)
+{
+    // As std::minstd_rand seeds itself.
+    m_randomState = a_seed % 2147483647;
+    if ( m_randomState == 0 )
+        m_randomState = 1;
+
+    m_nextPieceID = randomPiece();
+}
+
+template<typename Storage>
+bool BasicWell<Storage>::updatePiece(Piece & p) const
 {
     if ( std::any_of(p.begin(), p.end(), 
                 [this] (Block b) 
                 {
-                    return b.location.second + 1 >= m_wellHeight || 
-                        m_well[b.location.first][b.location.second + 1];
+                    return b.location.second + 1 >= m_storage.getHeight() || 
+                        m_storage.get(b.location.first, b.location.second + 1);
                 }) )
     {
         return true;
@@ -59,8 +319,11 @@ bool Well::updatePiece(Piece & p) const
     }
 }
 
-bool Well::updatePiece()
+template<typename Storage>
+bool BasicWell<Storage>::updatePiece()
 {
+    ALLOC_TAG(well);
+
     if ( updatePiece(m_piece) )
     {
         collidePiece();
@@ -69,19 +332,26 @@ bool Well::updatePiece()
         return false;
 }
 
-void Well::collidePiece(Piece const& p)
+template<typename Storage>
+void BasicWell<Storage>::collidePiece(Piece const& p)
 {
     for ( auto &q : p )
-        setBlock(q.location, true);
+        m_storage.set(q.location.first, q.location.second, true);
+
+    m_fallenPieceMemo.clear();
 }
 
-void Well::collidePiece()
+template<typename Storage>
+void BasicWell<Storage>::collidePiece()
 {
     collidePiece(m_piece);
 }
 
-bool Well::movePiece(int d)
+template<typename Storage>
+bool BasicWell<Storage>::movePiece(int d)
 {
+    ALLOC_TAG(well);
+
     Piece p = movePiece(m_piece, d);
 
     if ( p != m_piece )
@@ -92,7 +362,8 @@ bool Well::movePiece(int d)
         return false;
 }
 
-Well::Piece Well::movePiece(Piece const& piece, int d)
+template<typename Storage>
+typename BasicWell<Storage>::Piece BasicWell<Storage>::movePiece(Piece const& piece, int d)
 {
     Piece newPiece = piece;
     unsigned int nx = 0;
@@ -100,7 +371,7 @@ Well::Piece Well::movePiece(Piece const& piece, int d)
     for ( auto &block : newPiece )
     {
         nx = block.location.first + d;
-        if ( nx < m_wellWidth )
+        if ( nx < m_storage.getWidth() )
             block.location.first = nx;
         else
             return piece;
@@ -112,19 +383,47 @@ Well::Piece Well::movePiece(Piece const& piece, int d)
         return newPiece;
 }
 
-void Well::fall()
+template<typename Storage>
+void BasicWell<Storage>::fall()
 {
-    while ( ! updatePiece() );
+    ALLOC_TAG(well);
+
+    fall(m_piece);
+    collidePiece();
 }
 
-void Well::fall(Piece & p) const
+template<typename Storage>
+void BasicWell<Storage>::fall(Piece & p) const
 {
+    // Rows below the piece down to the next fallen block are empty, so it can skip them at once;
+    // in a tall well, most of the drop. The rows the piece spans must be empty too, since a block
+    // of the piece may hang over a fallen block in them.
+    if ( p.empty() )
+        return;
+
+    unsigned int top = p[0].location.second, bottom = top;
+
+    for ( auto &q : p )
+    {
+        top = std::min(top, q.location.second);
+        bottom = std::max(bottom, q.location.second);
+    }
+
+    unsigned int next = m_storage.nextOccupiedRow(top);
+
+    if ( next > bottom + 1 )
+        for ( auto &q : p )
+            q.location.second += next - bottom - 1;
+
     while ( ! updatePiece(p) );
 }
 
-bool Well::newPiece()
+template<typename Storage>
+bool BasicWell<Storage>::newPiece()
 {
-    Piece newPiece = spawnPiece({ m_wellWidth / 2, 0 }, m_nextPieceID, 0);
+    ALLOC_TAG(well);
+
+    Piece newPiece = spawnPiece({ m_storage.getWidth() / 2, 0 }, m_nextPieceID, 0);
     if ( newPiece.size() == 0 )
         return false;
     else
@@ -132,12 +431,13 @@ bool Well::newPiece()
         m_piece = newPiece;
         m_pieceID = m_nextPieceID;
         m_rotationID = 0;
-        m_nextPieceID = m_rdistribution(m_rengine);
+        m_nextPieceID = randomPiece();
         return true;
     }
 }
 
-Well::Piece Well::spawnPiece(Point p, unsigned int pieceID, int rotationID) const
+template<typename Storage>
+typename BasicWell<Storage>::Piece BasicWell<Storage>::spawnPiece(Point p, unsigned int pieceID, int rotationID) const
 {
     Piece newPiece;
 
@@ -150,7 +450,7 @@ Well::Piece Well::spawnPiece(Point p, unsigned int pieceID, int rotationID) cons
 
             unsigned int px = p.first - 2 + i, py = p.second - 2 + j;
 
-            if ( px < m_wellWidth && py < m_wellHeight && ! m_well[px][py] )
+            if ( px < m_storage.getWidth() && py < m_storage.getHeight() && ! m_storage.get(px, py) )
             {
                 Block b { {px, py}, PIECES[pieceID][rotationID][j][i] == 1 ? BlockState::falling : BlockState::pivot };
                 newPiece.push_back(b);
@@ -165,7 +465,8 @@ Well::Piece Well::spawnPiece(Point p, unsigned int pieceID, int rotationID) cons
     return newPiece;
 }
 
-Well::Piece Well::rotatePiece(Piece const& piece, Direction d)
+template<typename Storage>
+typename BasicWell<Storage>::Piece BasicWell<Storage>::rotatePiece(Piece const& piece, Direction d)
 {
     int newRotationID = (m_rotationID + (int)d) % 4;
 
@@ -183,8 +484,11 @@ Well::Piece Well::rotatePiece(Piece const& piece, Direction d)
     return p; // p will be empty if the spawn failed.
 }
 
-bool Well::rotatePiece(Direction d)
+template<typename Storage>
+bool BasicWell<Storage>::rotatePiece(Direction d)
 {
+    ALLOC_TAG(well);
+
     Piece p = rotatePiece(m_piece, d);
 
     if ( p.size() > 0 )
@@ -196,67 +500,86 @@ bool Well::rotatePiece(Direction d)
         return false;
 }
 
-void Well::removeRows(std::vector<unsigned int> const& a_rows)
+template<typename Storage>
+void BasicWell<Storage>::removeRows(std::vector<unsigned int> const& a_rows)
 {
+    ALLOC_TAG(well);
+
+    TRACE_SCOPE("Well::removeRows");
+
     if ( a_rows.size() == 0 )
         return;
 
-    for ( auto y : a_rows )
-    {
-        for ( unsigned int x = 0; x < m_wellWidth; x++ )
-        {
-            m_well[x][y] = false; // clear the row
-        }
-        for ( unsigned int y_ = y; y_ > 1; y_-- )
-        {
-            for ( unsigned int x = 0; x < m_wellWidth; x++ )
-                m_well[x][y_] = m_well[x][y_ - 1]; // shift down rows above the removed row
-        }
-        for ( unsigned int x = 0; x < m_wellWidth; x++ )
-        {
-            m_well[x][0] = false; // clear the top row.
-        }
-    }
-}
+    m_storage.removeRows(a_rows);
 
-// // // OBSERVERS // // //
+    m_fallenPieceMemo.clear();
+}
 
-std::vector<unsigned int> Well::getFullRows() const
+template<typename Storage>
+bool BasicWell<Storage>::insertGarbageRows(unsigned int a_count, unsigned int a_hole)
 {
-    std::vector<unsigned int> fullRows;
+    ALLOC_TAG(well);
 
-    for ( unsigned int y = 0; y < m_wellHeight; y++ )
+    if ( a_count == 0 )
+        return true;
+
+    bool kept = m_storage.insertRows(a_count, a_hole);
+
+    m_fallenPieceMemo.clear();
+
+    while ( wouldOverlap(m_piece) )
     {
-        bool full = true;
-        for ( unsigned int x = 0; x < m_wellWidth; x++ )
+        for ( auto &b : m_piece )
         {
-            if ( ! m_well[x][y] )
-            {
-                full = false;
-                break;
-            }
+            if ( b.location.second == 0 )
+                return false; // nowhere left to push it
         }
 
-        if ( full )
-            fullRows.push_back(y);
+        for ( auto &b : m_piece )
+            b.location.second--;
     }
 
-    return fullRows;
+    return kept;
+}
+
+template<typename Storage>
+void BasicWell<Storage>::restore(Storage const& a_storage, PieceState const& a_state)
+{
+    ALLOC_TAG(well);
+
+    m_storage = a_storage;
+
+    m_piece = a_state.piece;
+    m_pieceID = a_state.pieceID;
+    m_nextPieceID = a_state.nextPieceID;
+    m_rotationID = a_state.rotationID;
+    m_randomState = a_state.randomState;
+
+    m_fallenPieceMemo.clear();
 }
 
-Well::WellMatrix const& Well::getWell() const
+template<typename Storage>
+void BasicWell<Storage>::clear()
 {
-    return m_well;
+    ALLOC_TAG(well);
+
+    m_storage.clear();
+
+    m_fallenPieceMemo.clear();
 }
 
-Well::Piece const& Well::getPiece() const
+// // // OBSERVERS // // //
+
+template<typename Storage>
+typename BasicWell<Storage>::Piece const& BasicWell<Storage>::getPiece() const
 {
     return m_piece;
 }
 
-Well::Piece Well::getFallenPiece() 
+template<typename Storage>
+typename BasicWell<Storage>::Piece BasicWell<Storage>::getFallenPiece() 
 {
-    static Piece result;
+    ALLOC_TAG(well);
 
     if ( m_fallenPieceMemoID == m_pieceID && [] (Piece const& fallenPieceMemo, Piece const& piece) 
             {
@@ -271,7 +594,7 @@ Well::Piece Well::getFallenPiece()
                 return true;
             } (m_fallenPieceMemo, m_piece)
        )
-        return result;
+        return m_fallenPiece;
     else
     {
         Piece p(m_piece); // copy the current piece into a temporary;
@@ -279,47 +602,53 @@ Well::Piece Well::getFallenPiece()
 
         m_fallenPieceMemo = m_piece;
         m_fallenPieceMemoID = m_pieceID;
-        result = p;
+        m_fallenPiece = p;
         return p;
     }
 }
 
-bool Well::wouldOverlap(Piece const& p) const
+template<typename Storage>
+bool BasicWell<Storage>::wouldOverlap(Piece const& p) const
 {
     return std::any_of(p.begin(), p.end(), 
             [this] (Block b)
             {
-                return getBlock(b.location);
+                return m_storage.get(b.location.first, b.location.second);
             }
         );
 }
 
-unsigned int Well::getWellWidth() const
+template<typename Storage>
+unsigned int BasicWell<Storage>::getNextPieceID() const 
 {
-    return m_wellWidth;
+    return m_nextPieceID;
 }
 
-unsigned int Well::getWellHeight() const
+template<typename Storage>
+unsigned int BasicWell<Storage>::getPieceID() const
 {
-    return m_wellHeight;
+    return m_pieceID;
 }
 
-unsigned int Well::getNextPieceID() const 
+template<typename Storage>
+Storage const& BasicWell<Storage>::getStorage() const
 {
-    return m_nextPieceID;
+    return m_storage;
 }
 
-unsigned int Well::getPieceID() const
+template<typename Storage>
+typename BasicWell<Storage>::PieceState BasicWell<Storage>::getPieceState() const
 {
-    return m_pieceID;
+    return PieceState { m_piece, m_pieceID, m_nextPieceID, m_rotationID, m_randomState };
 }
 
-bool Well::getBlock(Point const& p) const
+template<typename Storage>
+unsigned int BasicWell<Storage>::randomPiece()
 {
-    return m_well[p.first][p.second];
+    m_randomState = std::uint64_t(m_randomState) * 48271 % 2147483647;
+    return m_randomState % 7;
 }
 
-void Well::setBlock(Point const& p, bool b) 
-{
-    m_well[p.first][p.second] = b;
-}
+template class BasicWell<DynamicRows>;
+template class BasicWell<FixedRows<10, 20>>;
+template class BasicWell<ChunkedRows>;
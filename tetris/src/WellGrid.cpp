@@ -0,0 +1,226 @@
+#include "WellGrid.h"
+#include "Log.h"
+
+#include <algorithm>
+
+WellGrid::WellGrid()
+    : m_blockSide(0), m_inset(0), m_squareSide(0), m_barWidth(0), m_emptyColor(0), m_squareColor(0), m_fallenColor(0),
+      m_pieceColor(0), m_clearedColor(0), m_garbageColor(0), m_rowsDrawn(0)
+{
+}
+
+void WellGrid::load(unsigned int a_boards, unsigned int a_width, unsigned int a_height, unsigned int a_maxBlockSide,
+                    unsigned int a_gap, SDL_PixelFormat const* a_screenFormat)
+{
+    a_boards = std::max(a_boards, 1u);
+
+    // A board is its well and half a block to its left for the garbage bar.
+    unsigned int columns = 1;
+    m_blockSide = 0;
+
+    for ( unsigned int c = 1; c <= a_boards; c++ )
+    {
+        unsigned int rows = (a_boards + c - 1) / c;
+
+        int across = ((int)a_width - (int)((c - 1) * a_gap)) * 2 / (int)(c * (2 * Rows::width + 1));
+        int down = ((int)a_height - (int)((rows - 1) * a_gap)) / (int)(rows * Rows::height);
+        unsigned int side = std::max(0, std::min(across, down));
+
+        if ( side > m_blockSide )
+        {
+            m_blockSide = side;
+            columns = c;
+        }
+    }
+
+    m_blockSide = std::clamp(m_blockSide, 1u, a_maxBlockSide);
+
+    // Each empty cell has a square in its middle, half its side, as in Game.
+    m_inset = m_blockSide / 4;
+    m_squareSide = std::max(1u, m_blockSide / 2);
+    m_barWidth = std::max(1u, m_blockSide / 4);
+
+    unsigned int barSpace = std::max(m_barWidth, m_blockSide / 2);
+    unsigned int boardWidth = barSpace + Rows::width * m_blockSide, boardHeight = Rows::height * m_blockSide;
+    unsigned int rows = (a_boards + columns - 1) / columns;
+
+    bool screenLayout = a_screenFormat->BitsPerPixel == 32;
+    m_surface = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_SWSURFACE, columns * (boardWidth + a_gap) - a_gap,
+                rows * (boardHeight + a_gap) - a_gap, 32, screenLayout ? a_screenFormat->Rmask : 0,
+                screenLayout ? a_screenFormat->Gmask : 0, screenLayout ? a_screenFormat->Bmask : 0, 0));
+
+    SDL_PixelFormat const* format = m_surface->format;
+
+    // The same colors as Game's.
+    m_emptyColor   = SDL_MapRGB(format, 0, 0, 0);
+    m_squareColor  = SDL_MapRGB(format, 128, 128, 128);
+    m_fallenColor  = SDL_MapRGB(format, 64, 64, 255);
+    m_pieceColor   = SDL_MapRGB(format, 255, 64, 64);
+    m_clearedColor = SDL_MapRGB(format, 255, 255, 255);
+    m_garbageColor = SDL_MapRGB(format, 255, 128, 0);
+
+    m_edgeLine.assign(Rows::width * m_blockSide, m_emptyColor);
+    m_middleLine.assign(Rows::width * m_blockSide, m_emptyColor);
+
+    SDL_FillRect(m_surface.get(), nullptr, m_emptyColor);
+
+    m_boards.assign(a_boards, Board());
+
+    if ( SDL_MUSTLOCK(m_surface.get()) && SDL_LockSurface(m_surface.get()) != 0 )
+        LOG_ERROR("Failed to lock the grid surface: %s", SDL_GetError());
+
+    const RowLook empty { 0, 0, false };
+
+    for ( unsigned int i = 0; i < a_boards; i++ )
+    {
+        Board & board = m_boards[i];
+
+        board.x = (i % columns) * (boardWidth + a_gap) + barSpace;
+        board.y = (i / columns) * (boardHeight + a_gap);
+        board.pending = 0;
+
+        for ( unsigned int y = 0; y < Rows::height; y++ )
+        {
+            board.rows[y] = empty;
+            drawRow(board, y, empty);
+        }
+    }
+
+    if ( SDL_MUSTLOCK(m_surface.get()) )
+        SDL_UnlockSurface(m_surface.get());
+
+    m_rowsDrawn = 0;
+}
+
+bool WellGrid::update(unsigned int a_board, Simulation const& a_simulation)
+{
+    Board & board = m_boards[a_board];
+    StandardWell const& well = a_simulation.getWell();
+
+    RowLook looks[Rows::height];
+
+    for ( unsigned int y = 0; y < Rows::height; y++ )
+        looks[y] = RowLook { well.getStorage().getRow(y), 0, false };
+
+    for ( auto const& block : well.getPiece() )
+        looks[block.location.second].piece |= Rows::Row(1) << block.location.first;
+
+    for ( auto y : a_simulation.getClearingRows() )
+        looks[y].clearing = true;
+
+    unsigned int pending = std::min(a_simulation.getPendingGarbage(), Rows::height);
+
+    bool locked = false;
+
+    for ( unsigned int y = 0; y < Rows::height; y++ )
+    {
+        if ( looks[y] == board.rows[y] )
+            continue;
+
+        if ( ! locked )
+        {
+            locked = true;
+            if ( SDL_MUSTLOCK(m_surface.get()) && SDL_LockSurface(m_surface.get()) != 0 )
+                LOG_ERROR("Failed to lock the grid surface: %s", SDL_GetError());
+        }
+
+        drawRow(board, y, looks[y]);
+        board.rows[y] = looks[y];
+        m_rowsDrawn++;
+    }
+
+    if ( pending != board.pending )
+    {
+        if ( ! locked )
+        {
+            locked = true;
+            if ( SDL_MUSTLOCK(m_surface.get()) && SDL_LockSurface(m_surface.get()) != 0 )
+                LOG_ERROR("Failed to lock the grid surface: %s", SDL_GetError());
+        }
+
+        drawBar(board, pending);
+        board.pending = pending;
+    }
+
+    if ( locked && SDL_MUSTLOCK(m_surface.get()) )
+        SDL_UnlockSurface(m_surface.get());
+
+    return locked;
+}
+
+void WellGrid::draw(SDL_Surface *a_target, short a_x, short a_y) const
+{
+    SDL_Rect location { a_x, a_y, 0, 0 };
+
+    if ( blitSurface(m_surface.get(), nullptr, a_target, &location) != 0 )
+        LOG_ERROR("Failed to draw the grid of wells: %s", SDL_GetError());
+}
+
+void WellGrid::drawRow(Board const& a_board, unsigned int a_row, RowLook const& a_look)
+{
+    // The two scanlines of the row: through the empty cells' squares, and above and below them.
+    for ( unsigned int x = 0; x < Rows::width; x++ )
+    {
+        Uint32 *edge = &m_edgeLine[x * m_blockSide], *middle = &m_middleLine[x * m_blockSide];
+
+        Uint32 color = a_look.clearing ? m_clearedColor
+                     : (a_look.piece >> x) & 1 ? m_pieceColor
+                     : (a_look.fallen >> x) & 1 ? m_fallenColor
+                     : m_emptyColor;
+
+        std::fill(edge, edge + m_blockSide, color);
+        std::fill(middle, middle + m_blockSide, color);
+
+        if ( color == m_emptyColor )
+            std::fill(middle + m_inset, middle + std::min(m_inset + m_squareSide, m_blockSide), m_squareColor);
+    }
+
+    unsigned int top = a_board.y + a_row * m_blockSide;
+    std::size_t bytes = m_edgeLine.size() * sizeof(Uint32);
+
+    for ( unsigned int line = 0; line < m_blockSide; line++ )
+    {
+        bool middle = line >= m_inset && line < m_inset + m_squareSide;
+        std::copy_n((middle ? m_middleLine : m_edgeLine).data(), bytes / sizeof(Uint32), pixelRow(top + line) + a_board.x);
+    }
+}
+
+void WellGrid::drawBar(Board const& a_board, unsigned int a_pending)
+{
+    // From the bottom up, in the space left of the well, a block's width off it.
+    unsigned int x = a_board.x - std::max(m_barWidth, m_blockSide / 2), split = Rows::height - a_pending;
+
+    for ( unsigned int line = 0; line < Rows::height * m_blockSide; line++ )
+        fillPixels(x, a_board.y + line, m_barWidth, line >= split * m_blockSide ? m_garbageColor : m_emptyColor);
+}
+
+void WellGrid::fillPixels(unsigned int a_x, unsigned int a_y, unsigned int a_count, Uint32 a_color)
+{
+    Uint32 *row = pixelRow(a_y) + a_x;
+    std::fill(row, row + a_count, a_color);
+}
+
+Uint32 * WellGrid::pixelRow(unsigned int a_y)
+{
+    return (Uint32 *)((Uint8 *)m_surface->pixels + a_y * m_surface->pitch);
+}
+
+unsigned int WellGrid::getBlockSide() const
+{
+    return m_blockSide;
+}
+
+unsigned int WellGrid::getWidth() const
+{
+    return m_surface->w;
+}
+
+unsigned int WellGrid::getHeight() const
+{
+    return m_surface->h;
+}
+
+std::uint64_t WellGrid::getRowsDrawn() const
+{
+    return m_rowsDrawn;
+}
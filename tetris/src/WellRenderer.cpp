@@ -0,0 +1,100 @@
+#include "WellRenderer.h"
+#include "Application.h"
+#include "Log.h"
+
+WellRenderer::WellRenderer()
+    : m_blockSide(0), m_fallenColor(0), m_pieceColor(0), m_ghostColor(0), m_clearedColor(0), m_garbageColor(0)
+{
+}
+
+void WellRenderer::load(unsigned int a_blockSide, SDL_PixelFormat const* a_format)
+{
+    m_blockSide = a_blockSide;
+
+    // The same colors as Game's.
+    m_fallenColor  = SDL_MapRGB(a_format, 64, 64, 255);
+    m_pieceColor   = SDL_MapRGB(a_format, 255, 64, 64);
+    m_ghostColor   = SDL_MapRGB(a_format, 64, 255, 64);
+    m_clearedColor = SDL_MapRGB(a_format, 255, 255, 255);
+    m_garbageColor = SDL_MapRGB(a_format, 255, 128, 0);
+
+    // Each free cell has a grey square in its middle, half its side.
+    m_background = makeSafeSurfacePtr(SDL_CreateRGBSurface(SDL_SWSURFACE, getWidth(), getHeight(),
+                Application::screenDepth, 0, 0, 0, 0));
+
+    Uint32 grey = SDL_MapRGB(a_format, 128, 128, 128);
+    short inset = m_blockSide / 4, side = std::max(1u, m_blockSide / 2);
+
+    for ( unsigned int x = 0; x < StandardWell::StorageType::width; x++ )
+    {
+        for ( unsigned int y = 0; y < StandardWell::StorageType::height; y++ )
+        {
+            SDL_Rect square { (short)(x * m_blockSide + inset), (short)(y * m_blockSide + inset), (Uint16)side, (Uint16)side };
+            SDL_FillRect(m_background.get(), &square, grey);
+        }
+    }
+}
+
+void WellRenderer::draw(Simulation & a_simulation, SDL_Surface *a_target, short a_x, short a_y, bool a_ghost) const
+{
+    SDL_Rect location { a_x, a_y, 0, 0 };
+
+    if ( blitSurface(m_background.get(), nullptr, a_target, &location) != 0 )
+        LOG_ERROR("Failed to draw the well background: %s", SDL_GetError());
+
+    StandardWell & well = a_simulation.getWell();
+
+    well.forEachOccupiedRow(0, well.getWellHeight(), [&] (unsigned int y)
+            {
+                for ( unsigned int x = 0; x < well.getWellWidth(); x++ )
+                    if ( well.isOccupied(x, y) )
+                        fillCell(a_target, a_x, a_y, x, y, m_fallenColor);
+            });
+
+    if ( a_ghost && a_simulation.isFalling() )
+        for ( auto const& block : well.getFallenPiece() )
+            fillCell(a_target, a_x, a_y, block.location.first, block.location.second, m_ghostColor);
+
+    for ( auto const& block : well.getPiece() )
+        fillCell(a_target, a_x, a_y, block.location.first, block.location.second, m_pieceColor);
+
+    for ( auto y : a_simulation.getClearingRows() )
+    {
+        SDL_Rect row { a_x, (short)(a_y + y * m_blockSide), (Uint16)getWidth(), (Uint16)m_blockSide };
+        SDL_FillRect(a_target, &row, m_clearedColor);
+    }
+
+    // Garbage on its way, from the bottom up, in the gap left of the well.
+    unsigned int pending = std::min(a_simulation.getPendingGarbage(), well.getWellHeight());
+    if ( pending > 0 )
+    {
+        Uint16 width = std::max(1u, m_blockSide / 4);
+        SDL_Rect bar { (short)(a_x - 2 * width), (short)(a_y + (well.getWellHeight() - pending) * m_blockSide),
+                       width, (Uint16)(pending * m_blockSide) };
+        SDL_FillRect(a_target, &bar, m_garbageColor);
+    }
+}
+
+void WellRenderer::fillCell(SDL_Surface *a_target, short a_x, short a_y, unsigned int a_column, unsigned int a_row, Uint32 a_color) const
+{
+    SDL_Rect cell { (short)(a_x + a_column * m_blockSide), (short)(a_y + a_row * m_blockSide),
+                    (Uint16)m_blockSide, (Uint16)m_blockSide };
+
+    if ( SDL_FillRect(a_target, &cell, a_color) != 0 )
+        LOG_ERROR("Failed to draw a block: %s", SDL_GetError());
+}
+
+unsigned int WellRenderer::getBlockSide() const
+{
+    return m_blockSide;
+}
+
+unsigned int WellRenderer::getWidth() const
+{
+    return StandardWell::StorageType::width * m_blockSide;
+}
+
+unsigned int WellRenderer::getHeight() const
+{
+    return StandardWell::StorageType::height * m_blockSide;
+}
@@ -1,8 +1,162 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
 #include "Application.h"
+#include "Replay.h"
+
+// Plays a replay without SDL, as fast as possible, and prints how the game ended.
+// Starts from a_startTick, as found through the replay's keyframes.
+static int playHeadless(char const* a_path, std::uint64_t a_startTick)
+{
+    auto replay = std::make_shared<Replay>();
+
+    if ( ! replay->load(a_path) )
+    {
+        std::cerr << "Failed to read the replay " << a_path << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ReplayPlayer player(std::move(replay));
+    Simulation simulation = player.makeSimulation();
+
+    auto start = std::chrono::steady_clock::now();
+
+    if ( a_startTick > 0 )
+    {
+        player.seek(simulation, a_startTick);
+        frameArena().reset();
+
+        std::printf("seeked to tick %llu in %.3f ms\n", (unsigned long long)simulation.getTicks(),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::uint64_t firstTick = simulation.getTicks();
+    start = std::chrono::steady_clock::now();
+
+    while ( player.step(simulation) )
+        frameArena().reset();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%s: %llu ticks, score %u, lines %u, level %u%s\n", a_path,
+            (unsigned long long)simulation.getTicks(), simulation.getScore(), simulation.getClearedLines(),
+            simulation.getLevel(), simulation.isOver() ? ", game over" : "");
+    std::printf("played in %.3f ms, %.0f ticks/s\n", seconds * 1000, (simulation.getTicks() - firstTick) / (seconds > 0 ? seconds : 1e-9));
+
+    if ( player.hasDiverged() )
+    {
+        std::printf("DIVERGED: the first divergent tick is after tick %llu, and at or before tick %llu\n",
+                (unsigned long long)player.getLastVerifiedTick(), (unsigned long long)player.getDivergedTick());
+        return EXIT_FAILURE;
+    }
+
+    if ( ! player.matchesResults(simulation) )
+    {
+        Replay::Results const& results = player.getReplay().getResults();
+
+        std::printf("MISMATCH: the recorded game ended after %llu ticks, score %u, lines %u, level %u\n",
+                (unsigned long long)player.getReplay().getLength(), results.score, results.clearedLines, results.level);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("%lu checksums verified\n", player.getVerifiedCount());
+
+    return EXIT_SUCCESS;
+}
 
 int main(int argc, char **argv)
 {
     Application app;
 
+    char const* replayPath = nullptr;
+    double replaySpeed = 1;
+    std::uint64_t replayStart = 0;
+    bool headless = false;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        // --perf-stats prints input latency and frame time statistics to stderr on exit,
+        // --perf-stats=<file> writes them to a file instead.
+        if ( std::strcmp(argv[i], "--perf-stats") == 0 )
+            app.getInstrumentation().setReportPath("-");
+        else if ( std::strncmp(argv[i], "--perf-stats=", 13) == 0 )
+            app.getInstrumentation().setReportPath(argv[i] + 13);
+        // --trace=<file> sets where the trace goes in builds made with `make TRACE=1`.
+        else if ( std::strncmp(argv[i], "--trace=", 8) == 0 )
+            trace::setOutputPath(argv[i] + 8);
+        // --startup-profile prints how long each phase of startup took, up to the first frame.
+        else if ( std::strcmp(argv[i], "--startup-profile") == 0 )
+            app.getStartupProfile().setEnabled(true);
+        // --resources=<file> reads resources from an archive made by `make resources.pak`.
+        else if ( std::strncmp(argv[i], "--resources=", 12) == 0 )
+            app.setResourceArchive(argv[i] + 12);
+        // --replay=<file> plays a recorded game instead of showing the menu, --replay-speed=<x> at
+        // x times real time. --headless plays it without a window, as fast as possible.
+        else if ( std::strncmp(argv[i], "--replay=", 9) == 0 )
+            replayPath = argv[i] + 9;
+        else if ( std::strncmp(argv[i], "--replay-speed=", 15) == 0 )
+            replaySpeed = std::atof(argv[i] + 15);
+        // --seek=<tick> starts it from that tick.
+        else if ( std::strncmp(argv[i], "--seek=", 7) == 0 )
+            replayStart = std::strtoull(argv[i] + 7, nullptr, 10);
+        else if ( std::strcmp(argv[i], "--headless") == 0 )
+            headless = true;
+        // --replay-dir=<dir> sets where games are recorded, --no-record turns recording off.
+        else if ( std::strncmp(argv[i], "--replay-dir=", 13) == 0 )
+            app.setReplayDirectory(argv[i] + 13);
+        else if ( std::strcmp(argv[i], "--no-record") == 0 )
+            app.setReplayDirectory("");
+        // --checksum-interval=<ticks> sets how often recordings carry a checksum, 1 to find the
+        // exact tick a replay diverges at, 0 for none.
+        else if ( std::strncmp(argv[i], "--checksum-interval=", 20) == 0 )
+            app.setChecksumInterval(std::strtoul(argv[i] + 20, nullptr, 10));
+        // --versus-boards=<n> sets how many boards a versus match has, 2 to 64.
+        else if ( std::strncmp(argv[i], "--versus-boards=", 16) == 0 )
+            app.setVersusBoards(std::strtoul(argv[i] + 16, nullptr, 10));
+        // --spectate=<n> starts with bots playing each other on n boards, 2 to 64, to watch.
+        else if ( std::strncmp(argv[i], "--spectate=", 11) == 0 )
+            app.spectate(std::strtoul(argv[i] + 11, nullptr, 10));
+        // --highscores=<file> sets where finished games are kept and ranked, an empty file keeps
+        // them for this run only.
+        else if ( std::strncmp(argv[i], "--highscores=", 13) == 0 )
+            app.getHighScores().setPath(argv[i] + 13);
+        // --telemetry=<file> writes what happens in each game played to a file, for analysis.
+        else if ( std::strncmp(argv[i], "--telemetry=", 12) == 0 )
+        {
+            if ( ! app.setTelemetryPath(argv[i] + 12) )
+                std::cerr << "Failed to open " << argv[i] + 12 << " for telemetry" << std::endl;
+        }
+        else
+            std::cerr << "Ignoring unknown argument " << argv[i] << std::endl;
+    }
+
+    if ( headless )
+    {
+        if ( replayPath == nullptr )
+        {
+            std::cerr << "--headless needs a --replay=<file> to play" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        return playHeadless(replayPath, replayStart);
+    }
+
+    if ( replayPath != nullptr )
+    {
+        if ( replaySpeed <= 0 )
+        {
+            std::cerr << "The replay speed must be positive" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if ( ! app.playReplay(replayPath, replaySpeed, replayStart) )
+        {
+            std::cerr << "Failed to read the replay " << replayPath << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
     return app.run();
 }
@@ -1,5 +1,9 @@
 #include "util_SDL.h"
 
+#include <atomic>
+
+static std::atomic<unsigned long> blitCount(0);
+
 Surface_ptr makeSafeSurfacePtr(SDL_Surface *surface)
 {
     return Surface_ptr { surface, SDL_SurfaceDeleter() };
@@ -31,3 +35,13 @@ Rect_ptr makeSafeRectPtr(short x, short y, unsigned short w, unsigned short h)
     return Rect_ptr { new SDL_Rect { x, y, w, h } };
 }
 
+int blitSurface(SDL_Surface *src, SDL_Rect *srcRect, SDL_Surface *dst, SDL_Rect *dstRect)
+{
+    blitCount.fetch_add(1, std::memory_order_relaxed);
+    return SDL_BlitSurface(src, srcRect, dst, dstRect);
+}
+
+unsigned long getBlitCount()
+{
+    return blitCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,97 @@
+// Packs resource files into the archive format read by ResourceArchive.
+//
+//     pack <out.pak> <file>...        writes an archive file
+//     pack --cpp <out.cpp> <file>...  writes a C++ source defining embeddedArchive
+//
+// Files are stored under the paths given on the command line.
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "ResourceArchive.h"
+
+static void putU32(std::vector<unsigned char> & out, std::uint32_t v)
+{
+    for ( int i = 0; i < 4; i++ )
+        out.push_back((v >> (8 * i)) & 0xff);
+}
+
+int main(int argc, char **argv)
+{
+    bool cpp = argc > 1 && std::string(argv[1]) == "--cpp";
+    int first = cpp ? 2 : 1;
+
+    if ( argc < first + 2 )
+    {
+        std::cerr << "usage: " << argv[0] << " [--cpp] <output> <file>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> names(argv + first + 1, argv + argc);
+    std::vector<std::vector<unsigned char>> contents;
+
+    for ( auto &name : names )
+    {
+        std::ifstream in(name, std::ios::binary);
+        if ( ! in )
+        {
+            std::cerr << "Cannot read " << name << std::endl;
+            return EXIT_FAILURE;
+        }
+        contents.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    std::size_t tableSize = 12;
+    for ( auto &name : names )
+        tableSize += 2 + name.size() + 8;
+
+    std::vector<unsigned char> archive { 'T', 'P', 'A', 'K' };
+    putU32(archive, ResourceArchive::version);
+    putU32(archive, names.size());
+
+    std::size_t offset = tableSize;
+    for ( unsigned int i = 0; i < names.size(); i++ )
+    {
+        archive.push_back(names[i].size() & 0xff);
+        archive.push_back(names[i].size() >> 8);
+        archive.insert(archive.end(), names[i].begin(), names[i].end());
+        putU32(archive, offset);
+        putU32(archive, contents[i].size());
+        offset += contents[i].size();
+    }
+
+    for ( auto &c : contents )
+        archive.insert(archive.end(), c.begin(), c.end());
+
+    std::ofstream out(argv[first], std::ios::binary);
+
+    if ( cpp )
+    {
+        out << "// Generated by tools/pack.cpp. Do not edit.\n"
+            << "#include <cstddef>\n\n"
+            << "extern const unsigned char embeddedArchive[];\n"
+            << "extern const std::size_t embeddedArchiveSize;\n\n"
+            << "const std::size_t embeddedArchiveSize = " << archive.size() << ";\n"
+            << "const unsigned char embeddedArchive[] =\n{";
+
+        for ( std::size_t i = 0; i < archive.size(); i++ )
+            out << (i % 16 == 0 ? "\n    " : " ") << (unsigned int)archive[i] << ",";
+
+        out << "\n};\n";
+    }
+    else
+        out.write((const char*)archive.data(), archive.size());
+
+    if ( ! out )
+    {
+        std::cerr << "Cannot write " << argv[first] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+// Plays every replay in a directory again, on all cores, and checks that each still plays out the
+// way it was recorded: the checksums along the way, and the final score, lines, level and
+// checksum. Meant to be run over a corpus of recorded games after any change to the rules or the
+// well.
+//
+//     replayfarm <directory> [threads]
+//
+// Replays are found recursively, by the .trpl extension. Each worker thread takes the next
+// replay from a shared counter, so long and short games even out. Prints every replay that does
+// not match, then the totals and throughput; exits with a failure status if any did not match.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameArena.h"
+#include "Replay.h"
+
+typedef std::chrono::steady_clock Clock;
+
+struct Outcome
+{
+    enum class Status { ok, unreadable, diverged, mismatched };
+
+    Status status = Status::ok;
+    std::uint64_t ticks = 0;
+    unsigned long checksums = 0;
+
+    // For diverged replays: the first divergent tick is after the first and at or before the second.
+    std::uint64_t lastVerifiedTick = 0, divergedTick = 0;
+
+    unsigned int score = 0, clearedLines = 0, level = 0;
+    std::uint32_t checksum = 0;
+};
+
+static Outcome verify(std::string const& a_path)
+{
+    Outcome outcome;
+    auto replay = std::make_shared<Replay>();
+
+    if ( ! replay->load(a_path) )
+    {
+        outcome.status = Outcome::Status::unreadable;
+        return outcome;
+    }
+
+    ReplayPlayer player(replay);
+    Simulation simulation = player.makeSimulation();
+
+    // Stopping at the first divergence: nothing after it says anything more.
+    while ( ! player.hasDiverged() && player.step(simulation) )
+        frameArena().reset();
+
+    outcome.ticks = simulation.getTicks();
+    outcome.checksums = player.getVerifiedCount();
+    outcome.score = simulation.getScore();
+    outcome.clearedLines = simulation.getClearedLines();
+    outcome.level = simulation.getLevel();
+    outcome.checksum = simulation.getChecksum();
+
+    if ( player.hasDiverged() )
+    {
+        outcome.status = Outcome::Status::diverged;
+        outcome.lastVerifiedTick = player.getLastVerifiedTick();
+        outcome.divergedTick = player.getDivergedTick();
+    }
+    else if ( ! player.matchesResults(simulation) )
+        outcome.status = Outcome::Status::mismatched;
+
+    return outcome;
+}
+
+static void report(std::string const& a_path, Outcome const& a_outcome)
+{
+    switch ( a_outcome.status )
+    {
+        case Outcome::Status::ok:
+            break;
+        case Outcome::Status::unreadable:
+            std::printf("%s: unreadable\n", a_path.c_str());
+            break;
+        case Outcome::Status::diverged:
+            std::printf("%s: diverged after tick %llu, at or before tick %llu\n", a_path.c_str(),
+                    (unsigned long long)a_outcome.lastVerifiedTick, (unsigned long long)a_outcome.divergedTick);
+            break;
+        case Outcome::Status::mismatched:
+        {
+            Replay replay;
+            replay.load(a_path);
+            Replay::Results const& expected = replay.getResults();
+
+            std::printf("%s: ended after %llu ticks with score %u, lines %u, level %u, checksum %08x; "
+                        "recorded %llu ticks, score %u, lines %u, level %u, checksum %08x\n",
+                    a_path.c_str(), (unsigned long long)a_outcome.ticks, a_outcome.score, a_outcome.clearedLines,
+                    a_outcome.level, (unsigned int)a_outcome.checksum, (unsigned long long)replay.getLength(),
+                    expected.score, expected.clearedLines, expected.level, (unsigned int)expected.checksum);
+            break;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if ( argc < 2 )
+    {
+        std::fprintf(stderr, "usage: %s <directory> [threads]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    unsigned int threads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    if ( threads == 0 )
+        threads = 1;
+
+    std::vector<std::string> paths;
+    std::error_code error;
+
+    for ( std::filesystem::recursive_directory_iterator it(argv[1], error), end; ! error && it != end; it.increment(error) )
+        if ( it->is_regular_file() && it->path().extension() == ".trpl" )
+            paths.push_back(it->path().string());
+
+    if ( error )
+    {
+        std::fprintf(stderr, "Failed to read the directory %s: %s\n", argv[1], error.message().c_str());
+        return EXIT_FAILURE;
+    }
+
+    // Sorted, so that mismatches are reported in the same order on every run.
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<Outcome> outcomes(paths.size());
+    std::atomic<std::size_t> next(0);
+
+    Clock::time_point start = Clock::now();
+
+    std::vector<std::thread> workers;
+    for ( unsigned int i = 0; i < std::min<std::size_t>(threads, std::max<std::size_t>(paths.size(), 1)); i++ )
+        workers.emplace_back([&] ()
+                {
+                    for ( std::size_t n; (n = next.fetch_add(1, std::memory_order_relaxed)) < paths.size(); )
+                        outcomes[n] = verify(paths[n]);
+                });
+
+    for ( std::thread & worker : workers )
+        worker.join();
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::uint64_t ticks = 0;
+    unsigned long checksums = 0, failures = 0;
+
+    for ( std::size_t i = 0; i < paths.size(); i++ )
+    {
+        report(paths[i], outcomes[i]);
+
+        ticks += outcomes[i].ticks;
+        checksums += outcomes[i].checksums;
+        failures += outcomes[i].status != Outcome::Status::ok;
+    }
+
+    std::printf("%zu replays, %lu did not match; %llu ticks, %lu checksums verified\n",
+            paths.size(), failures, (unsigned long long)ticks, checksums);
+    std::printf("%.3f s on %zu threads: %.0f replays/s, %.0f ticks/s\n", seconds, workers.size(),
+            paths.size() / (seconds > 0 ? seconds : 1e-9), ticks / (seconds > 0 ? seconds : 1e-9));
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
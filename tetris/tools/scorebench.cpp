@@ -0,0 +1,98 @@
+// Measures the high score table at sizes up to millions of games: loading the file and building
+// the index, then rank queries, top-k queries and adds.
+//
+//     scorebench [file]
+//
+// The file is overwritten at each size, and removed at the end.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "HighScores.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double since(Clock::time_point a_start)
+{
+    return std::chrono::duration<double>(Clock::now() - a_start).count();
+}
+
+// Writes a_count random records straight to a_path, in the file's layout.
+static bool makeFile(char const* a_path, std::size_t a_count, std::mt19937 & a_random)
+{
+    std::vector<unsigned char> bytes(HighScores::headerSize + a_count * HighScores::recordSize);
+
+    unsigned char header[HighScores::headerSize] = { 'T', 'H', 'S', 'C', HighScores::version, 0, 0, 0,
+                                                      HighScores::recordSize, 0, 0, 0, 0, 0, 0, 0 };
+    std::copy(header, header + sizeof(header), bytes.begin());
+
+    // Scores are sums of row clears, so they are all multiples of 100, and many are equal.
+    for ( std::size_t i = 0; i < a_count; i++ )
+        HighScores::encode(HighScores::Entry { (unsigned int)(a_random() % 100000) * 100, 10, 2, (std::int64_t)i },
+                &bytes[HighScores::headerSize + i * HighScores::recordSize]);
+
+    std::FILE *file = std::fopen(a_path, "wb");
+    if ( file == nullptr )
+        return false;
+
+    bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return std::fclose(file) == 0 && written;
+}
+
+int main(int argc, char **argv)
+{
+    char const* path = argc > 1 ? argv[1] : "scorebench.dat";
+    std::mt19937 random(42);
+
+    std::printf("%10s %10s %12s %12s %12s\n", "entries", "load ms", "rank ns", "top-10 ns", "add us");
+
+    for ( std::size_t count : { 1000, 100000, 1000000, 5000000 } )
+    {
+        if ( ! makeFile(path, count, random) )
+        {
+            std::fprintf(stderr, "Failed to write %s\n", path);
+            return EXIT_FAILURE;
+        }
+
+        HighScores scores;
+        scores.setPath(path);
+
+        Clock::time_point start = Clock::now();
+        scores.load();
+        double load = since(start);
+
+        const unsigned int queries = 100000;
+        unsigned long sink = 0;
+
+        start = Clock::now();
+        for ( unsigned int i = 0; i < queries; i++ )
+            sink += scores.getRank(random() % 10000000);
+        double rank = since(start) / queries;
+
+        std::vector<HighScores::Entry> top;
+        start = Clock::now();
+        for ( unsigned int i = 0; i < queries; i++ )
+        {
+            scores.getTop(10, top);
+            sink += top.size();
+        }
+        double topTen = since(start) / queries;
+
+        const unsigned int adds = 20;
+        start = Clock::now();
+        for ( unsigned int i = 0; i < adds; i++ )
+            sink += scores.add(HighScores::Entry { (unsigned int)(random() % 100000) * 100, 10, 2, 0 });
+        scores.flush(); // including the writes, which happen in the background
+        double add = since(start) / adds;
+
+        std::printf("%10zu %10.1f %12.0f %12.0f %12.0f   (%lu)\n", scores.getCount(), load * 1e3, rank * 1e9,
+                topTen * 1e9, add * 1e6, sink % 10);
+    }
+
+    std::remove(path);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+// Prints the events in a telemetry file, written by the game with --telemetry=<file>, one per
+// line, followed by a count of each type.
+//
+//     telemetrydump <file>
+//
+// Exits with a failure status if the file is not a telemetry file or ends in the middle of a
+// block; everything before that is still printed.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Telemetry.h"
+
+static const char *const typeNames[] =
+{
+    "game started", "piece spawned", "piece moved", "piece rotated",
+    "piece locked", "rows cleared", "level up", "game over",
+};
+
+static_assert(sizeof(typeNames) / sizeof(*typeNames) == (std::size_t)TelemetryEvent::Type::count,
+        "every event type needs a name");
+
+static bool getVarint(unsigned char const*& a_in, unsigned char const* a_end, std::uint64_t & a_value)
+{
+    a_value = 0;
+
+    for ( unsigned int shift = 0; a_in < a_end && shift < 64; shift += 7 )
+    {
+        unsigned char byte = *a_in++;
+        a_value |= std::uint64_t(byte & 0x7f) << shift;
+        if ( (byte & 0x80) == 0 )
+            return true;
+    }
+
+    return false;
+}
+
+static std::uint32_t getFixed32(unsigned char const* a_in)
+{
+    return a_in[0] | (a_in[1] << 8) | (a_in[2] << 16) | (std::uint32_t(a_in[3]) << 24);
+}
+
+// Prints the events in the block of a_count events in [a_in, a_end), and counts them by type.
+static bool dumpBlock(unsigned char const* a_in, unsigned char const* a_end, std::uint32_t a_count,
+        unsigned long (& a_counts)[(std::size_t)TelemetryEvent::Type::count])
+{
+    if ( (std::size_t)(a_end - a_in) < a_count )
+        return false;
+
+    unsigned char const* types = a_in;
+    std::vector<std::uint64_t> ticks(a_count), as(a_count), bs(a_count);
+
+    a_in += a_count;
+    for ( std::vector<std::uint64_t> * column : { &ticks, &as, &bs } )
+        for ( std::uint64_t & value : *column )
+            if ( ! getVarint(a_in, a_end, value) )
+                return false;
+
+    std::uint64_t tick = 0;
+    for ( std::uint32_t i = 0; i < a_count; i++ )
+    {
+        if ( types[i] >= (std::size_t)TelemetryEvent::Type::count )
+            return false;
+
+        tick += (ticks[i] >> 1) ^ -(ticks[i] & 1); // zigzagged
+        a_counts[types[i]]++;
+        std::printf("%10llu  %-14s %llu %llu\n", (unsigned long long)tick, typeNames[types[i]],
+                (unsigned long long)as[i], (unsigned long long)bs[i]);
+    }
+
+    return a_in == a_end;
+}
+
+int main(int argc, char **argv)
+{
+    if ( argc < 2 )
+    {
+        std::fprintf(stderr, "usage: %s <file>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::FILE *file = std::fopen(argv[1], "rb");
+    if ( file == nullptr )
+    {
+        std::fprintf(stderr, "Failed to open %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<unsigned char> data;
+    unsigned char buffer[65536];
+    for ( std::size_t read; (read = std::fread(buffer, 1, sizeof(buffer), file)) > 0; )
+        data.insert(data.end(), buffer, buffer + read);
+    std::fclose(file);
+
+    if ( data.size() < 5 || std::memcmp(data.data(), "TTEL", 4) != 0 || data[4] != Telemetry::version )
+    {
+        std::fprintf(stderr, "%s is not a telemetry file of version %u\n", argv[1], (unsigned int)Telemetry::version);
+        return EXIT_FAILURE;
+    }
+
+    unsigned long counts[(std::size_t)TelemetryEvent::Type::count] = {};
+    unsigned long blocks = 0;
+    bool complete = true;
+
+    for ( std::size_t offset = 5; offset < data.size(); blocks++ )
+    {
+        if ( data.size() - offset < 8 || data.size() - offset - 8 < getFixed32(&data[offset + 4]) )
+        {
+            complete = false;
+            break;
+        }
+
+        std::uint32_t count = getFixed32(&data[offset]);
+        std::uint32_t size = getFixed32(&data[offset + 4]);
+
+        if ( ! dumpBlock(&data[offset + 8], &data[offset + 8] + size, count, counts) )
+        {
+            complete = false;
+            break;
+        }
+
+        offset += 8 + size;
+    }
+
+    std::printf("%lu blocks:", blocks);
+    for ( std::size_t type = 0; type < (std::size_t)TelemetryEvent::Type::count; type++ )
+        std::printf("%s %lu %s", type == 0 ? "" : ",", counts[type], typeNames[type]);
+    std::printf("\n");
+
+    if ( ! complete )
+    {
+        std::fprintf(stderr, "%s ends in the middle of a block\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+// Plays versus matches between bots, headlessly and on all cores, and reports how often each bot
+// won: a way to try out bot weights and the garbage rules against each other at thousands of
+// matches a minute.
+//
+//     tournament [matches] [boards] [threads]
+//
+// Every match has the same bots, one per board: the first plays with Bot::defaultWeights, the
+// others with those weights changed at random, the same on every run. Match n is played with
+// seed n, and ends as a draw or on score after maxTicks. Each worker thread takes the next match
+// from a shared counter.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Bot.h"
+#include "FrameArena.h"
+#include "Match.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static const std::uint64_t maxTicks = 60 * 60 * 5; // five minutes of play
+
+struct Outcome
+{
+    int winner = -1;
+    std::uint64_t ticks = 0;
+    unsigned int sent = 0; // garbage rows, by all the boards
+};
+
+static Outcome play(std::uint32_t a_seed, std::vector<Bot::Weights> const& a_weights)
+{
+    Match match(a_weights.size(), a_seed, 1, maxTicks);
+
+    std::vector<Bot> bots;
+    for ( Bot::Weights const& weights : a_weights )
+        bots.emplace_back(weights);
+
+    while ( ! match.isOver() )
+    {
+        for ( unsigned int i = 0; i < bots.size(); i++ )
+            bots[i].play(match.getBoard(i));
+
+        match.tick();
+        frameArena().reset();
+    }
+
+    Outcome outcome;
+    outcome.winner = match.getWinner();
+    outcome.ticks = match.getTicks();
+    for ( unsigned int i = 0; i < match.getBoardCount(); i++ )
+        outcome.sent += match.getSent(i);
+
+    return outcome;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int matches = argc > 1 ? std::atoi(argv[1]) : 1000;
+    unsigned int boards = argc > 2 ? std::atoi(argv[2]) : 2;
+    unsigned int threads = argc > 3 ? std::atoi(argv[3]) : std::thread::hardware_concurrency();
+
+    if ( boards < 2 || boards > Match::maxBoards )
+    {
+        std::fprintf(stderr, "A match has 2 to %u boards\n", Match::maxBoards);
+        return EXIT_FAILURE;
+    }
+    if ( threads == 0 )
+        threads = 1;
+
+    std::vector<Bot::Weights> weights(1, Bot::defaultWeights);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> scale(0.5, 1.5);
+
+    for ( unsigned int i = 1; i < boards; i++ )
+    {
+        Bot::Weights const& d = Bot::defaultWeights;
+        weights.push_back(Bot::Weights { d.height * scale(random), d.lines * scale(random),
+                                         d.holes * scale(random), d.bumpiness * scale(random) });
+    }
+
+    std::vector<Outcome> outcomes(matches);
+    std::atomic<unsigned int> next(0);
+
+    Clock::time_point start = Clock::now();
+
+    std::vector<std::thread> workers;
+    for ( unsigned int i = 0; i < std::min(threads, std::max(matches, 1u)); i++ )
+        workers.emplace_back([&] ()
+                {
+                    for ( unsigned int n; (n = next.fetch_add(1, std::memory_order_relaxed)) < matches; )
+                        outcomes[n] = play(n, weights);
+                });
+
+    for ( std::thread & worker : workers )
+        worker.join();
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<unsigned int> wins(boards, 0);
+    unsigned int draws = 0;
+    std::uint64_t ticks = 0, sent = 0;
+
+    for ( Outcome const& outcome : outcomes )
+    {
+        if ( outcome.winner < 0 )
+            draws++;
+        else
+            wins[outcome.winner]++;
+
+        ticks += outcome.ticks;
+        sent += outcome.sent;
+    }
+
+    std::printf("%4s %10s %10s %10s %10s %8s\n", "bot", "height", "lines", "holes", "bumpiness", "wins");
+    for ( unsigned int i = 0; i < boards; i++ )
+        std::printf("%4u %10.4f %10.4f %10.4f %10.4f %8u\n", i, weights[i].height, weights[i].lines,
+                weights[i].holes, weights[i].bumpiness, wins[i]);
+
+    std::printf("%u matches, %u draws; %.0f ticks and %.1f garbage rows a match\n", matches, draws,
+            matches > 0 ? (double)ticks / matches : 0.0, matches > 0 ? (double)sent / matches : 0.0);
+    std::printf("%.3f s on %zu threads: %.0f matches/min, %.0f board ticks/s\n", seconds, workers.size(),
+            matches * 60 / (seconds > 0 ? seconds : 1e-9), ticks * boards / (seconds > 0 ? seconds : 1e-9));
+
+    return EXIT_SUCCESS;
+}
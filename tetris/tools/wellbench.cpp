@@ -0,0 +1,117 @@
+// Measures the well's storage backends as the well grows, in operations per second.
+//
+//     wellbench [seconds per case]
+//
+// drops:  a piece is spawned, moved to a random column and dropped, and the full rows are found
+//         and removed, as in a game. The well is cleared when it fills up.
+// clears: the bottom rows are filled through the storage and then removed, the way a stress test
+//         would clear a board.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "Well.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// Runs a_op until a_seconds have passed, and returns how many times it ran per second.
+template<typename Op>
+static double measure(double a_seconds, Op && a_op)
+{
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(a_seconds));
+    unsigned long count = 0;
+
+    do
+    {
+        a_op();
+        count++;
+    }
+    while ( Clock::now() < end );
+
+    return count / std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template<typename Well>
+static double benchDrops(Well & a_well, double a_seconds)
+{
+    std::default_random_engine engine(1);
+    std::uniform_int_distribution<int> column(0, a_well.getWellWidth() - 1);
+
+    a_well.newPiece();
+
+    return measure(a_seconds, [&] ()
+            {
+                a_well.movePiece(column(engine) - (int)a_well.getWellWidth() / 2);
+                a_well.fall();
+                a_well.removeRows(a_well.getFullRows());
+
+                if ( ! a_well.newPiece() )
+                {
+                    a_well.clear();
+                    a_well.newPiece();
+                }
+            });
+}
+
+template<typename Storage>
+static double benchClears(Storage & a_storage, double a_seconds)
+{
+    const unsigned int rows = 4;
+    std::vector<unsigned int> fullRows;
+
+    return measure(a_seconds, [&] ()
+            {
+                for ( unsigned int y = a_storage.getHeight() - rows; y < a_storage.getHeight(); y++ )
+                    for ( unsigned int x = 0; x < a_storage.getWidth(); x++ )
+                        a_storage.set(x, y, true);
+
+                fullRows.clear();
+                a_storage.forEachFullRow([&fullRows] (unsigned int y) { fullRows.push_back(y); });
+                a_storage.removeRows(fullRows);
+            });
+}
+
+static void report(char const* a_storage, unsigned int a_width, unsigned int a_height, char const* a_op, double a_rate)
+{
+    std::printf("%-8s %6u x %-8u %-7s %14.0f ops/s\n", a_storage, a_width, a_height, a_op, a_rate);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? std::atof(argv[1]) : 0.25;
+
+    struct Size { unsigned int width, height; };
+    const Size sizes[] = { { 10, 20 }, { 64, 1000 }, { 256, 10000 }, { 256, 100000 }, { 256, 1000000 } };
+
+    for ( Size size : sizes )
+    {
+        {
+            Well well(size.width, size.height);
+            report("dynamic", size.width, size.height, "drops", benchDrops(well, seconds));
+
+            DynamicRows storage(size.width, size.height);
+            report("dynamic", size.width, size.height, "clears", benchClears(storage, seconds));
+        }
+        {
+            HugeWell well(size.width, size.height);
+            report("chunked", size.width, size.height, "drops", benchDrops(well, seconds));
+
+            ChunkedRows storage(size.width, size.height);
+            report("chunked", size.width, size.height, "clears", benchClears(storage, seconds));
+        }
+    }
+
+    {
+        StandardWell well;
+        report("fixed", 10, 20, "drops", benchDrops(well, seconds));
+
+        FixedRows<10, 20> storage;
+        report("fixed", 10, 20, "clears", benchClears(storage, seconds));
+    }
+
+    return 0;
+}